@@ -30,7 +30,7 @@ int main() {
     }
 
     // Process the block
-    analyser.processBlock(buffer, blockSize);
+    analyser.process(buffer, blockSize);
 
     // Print results
     std::cout << "Cortix Spectrum Analysis\n";
@@ -40,10 +40,10 @@ int main() {
     std::cout << "----\t---------\t--------------\n";
 
     float magnitudesDb[40];
-    analyser.getMagnitudesDb(magnitudesDb);
+    analyser.envelopeDb(magnitudesDb);
 
-    for (int i = 0; i < analyser.getNumBands(); i++) {
-        float centerHz = analyser.getCenterHz(i);
+    for (int i = 0; i < analyser.numBands(); i++) {
+        float centerHz = analyser.centerHz(i);
         float magDb = magnitudesDb[i];
 
         // Only print bands with significant energy
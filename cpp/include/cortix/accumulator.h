@@ -0,0 +1,119 @@
+/*
+ * Cortix - Block-Size Normalizer
+ *
+ * Gathers arbitrary-size audio callbacks (AudioWorklet render quanta of
+ * 128 frames, drivers delivering 16-64) into fixed internal blocks before
+ * they reach Analyser::process, so per-call overhead is paid once per
+ * block and the filterbank runs whole hops.
+ *
+ * The accumulator is a pure delay: samples reach the analyser in order
+ * and unchanged, so frame indices and Frame::samplePosition stay exact
+ * stream positions. The added latency is at most blockSize - 1 samples;
+ * latencySamples() reports the samples currently held back. Input that
+ * arrives in whole blocks while nothing is buffered is passed through
+ * without copying.
+ */
+
+#pragma once
+
+#include "analyser.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+namespace cortix {
+
+class BlockAccumulator {
+public:
+    struct Config {
+        int blockSize = 512;        // Samples per analyser call; best as a multiple of the hop
+    };
+
+    BlockAccumulator(Analyser& analyser, const Config& config) : analyser_(analyser) {
+        configure(config);
+    }
+
+    explicit BlockAccumulator(Analyser& analyser) : BlockAccumulator(analyser, Config{}) {}
+
+    void configure(const Config& config) {
+        config_ = config;
+        config_.blockSize = std::max(1, config.blockSize);
+        buffer_.assign(config_.blockSize, 0.0f);
+        reset();
+    }
+
+    /// Drop buffered samples (does not reset the analyser)
+    void reset() {
+        fill_ = 0;
+        inputPosition_ = 0;
+        calls_ = 0;
+        blocks_ = 0;
+        peakLatency_ = 0;
+    }
+
+    /// Add a callback's worth of samples; full blocks go to the analyser
+    void process(const float* input, int numSamples) {
+        calls_++;
+        inputPosition_ += std::max(numSamples, 0);
+        const int bs = config_.blockSize;
+        int pos = 0;
+        while (pos < numSamples) {
+            if (fill_ == 0 && numSamples - pos >= bs) {
+                // Whole blocks straight from the caller's buffer
+                const int n = (numSamples - pos) / bs * bs;
+                analyser_.process(input + pos, n);
+                blocks_ += n / bs;
+                pos += n;
+                continue;
+            }
+            const int n = std::min(numSamples - pos, bs - fill_);
+            std::copy(input + pos, input + pos + n, buffer_.data() + fill_);
+            fill_ += n;
+            pos += n;
+            if (fill_ == bs) {
+                analyser_.process(buffer_.data(), bs);
+                blocks_++;
+                fill_ = 0;
+            }
+        }
+        peakLatency_ = std::max(peakLatency_, fill_);
+    }
+
+    /// Pass any buffered samples on now, e.g. at end of stream
+    void flush() {
+        if (fill_ == 0) return;
+        analyser_.process(buffer_.data(), fill_);
+        blocks_++;
+        fill_ = 0;
+    }
+
+    /// Samples received but not yet analysed (the current added latency)
+    int latencySamples() const { return fill_; }
+    float latencySeconds() const { return fill_ / analyser_.sampleRate(); }
+
+    /// Worst-case added latency
+    int maxLatencySamples() const { return config_.blockSize - 1; }
+    float maxLatencySeconds() const { return maxLatencySamples() / analyser_.sampleRate(); }
+
+    /// Largest latency seen after a callback since reset()
+    int peakLatencySamples() const { return peakLatency_; }
+
+    /// Samples received since reset(); frames lag this by latencySamples()
+    int64_t inputPosition() const { return inputPosition_; }
+
+    int blockSize() const { return config_.blockSize; }
+    int64_t calls() const { return calls_; }
+    int64_t blocks() const { return blocks_; }
+
+private:
+    Analyser& analyser_;
+    Config config_;
+    std::vector<float> buffer_;
+    int fill_ = 0;
+    int64_t inputPosition_ = 0;
+    int64_t calls_ = 0;
+    int64_t blocks_ = 0;        // Blocks passed to the analyser (flushes included)
+    int peakLatency_ = 0;
+};
+
+} // namespace cortix
@@ -0,0 +1,117 @@
+/*
+ * Cortix - Activity Detection
+ *
+ * Cheap per-hop activity decision from the band energies, used to skip
+ * expensive stages during silence or steady background noise.
+ *
+ * The frame level (mean band power in dB) is compared with a background
+ * estimate that drops immediately to quieter frames and rises slowly
+ * otherwise (more slowly still while active, so sustained programme is
+ * not learned as background). Activity starts when the level clears the
+ * background by onDb and ends after it has stayed below offDb for the
+ * hangover time, so the gate does not chatter on word or note boundaries.
+ */
+
+#pragma once
+
+#include "fastmath.h"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+namespace cortix {
+
+class ActivityDetector {
+public:
+    struct Config {
+        int numBands = 40;
+        float hopRateHz = 375.0f;
+        float onDb = 9.0f;              // Above background to switch on
+        float offDb = 4.0f;             // Below this (above background) to start the hangover
+        float minDb = -70.0f;           // Absolute level required to be active
+        float hangoverSeconds = 0.3f;   // Stays active this long after the level drops
+        float floorRiseDbPerSecond = 3.0f;  // How fast the background follows louder input
+        float activeFloorRiseDbPerSecond = 0.3f;  // Same, while active
+    };
+
+    ActivityDetector() = default;
+
+    explicit ActivityDetector(const Config& config) {
+        configure(config);
+    }
+
+    void configure(const Config& config) {
+        config_ = config;
+        hangoverFrames_ = std::max(1, static_cast<int>(config.hangoverSeconds * config.hopRateHz));
+        floorRise_ = config.floorRiseDbPerSecond / config.hopRateHz;
+        activeFloorRise_ = config.activeFloorRiseDbPerSecond / config.hopRateHz;
+        reset();
+    }
+
+    void reset() {
+        active_ = false;
+        hangover_ = 0;
+        floorDb_ = 0.0f;
+        levelDb_ = config_.minDb;
+        frames_ = 0;
+        activeFrames_ = 0;
+    }
+
+    /// Update from one envelope frame; returns the activity decision
+    bool process(const float* envelope) {
+        const int nb = config_.numBands;
+        float power = 0.0f;
+        for (int b = 0; b < nb; b++) {
+            power += envelope[b] * envelope[b];
+        }
+        levelDb_ = fastPowerToDb(power / static_cast<float>(std::max(nb, 1)) + 1e-20f);
+
+        // Background: follows drops at once, rises slowly
+        const float rise = active_ ? activeFloorRise_ : floorRise_;
+        floorDb_ = frames_ == 0 ? levelDb_ : std::min(levelDb_, floorDb_ + rise);
+
+        const float onLevel = std::max(floorDb_ + config_.onDb, config_.minDb);
+        const float holdLevel = std::max(floorDb_ + config_.offDb, config_.minDb);
+        if (!active_) {
+            if (levelDb_ > onLevel) {
+                active_ = true;
+                hangover_ = hangoverFrames_;
+            }
+        } else if (levelDb_ > holdLevel) {
+            hangover_ = hangoverFrames_;
+        } else if (--hangover_ <= 0) {
+            active_ = false;
+        }
+
+        frames_++;
+        if (active_) activeFrames_++;
+        return active_;
+    }
+
+    /// Current decision
+    bool active() const { return active_; }
+
+    /// Frame level and background estimate in dB
+    float levelDb() const { return levelDb_; }
+    float backgroundDb() const { return floorDb_; }
+
+    /// Hops processed and hops judged active since reset()
+    int64_t frames() const { return frames_; }
+    int64_t activeFrames() const { return activeFrames_; }
+
+private:
+    Config config_;
+    int hangoverFrames_ = 1;
+    float floorRise_ = 0.0f;
+    float activeFloorRise_ = 0.0f;
+
+    bool active_ = false;
+    int hangover_ = 0;
+    float floorDb_ = 0.0f;
+    float levelDb_ = 0.0f;
+    int64_t frames_ = 0;
+    int64_t activeFrames_ = 0;
+};
+
+} // namespace cortix
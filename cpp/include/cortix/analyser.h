@@ -11,8 +11,23 @@
 
 #include "scales.h"
 #include "gammatone.h"
+#include "pitch.h"
+#include "chroma.h"
+#include "cepstrum.h"
+#include "descriptors.h"
+#include "tempo.h"
+#include "peaks.h"
+#include "noisefloor.h"
+#include "inhibition.h"
+#include "statistics.h"
+#include "fingerprint.h"
+#include "changepoint.h"
+#include "activity.h"
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 
 namespace cortix {
 
@@ -28,6 +43,24 @@ enum class AnalysisMode {
     // Reassigned   // Reassigned spectrogram
 };
 
+//=============================================================================
+// Gated Stages
+// Optional stages the activity gate may skip (bit flags for
+// Analyser::Config::gatedStages)
+//=============================================================================
+
+enum GatedStage : uint32_t {
+    GatePitch       = 1u << 0,
+    GateChroma      = 1u << 1,
+    GateCepstrum    = 1u << 2,
+    GateDescriptors = 1u << 3,
+    GatePartials    = 1u << 4,
+    GateInhibition  = 1u << 5,
+    GateFingerprint = 1u << 6,
+};
+
+constexpr int kNumGatedStages = 7;
+
 //=============================================================================
 // Spectrum Analyser
 // Main interface for perceptual spectrum analysis
@@ -43,8 +76,66 @@ public:
         float maxHz = 20000.0f;
         float sampleRate = 48000.0f;
         float smoothingMs = 5.0f;
+        int hopSize = 128;              // Samples between output frames
+
+        // Optional per-hop stages
+        bool enablePitch = false;
+        CorrelogramPitch::Config pitch; // numBands/sampleRate are filled in
+        bool enableChroma = false;
+        ChromaExtractor::Config chroma;
+        bool enableCepstrum = false;
+        CepstrumExtractor::Config cepstrum;
+        bool enableDescriptors = false;
+        SpectralDescriptors::Config descriptors;
+        bool enableTempo = false;
+        TempoTracker::Config tempo;     // numBands/hopRateHz are filled in
+        bool enablePartials = false;
+        PartialTracker::Config partials;
+        bool enableNoiseFloor = false;
+        NoiseFloorTracker::Config noiseFloor;  // numBands/hopRateHz are filled in
+        bool enableInhibition = false;
+        LateralInhibition::Config inhibition;
+        bool enableStatistics = false;
+        BandStatistics::Config statistics;     // numBands is filled in
+        bool enableFingerprint = false;
+        FingerprintExtractor::Config fingerprint;  // numBands is filled in
+        bool enableChangeDetection = false;
+        ChangeDetector::Config changeDetection;    // numBands/hopRateHz are filled in
+
+        // Activity gate: while inactive, the stages in gatedStages are
+        // skipped and their Frame fields stay null. Gated pitch and
+        // cepstrum restart when it reopens.
+        bool enableActivityGate = false;
+        ActivityDetector::Config activity;         // numBands/hopRateHz are filled in
+        uint32_t gatedStages = GatePitch | GateChroma | GateCepstrum | GatePartials | GateFingerprint;
+    };
+
+    /// Snapshot handed to the frame callback once per hop
+    struct Frame {
+        int64_t index = 0;              // Hop counter since reset()
+        int64_t samplePosition = 0;     // Input samples consumed at the end of this hop
+        const float* envelope = nullptr;
+        int numBands = 0;
+        const PitchEstimate* pitch = nullptr;  // Null unless enablePitch
+        const float* chroma = nullptr;         // numChromaBins, null unless enableChroma
+        int numChromaBins = 0;
+        const float* cepstrum = nullptr;       // Features of hop (index - cepstrum latency)
+        int numCepstrumFeatures = 0;
+        const DescriptorFrame* descriptors = nullptr;
+        const TempoEstimate* tempo = nullptr;
+        const SpectralPeak* peaks = nullptr;   // Strongest first, null unless enablePartials
+        int numPeaks = 0;
+        const float* noiseFloorDb = nullptr;   // numBands, null unless enableNoiseFloor
+        const float* snrDb = nullptr;
+        const float* sharpened = nullptr;      // numBands, null unless enableInhibition
+        const Landmark* landmarks = nullptr;   // Landmarks completed this hop
+        int numLandmarks = 0;
+        const ChangeEvent* change = nullptr;   // Non-null only on hops where a change was detected
+        bool active = true;                    // Activity gate decision (true without a gate)
     };
 
+    using FrameCallback = std::function<void(const Frame&)>;
+
     Analyser() {
         configure(Config{});
     }
@@ -55,6 +146,7 @@ public:
 
     void configure(const Config& config) {
         config_ = config;
+        config_.hopSize = std::max(1, config.hopSize);
 
         switch (config.mode) {
             case AnalysisMode::Gammatone: {
@@ -69,18 +161,112 @@ public:
                 break;
             }
         }
+
+        if (config_.enablePitch) {
+            CorrelogramPitch::Config pitchConfig = config.pitch;
+            pitchConfig.numBands = config.numBands;
+            pitchConfig.sampleRate = config.sampleRate;
+            pitch_.configure(pitchConfig);
+            bandSignals_.assign(static_cast<size_t>(config_.hopSize) * config.numBands, 0.0f);
+        } else {
+            bandSignals_.clear();
+        }
+
+        if (config_.enableChroma) {
+            chroma_.configure(config.chroma, bands());
+        }
+        if (config_.enableCepstrum) {
+            cepstrum_.configure(config.cepstrum, config.numBands);
+        }
+        if (config_.enableDescriptors) {
+            descriptors_.configure(config.descriptors, bands());
+        }
+        if (config_.enableTempo) {
+            TempoTracker::Config tempoConfig = config.tempo;
+            tempoConfig.numBands = config.numBands;
+            tempoConfig.hopRateHz = config.sampleRate / config_.hopSize;
+            tempo_.configure(tempoConfig);
+        }
+        if (config_.enablePartials) {
+            partials_.configure(config.partials, bands());
+            instantaneousHz_.assign(config.numBands, 0.0f);
+        }
+        if (config_.enableNoiseFloor) {
+            NoiseFloorTracker::Config floorConfig = config.noiseFloor;
+            floorConfig.numBands = config.numBands;
+            floorConfig.hopRateHz = config.sampleRate / config_.hopSize;
+            noiseFloor_.configure(floorConfig);
+        }
+        if (config_.enableInhibition) {
+            inhibition_.configure(config.inhibition, bands());
+        }
+        if (config_.enableStatistics) {
+            BandStatistics::Config statsConfig = config.statistics;
+            statsConfig.numBands = config.numBands;
+            statistics_.configure(statsConfig);
+        }
+        if (config_.enableFingerprint) {
+            FingerprintExtractor::Config fpConfig = config.fingerprint;
+            fpConfig.numBands = config.numBands;
+            fingerprint_.configure(fpConfig);
+        }
+        if (config_.enableChangeDetection) {
+            ChangeDetector::Config changeConfig = config.changeDetection;
+            changeConfig.numBands = config.numBands;
+            changeConfig.hopRateHz = config.sampleRate / config_.hopSize;
+            changeDetector_.configure(changeConfig);
+        }
+        if (config_.enableActivityGate) {
+            ActivityDetector::Config activityConfig = config.activity;
+            activityConfig.numBands = config.numBands;
+            activityConfig.hopRateHz = config.sampleRate / config_.hopSize;
+            activity_.configure(activityConfig);
+        }
+        resetGate();
+
+        hopPhase_ = 0;
+        frameIndex_ = 0;
+        samplePosition_ = 0;
     }
 
     void reset() {
         gammatone_.reset();
+        if (config_.enablePitch) pitch_.reset();
+        if (config_.enableChroma) chroma_.reset();
+        if (config_.enableCepstrum) cepstrum_.reset();
+        if (config_.enableDescriptors) descriptors_.reset();
+        if (config_.enableTempo) tempo_.reset();
+        if (config_.enablePartials) partials_.reset();
+        if (config_.enableNoiseFloor) noiseFloor_.reset();
+        if (config_.enableInhibition) inhibition_.reset();
+        if (config_.enableStatistics) statistics_.reset();
+        if (config_.enableFingerprint) fingerprint_.reset();
+        if (config_.enableChangeDetection) changeDetector_.reset();
+        if (config_.enableActivityGate) activity_.reset();
+        resetGate();
+        hopPhase_ = 0;
+        frameIndex_ = 0;
+        samplePosition_ = 0;
+    }
+
+    /// Called once per completed hop from inside process()
+    void setFrameCallback(FrameCallback callback) {
+        frameCallback_ = std::move(callback);
     }
 
     /// Process a block of samples (mono)
     const std::vector<float>& process(const float* input, int numSamples) {
-        switch (config_.mode) {
-            case AnalysisMode::Gammatone:
-                gammatone_.process(input, numSamples);
-                break;
+        int pos = 0;
+        while (pos < numSamples) {
+            const int n = std::min(numSamples - pos, config_.hopSize - hopPhase_);
+            processChunk(input + pos, n);
+            pos += n;
+            hopPhase_ += n;
+            samplePosition_ += n;
+            if (hopPhase_ == config_.hopSize) {
+                hopPhase_ = 0;
+                emitFrame();
+            }
         }
         return envelope();
     }
@@ -120,10 +306,231 @@ public:
         return gammatone_.bands();
     }
 
+    /// Samples per output frame
+    int hopSize() const { return config_.hopSize; }
+
+    /// Approximate working set touched on every sample: filterbank state,
+    /// plus the pitch tracker and band-signal buffer when enabled. Used to
+    /// size cache tiles in the multi-stream pool.
+    size_t stateBytes() const {
+        size_t bytes = gammatone_.stateBytes() + gammatone_.envelope().size() * 2 * sizeof(float);
+        if (config_.enablePitch) {
+            bytes += pitch_.stateBytes() + bandSignals_.size() * sizeof(float);
+        }
+        return bytes;
+    }
+
+    /// Compute only the bands with mask[band] != 0; the others hold their
+    /// last values. See GammatoneFilterbank::setActiveBands.
+    void setActiveBands(const uint8_t* mask) { gammatone_.setActiveBands(mask); }
+
+    /// Compute only the bands centred in [minHz, maxHz]
+    void setActiveRange(float minHz, float maxHz) { gammatone_.setActiveRange(minHz, maxHz); }
+
+    /// Compute every band again
+    void setAllBandsActive() { gammatone_.setAllBandsActive(); }
+
+    /// Move the bands to a new frequency range without resetting the
+    /// filterbank (see GammatoneFilterbank::zoom). Stages that depend on
+    /// band frequencies (chroma, descriptors, partials, inhibition) are
+    /// reconfigured when enabled, which allocates; with only the envelope,
+    /// pitch, cepstrum, tempo and noise floor this is audio-thread safe.
+    void zoom(float minHz, float maxHz) {
+        config_.minHz = minHz;
+        config_.maxHz = maxHz;
+        gammatone_.zoom(minHz, maxHz);
+
+        if (config_.enableChroma) chroma_.configure(config_.chroma, bands());
+        if (config_.enableDescriptors) descriptors_.configure(config_.descriptors, bands());
+        if (config_.enablePartials) partials_.configure(config_.partials, bands());
+        if (config_.enableInhibition) inhibition_.configure(config_.inhibition, bands());
+    }
+
+    /// Latest pitch estimate (empty unless enablePitch)
+    const PitchEstimate& pitch() const { return pitch_.estimate(); }
+
+    /// Pitch tracker, for access to the summary autocorrelation
+    const CorrelogramPitch& pitchTracker() const { return pitch_; }
+
+    /// Chroma extractor, for the chroma vector and tuning estimate
+    const ChromaExtractor& chroma() const { return chroma_; }
+
+    /// Cepstral feature extractor (GFCC with deltas)
+    const CepstrumExtractor& cepstrum() const { return cepstrum_; }
+
+    /// Spectral descriptors and their recent time series
+    const SpectralDescriptors& descriptors() const { return descriptors_; }
+
+    /// Latest tempo estimate (empty unless enableTempo)
+    const TempoEstimate& tempo() const { return tempo_.estimate(); }
+
+    /// Spectral peaks and partial tracks
+    const PartialTracker& partials() const { return partials_; }
+
+    /// Per-band noise floor and SNR
+    const NoiseFloorTracker& noiseFloor() const { return noiseFloor_; }
+
+    /// Lateral inhibition stage, for the sharpened envelope
+    const LateralInhibition& inhibition() const { return inhibition_; }
+
+    /// Long-term per-band statistics (LTAS, level mean/variance, quantiles)
+    const BandStatistics& statistics() const { return statistics_; }
+
+    /// Landmark extractor for fingerprinting
+    const FingerprintExtractor& fingerprint() const { return fingerprint_; }
+
+    /// Spectral change detector and its last event
+    const ChangeDetector& changeDetector() const { return changeDetector_; }
+
+    /// Activity detector behind the gate
+    const ActivityDetector& activity() const { return activity_; }
+
+    /// Hops on which an enabled stage was skipped by the activity gate
+    int64_t skippedHops(GatedStage stage) const {
+        for (int i = 0; i < kNumGatedStages; i++) {
+            if (stage == (1u << i)) return skipped_[i];
+        }
+        return 0;
+    }
+
 private:
+    void processChunk(const float* input, int numSamples) {
+        switch (config_.mode) {
+            case AnalysisMode::Gammatone:
+                if (config_.enablePitch && pitchRunning_) {
+                    gammatone_.process(input, numSamples, bandSignals_.data());
+                    pitch_.process(bandSignals_.data(), numSamples);
+                } else {
+                    gammatone_.process(input, numSamples);
+                }
+                break;
+        }
+    }
+
+    void emitFrame() {
+        Frame frame;
+        frame.index = frameIndex_++;
+        frame.samplePosition = samplePosition_;
+        frame.envelope = envelope().data();
+        frame.numBands = config_.numBands;
+
+        if (config_.enableActivityGate) {
+            const bool wasActive = active_;
+            active_ = activity_.process(frame.envelope);
+            frame.active = active_;
+            if (active_ && !wasActive) reopenGate();
+        }
+
+        // Pitch accumulates per sample, so this hop's decision also
+        // applies to the samples of the next hop. On reopening it starts
+        // from a clean correlogram, not the one left before the pause.
+        if (config_.enablePitch) {
+            if (pitchRunning_) {
+                frame.pitch = &pitch_.updateEstimate();
+            } else {
+                skipped_[0]++;     // GatePitch is bit 0
+            }
+            const bool wasRunning = pitchRunning_;
+            pitchRunning_ = active_ || !(config_.gatedStages & GatePitch);
+            if (pitchRunning_ && !wasRunning) pitch_.reset();
+        }
+        if (runs(config_.enableChroma, GateChroma)) {
+            frame.chroma = chroma_.process(frame.envelope).data();
+            frame.numChromaBins = chroma_.numBins();
+        }
+        if (runs(config_.enableCepstrum, GateCepstrum)) {
+            frame.cepstrum = cepstrum_.process(frame.envelope).data();
+            frame.numCepstrumFeatures = cepstrum_.featureDim();
+        }
+        if (runs(config_.enableDescriptors, GateDescriptors)) {
+            frame.descriptors = &descriptors_.process(frame.envelope);
+        }
+        if (config_.enableTempo) {
+            frame.tempo = &tempo_.process(frame.envelope);
+        }
+        if (runs(config_.enablePartials, GatePartials)) {
+            gammatone_.instantaneousFrequency(instantaneousHz_.data());
+            partials_.process(frame.envelope, instantaneousHz_.data());
+            frame.peaks = partials_.peaks();
+            frame.numPeaks = partials_.numPeaks();
+        }
+        if (config_.enableNoiseFloor) {
+            noiseFloor_.process(frame.envelope);
+            frame.noiseFloorDb = noiseFloor_.floorDb().data();
+            frame.snrDb = noiseFloor_.snrDb().data();
+        }
+        if (runs(config_.enableInhibition, GateInhibition)) {
+            frame.sharpened = inhibition_.process(frame.envelope).data();
+        }
+        if (config_.enableStatistics) {
+            statistics_.process(frame.envelope);
+        }
+        if (runs(config_.enableFingerprint, GateFingerprint)) {
+            frame.numLandmarks = fingerprint_.process(frame.envelope);
+            frame.landmarks = fingerprint_.landmarks();
+        } else if (config_.enableFingerprint) {
+            fingerprint_.skip();
+        }
+        if (config_.enableChangeDetection) {
+            if (changeDetector_.process(frame.envelope, frame.samplePosition)) {
+                frame.change = &changeDetector_.event();
+            }
+        }
+
+        if (frameCallback_) {
+            frameCallback_(frame);
+        }
+    }
+
+    /// Whether an enabled stage runs on this hop; counts gated skips
+    bool runs(bool enabled, GatedStage stage) {
+        if (!enabled) return false;
+        if (active_ || !(config_.gatedStages & stage)) return true;
+        for (int i = 0; i < kNumGatedStages; i++) {
+            if (stage == (1u << i)) skipped_[i]++;
+        }
+        return false;
+    }
+
+    /// The gated cepstrum restarts when the gate reopens, so its deltas
+    /// never mix in frames from before the pause. It keeps its latency()
+    /// alignment, with zeros standing in for the idle hops.
+    void reopenGate() {
+        if (config_.enableCepstrum && (config_.gatedStages & GateCepstrum)) cepstrum_.reset();
+    }
+
+    void resetGate() {
+        active_ = true;
+        pitchRunning_ = true;
+        std::fill(std::begin(skipped_), std::end(skipped_), 0);
+    }
+
     Config config_;
     GammatoneFilterbank gammatone_;
+    CorrelogramPitch pitch_;
+    ChromaExtractor chroma_;
+    CepstrumExtractor cepstrum_;
+    SpectralDescriptors descriptors_;
+    TempoTracker tempo_;
+    PartialTracker partials_;
+    NoiseFloorTracker noiseFloor_;
+    LateralInhibition inhibition_;
+    BandStatistics statistics_;
+    FingerprintExtractor fingerprint_;
+    ChangeDetector changeDetector_;
+    ActivityDetector activity_;
     std::vector<float> monoBuffer_;
+    std::vector<float> bandSignals_;
+    std::vector<float> instantaneousHz_;
+
+    FrameCallback frameCallback_;
+    int hopPhase_ = 0;
+    int64_t frameIndex_ = 0;
+    int64_t samplePosition_ = 0;
+
+    bool active_ = true;
+    bool pitchRunning_ = true;
+    int64_t skipped_[kNumGatedStages] = {};
 };
 
 } // namespace cortix
@@ -0,0 +1,116 @@
+/*
+ * Cortix - Ragged Batch Processing
+ *
+ * Processes packets of uneven length for many streams in one call. Each
+ * packet is a (stream, samples, length) descriptor; a stream is simply
+ * its Analyser.
+ *
+ * Packets are ordered by design (band count and hop size) and then by
+ * stream, keeping submission order within a stream. Analysers of one
+ * design therefore run back to back with the same band loops and trip
+ * counts hot. All packets of a stream are coalesced into one contiguous
+ * block and fed with a single process() call, so tiny packets no longer
+ * split hops into short chunks: the filterbank runs whole hops and
+ * publishes its envelope once per hop instead of once per packet.
+ *
+ * Frame callbacks fire inside process() as usual, grouped by stream.
+ * Not thread-safe; use one BatchProcessor per thread.
+ */
+
+#pragma once
+
+#include "analyser.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+
+namespace cortix {
+
+/// One packet of samples for one stream
+struct StreamPacket {
+    Analyser* stream = nullptr;
+    const float* samples = nullptr;
+    int numSamples = 0;
+};
+
+class BatchProcessor {
+public:
+    /// Counters for the last process() call
+    struct Stats {
+        int packets = 0;
+        int streams = 0;            // Distinct analysers
+        int designs = 0;            // Distinct (bands, hop) groups
+        int coalesced = 0;          // Streams whose packets were joined
+        int64_t samples = 0;
+    };
+
+    /// Process a batch. Packets of one stream are applied in array order.
+    void process(const StreamPacket* packets, int numPackets) {
+        stats_ = Stats{};
+        order_.clear();
+        for (int i = 0; i < numPackets; i++) {
+            if (packets[i].stream && packets[i].numSamples > 0) order_.push_back(i);
+        }
+        stats_.packets = static_cast<int>(order_.size());
+
+        // Design, then stream, then submission order
+        std::sort(order_.begin(), order_.end(), [packets](int a, int b) {
+            const Analyser* x = packets[a].stream;
+            const Analyser* y = packets[b].stream;
+            if (x->numBands() != y->numBands()) return x->numBands() < y->numBands();
+            if (x->hopSize() != y->hopSize()) return x->hopSize() < y->hopSize();
+            if (x != y) return std::less<const Analyser*>()(x, y);
+            return a < b;
+        });
+
+        const Analyser* previous = nullptr;
+        size_t i = 0;
+        while (i < order_.size()) {
+            Analyser* stream = packets[order_[i]].stream;
+            size_t end = i + 1;
+            int64_t total = packets[order_[i]].numSamples;
+            while (end < order_.size() && packets[order_[end]].stream == stream) {
+                total += packets[order_[end]].numSamples;
+                end++;
+            }
+
+            if (!previous || previous->numBands() != stream->numBands()
+                          || previous->hopSize() != stream->hopSize()) {
+                stats_.designs++;
+            }
+            stats_.streams++;
+            stats_.samples += total;
+
+            if (end - i == 1) {
+                stream->process(packets[order_[i]].samples, packets[order_[i]].numSamples);
+            } else {
+                staging_.resize(static_cast<size_t>(total));
+                float* out = staging_.data();
+                for (size_t k = i; k < end; k++) {
+                    const StreamPacket& p = packets[order_[k]];
+                    std::copy(p.samples, p.samples + p.numSamples, out);
+                    out += p.numSamples;
+                }
+                stream->process(staging_.data(), static_cast<int>(total));
+                stats_.coalesced++;
+            }
+
+            previous = stream;
+            i = end;
+        }
+    }
+
+    void process(const std::vector<StreamPacket>& packets) {
+        process(packets.data(), static_cast<int>(packets.size()));
+    }
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    std::vector<int> order_;
+    std::vector<float> staging_;    // Grows to the largest coalesced block
+    Stats stats_;
+};
+
+} // namespace cortix
@@ -0,0 +1,228 @@
+/*
+ * Cortix - Cepstral Features (GFCC)
+ *
+ * Gammatone-frequency cepstral coefficients from envelope frames: log band
+ * energy, DCT-II, optional sinusoidal liftering, and regression deltas /
+ * delta-deltas. With a Mel-scale bank the same stage yields MFCC-style
+ * features.
+ *
+ * The orthonormal DCT-II matrix (with the lifter folded in) is
+ * precomputed band-major, so each frame is an axpy over coefficients per
+ * band. Streaming deltas come from small ring buffers and are delayed by
+ * latency() frames; the batch variant is non-causal and frame-aligned.
+ */
+
+#pragma once
+
+#include "fastmath.h"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+namespace cortix {
+
+class CepstrumExtractor {
+public:
+    struct Config {
+        int numCoeffs = 13;
+        bool includeC0 = true;     // Otherwise coefficients start at c1
+        float lifter = 22.0f;      // Sinusoidal lifter length, 0 disables
+        bool deltas = true;
+        bool deltaDeltas = true;
+        int deltaWindow = 2;       // Regression half-width N in frames
+        float floor = 1e-10f;      // Added to band energy before the log
+    };
+
+    CepstrumExtractor() = default;
+
+    CepstrumExtractor(const Config& config, int numBands) {
+        configure(config, numBands);
+    }
+
+    void configure(const Config& config, int numBands) {
+        config_ = config;
+        config_.numCoeffs = std::clamp(config.numCoeffs, 1, std::max(1, numBands - (config.includeC0 ? 0 : 1)));
+        config_.deltaWindow = std::max(1, config.deltaWindow);
+        numBands_ = numBands;
+
+        const int nc = config_.numCoeffs;
+        const int first = config_.includeC0 ? 0 : 1;
+
+        dct_.assign(static_cast<size_t>(numBands) * nc, 0.0f);
+        for (int j = 0; j < nc; j++) {
+            const int k = first + j;
+            const float scale = std::sqrt((k == 0 ? 1.0f : 2.0f) / numBands);
+            const float lift = config.lifter > 0.0f
+                ? 1.0f + 0.5f * config.lifter * std::sin(static_cast<float>(M_PI) * k / config.lifter)
+                : 1.0f;
+            for (int b = 0; b < numBands; b++) {
+                dct_[static_cast<size_t>(b) * nc + j] = scale * lift *
+                    std::cos(static_cast<float>(M_PI) * k * (b + 0.5f) / numBands);
+            }
+        }
+
+        const int n = config_.deltaWindow;
+        deltaNorm_ = 0.0f;
+        for (int i = 1; i <= n; i++) deltaNorm_ += 2.0f * i * i;
+        deltaNorm_ = 1.0f / deltaNorm_;
+
+        const bool needDeltas = config_.deltas || config_.deltaDeltas;
+        latency_ = (needDeltas ? n : 0) + (config_.deltaDeltas ? n : 0);
+        ringLength_ = 2 * n + 1;
+
+        featureDim_ = nc * (1 + (config_.deltas ? 1 : 0) + (config_.deltaDeltas ? 1 : 0));
+        logEnergy_.assign(numBands, 0.0f);
+        statics_.assign(static_cast<size_t>(ringLength_) * nc, 0.0f);
+        deltaRing_.assign(static_cast<size_t>(ringLength_) * nc, 0.0f);
+        features_.assign(featureDim_, 0.0f);
+
+        reset();
+    }
+
+    void reset() {
+        std::fill(statics_.begin(), statics_.end(), 0.0f);
+        std::fill(deltaRing_.begin(), deltaRing_.end(), 0.0f);
+        std::fill(features_.begin(), features_.end(), 0.0f);
+        frameCount_ = 0;
+    }
+
+    /// Process one envelope frame. Returns the feature vector
+    /// [c, delta, delta-delta] of the frame latency() hops earlier.
+    const std::vector<float>& process(const float* envelope) {
+        const int nc = config_.numCoeffs;
+        const int n = config_.deltaWindow;
+        const int64_t t = frameCount_++;
+
+        float* c = row(statics_, t);
+        transform(envelope, c);
+
+        const bool needDeltas = config_.deltas || config_.deltaDeltas;
+        if (needDeltas) {
+            regress(statics_, t - n, row(deltaRing_, t - n));
+        }
+
+        const int64_t out = t - latency_;
+        float* f = features_.data();
+        std::copy(row(statics_, out), row(statics_, out) + nc, f);
+        f += nc;
+        if (config_.deltas) {
+            std::copy(row(deltaRing_, out), row(deltaRing_, out) + nc, f);
+            f += nc;
+        }
+        if (config_.deltaDeltas) {
+            regress(deltaRing_, out, f);
+        }
+
+        return features_;
+    }
+
+    /// Offline extraction over a whole frame matrix (numFrames x numBands).
+    /// Writes numFrames x featureDim() features, aligned with the input
+    /// frames; deltas replicate the edge frames.
+    void processBatch(const float* envelopes, int numFrames, float* features) const {
+        const int nc = config_.numCoeffs;
+        const int dim = featureDim_;
+        const int n = config_.deltaWindow;
+        std::vector<float> logEnergy(numBands_);
+
+        for (int t = 0; t < numFrames; t++) {
+            transform(envelopes + static_cast<size_t>(t) * numBands_,
+                      features + static_cast<size_t>(t) * dim, logEnergy.data());
+        }
+
+        // Regression deltas down a column block of nc values per frame
+        auto regressColumns = [&](const float* src, size_t srcStride, float* dst, size_t dstStride) {
+            for (int t = 0; t < numFrames; t++) {
+                float* d = dst + static_cast<size_t>(t) * dstStride;
+                std::fill(d, d + nc, 0.0f);
+                for (int i = 1; i <= n; i++) {
+                    const float* a = src + static_cast<size_t>(std::min(t + i, numFrames - 1)) * srcStride;
+                    const float* b = src + static_cast<size_t>(std::max(t - i, 0)) * srcStride;
+                    for (int j = 0; j < nc; j++) {
+                        d[j] += i * (a[j] - b[j]);
+                    }
+                }
+                for (int j = 0; j < nc; j++) d[j] *= deltaNorm_;
+            }
+        };
+
+        if (config_.deltas) {
+            regressColumns(features, dim, features + nc, dim);
+            if (config_.deltaDeltas) {
+                regressColumns(features + nc, dim, features + 2 * nc, dim);
+            }
+        } else if (config_.deltaDeltas) {
+            // Deltas are not output; derive them in a scratch matrix
+            std::vector<float> deltas(static_cast<size_t>(numFrames) * nc);
+            regressColumns(features, dim, deltas.data(), nc);
+            regressColumns(deltas.data(), nc, features + nc, dim);
+        }
+    }
+
+    /// Feature vector from the last process() call
+    const std::vector<float>& features() const { return features_; }
+
+    /// Features per frame: numCoeffs * (1 + deltas + deltaDeltas)
+    int featureDim() const { return featureDim_; }
+
+    int numCoeffs() const { return config_.numCoeffs; }
+
+    /// Frames between an input envelope and its streaming feature output
+    int latency() const { return latency_; }
+
+private:
+    void transform(const float* envelope, float* out) {
+        transform(envelope, out, logEnergy_.data());
+    }
+
+    void transform(const float* envelope, float* out, float* logEnergy) const {
+        const int nc = config_.numCoeffs;
+        for (int b = 0; b < numBands_; b++) {
+            logEnergy[b] = fastLog(envelope[b] * envelope[b] + config_.floor);
+        }
+        std::fill(out, out + nc, 0.0f);
+        for (int b = 0; b < numBands_; b++) {
+            const float x = logEnergy[b];
+            const float* d = dct_.data() + static_cast<size_t>(b) * nc;
+            for (int j = 0; j < nc; j++) {
+                out[j] += x * d[j];
+            }
+        }
+    }
+
+    float* row(std::vector<float>& ring, int64_t frame) {
+        const int64_t slot = ((frame % ringLength_) + ringLength_) % ringLength_;
+        return ring.data() + slot * config_.numCoeffs;
+    }
+
+    /// Regression delta of the ring rows around frame centre into out
+    void regress(std::vector<float>& ring, int64_t centre, float* out) {
+        const int nc = config_.numCoeffs;
+        std::fill(out, out + nc, 0.0f);
+        for (int i = 1; i <= config_.deltaWindow; i++) {
+            const float* a = row(ring, centre + i);
+            const float* b = row(ring, centre - i);
+            for (int j = 0; j < nc; j++) {
+                out[j] += i * (a[j] - b[j]);
+            }
+        }
+        for (int j = 0; j < nc; j++) out[j] *= deltaNorm_;
+    }
+
+    Config config_;
+    int numBands_ = 0;
+    int featureDim_ = 0;
+    int latency_ = 0;
+    int ringLength_ = 1;
+    float deltaNorm_ = 1.0f;
+    int64_t frameCount_ = 0;
+
+    std::vector<float> dct_;          // [band][coeff], lifter applied
+    std::vector<float> logEnergy_;
+    std::vector<float> statics_;      // Ring of cepstra
+    std::vector<float> deltaRing_;    // Ring of deltas
+    std::vector<float> features_;
+};
+
+} // namespace cortix
@@ -0,0 +1,184 @@
+/*
+ * Cortix - Spectral Change Detection
+ *
+ * Online change-point detector on band log-energies, for monitoring
+ * alarms such as dead air, heavy distortion or a swapped channel.
+ *
+ * Each band keeps a slow exponentially weighted baseline (mean and
+ * variance of its level in dB) and a two-sided CUSUM (Page 1954) of the
+ * standardized deviation of a short-term smoothed level from it, so that
+ * single notes or words do not accumulate into an alarm. A change is
+ * reported when enough bands cross the CUSUM threshold in the same hop;
+ * the baseline then restarts from the new spectrum. State and work are
+ * O(bands) per hop, and the band loop is branch-free so it vectorizes.
+ */
+
+#pragma once
+
+#include "fastmath.h"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+namespace cortix {
+
+struct ChangeEvent {
+    int64_t frame = 0;              // Hop index of the detection
+    int64_t samplePosition = 0;     // As passed to process()
+    float score = 0.0f;             // Mean CUSUM over bands, in baseline std devs
+    float bandFraction = 0.0f;      // Bands over the threshold
+    int direction = 0;              // +1 level rose, -1 level fell, 0 mixed
+};
+
+class ChangeDetector {
+public:
+    struct Config {
+        int numBands = 40;
+        float hopRateHz = 375.0f;
+        float baselineSeconds = 10.0f;  // Time constant of the level baseline
+        float smoothingSeconds = 0.1f;  // Short-term level fed to the CUSUM
+        float warmupSeconds = 2.0f;     // No detections until the baseline settles
+        float driftSigmas = 0.5f;       // CUSUM allowance k
+        float thresholdSigmas = 20.0f;  // CUSUM threshold h
+        float minBandFraction = 0.3f;   // Bands that must cross h together
+        float minSigmaDb = 1.0f;        // Floor on the baseline std dev
+        float refractorySeconds = 1.0f; // Minimum gap between events
+        float floor = 1e-12f;           // Added to band power before the log
+    };
+
+    ChangeDetector() = default;
+
+    explicit ChangeDetector(const Config& config) {
+        configure(config);
+    }
+
+    void configure(const Config& config) {
+        config_ = config;
+
+        const float rate = config.hopRateHz;
+        baselineCoeff_ = std::exp(-1.0f / std::max(config.baselineSeconds * rate, 1.0f));
+        smoothCoeff_ = std::exp(-1.0f / std::max(config.smoothingSeconds * rate, 1.0f));
+        warmupFrames_ = static_cast<int64_t>(config.warmupSeconds * rate);
+        refractoryFrames_ = static_cast<int64_t>(config.refractorySeconds * rate);
+
+        const size_t nb = config.numBands;
+        mean_.assign(nb, 0.0f);
+        var_.assign(nb, 0.0f);
+        up_.assign(nb, 0.0f);
+        down_.assign(nb, 0.0f);
+        level_.assign(nb, 0.0f);
+        shortTerm_.assign(nb, 0.0f);
+
+        reset();
+    }
+
+    void reset() {
+        std::fill(up_.begin(), up_.end(), 0.0f);
+        std::fill(down_.begin(), down_.end(), 0.0f);
+        frames_ = 0;
+        baselineFrames_ = 0;
+        lastEvent_ = -refractoryFrames_;
+        numEvents_ = 0;
+        event_ = ChangeEvent{};
+    }
+
+    /// Process one envelope frame. Returns true when a change was detected
+    /// at this hop; details are in event().
+    bool process(const float* envelope, int64_t samplePosition = 0) {
+        const int nb = config_.numBands;
+        for (int b = 0; b < nb; b++) {
+            level_[b] = fastPowerToDb(envelope[b] * envelope[b] + config_.floor);
+        }
+
+        if (baselineFrames_ == 0) {
+            restartBaseline();
+        }
+
+        // Baseline learns quickly at first, then at the configured rate
+        const float a = std::min(baselineCoeff_, 1.0f - 1.0f / static_cast<float>(baselineFrames_ + 1));
+        const float s = smoothCoeff_;
+        const float k = config_.driftSigmas;
+        const float h = config_.thresholdSigmas;
+        const float minVar = config_.minSigmaDb * config_.minSigmaDb;
+        const bool armed = baselineFrames_ >= warmupFrames_;
+
+        float sumUp = 0.0f, sumDown = 0.0f, over = 0.0f;
+        for (int b = 0; b < nb; b++) {
+            const float x = level_[b];
+            const float st = s * shortTerm_[b] + (1.0f - s) * x;
+            shortTerm_[b] = st;
+            const float z = (st - mean_[b]) / std::sqrt(std::max(var_[b], minVar));
+            const float u = armed ? std::max(up_[b] + z - k, 0.0f) : 0.0f;
+            const float d = armed ? std::max(down_[b] - z - k, 0.0f) : 0.0f;
+            up_[b] = u;
+            down_[b] = d;
+            sumUp += u;
+            sumDown += d;
+            over += (std::max(u, d) > h) ? 1.0f : 0.0f;
+
+            const float dev = x - mean_[b];
+            mean_[b] += (1.0f - a) * dev;
+            var_[b] = a * (var_[b] + (1.0f - a) * dev * dev);
+        }
+        baselineFrames_++;
+
+        const float fraction = nb > 0 ? over / static_cast<float>(nb) : 0.0f;
+        bool detected = false;
+        if (armed && fraction >= config_.minBandFraction && frames_ - lastEvent_ >= refractoryFrames_) {
+            event_.frame = frames_;
+            event_.samplePosition = samplePosition;
+            event_.score = (sumUp + sumDown) / static_cast<float>(nb);
+            event_.bandFraction = fraction;
+            event_.direction = sumUp > 2.0f * sumDown ? 1 : (sumDown > 2.0f * sumUp ? -1 : 0);
+            lastEvent_ = frames_;
+            numEvents_++;
+            detected = true;
+
+            // The new spectrum becomes the baseline
+            baselineFrames_ = 0;
+            std::fill(up_.begin(), up_.end(), 0.0f);
+            std::fill(down_.begin(), down_.end(), 0.0f);
+        }
+
+        frames_++;
+        return detected;
+    }
+
+    /// Last detected change
+    const ChangeEvent& event() const { return event_; }
+
+    /// Changes detected since reset()
+    int64_t numEvents() const { return numEvents_; }
+
+    /// Baseline level per band in dB
+    const std::vector<float>& baselineDb() const { return mean_; }
+
+private:
+    void restartBaseline() {
+        std::copy(level_.begin(), level_.end(), mean_.begin());
+        std::copy(level_.begin(), level_.end(), shortTerm_.begin());
+        std::fill(var_.begin(), var_.end(), 0.0f);
+    }
+
+    Config config_;
+    float baselineCoeff_ = 0.0f;
+    float smoothCoeff_ = 0.0f;
+    int64_t warmupFrames_ = 0;
+    int64_t refractoryFrames_ = 0;
+
+    std::vector<float> mean_;       // Baseline level (dB)
+    std::vector<float> var_;        // Baseline variance (dB^2)
+    std::vector<float> up_;         // CUSUM of rises
+    std::vector<float> down_;       // CUSUM of falls
+    std::vector<float> level_;
+    std::vector<float> shortTerm_;  // Smoothed level (dB)
+
+    int64_t frames_ = 0;
+    int64_t baselineFrames_ = 0;    // Frames since the baseline (re)started
+    int64_t lastEvent_ = 0;
+    int64_t numEvents_ = 0;
+    ChangeEvent event_;
+};
+
+} // namespace cortix
@@ -0,0 +1,154 @@
+/*
+ * Cortix - Chroma / Pitch-Class Profile
+ *
+ * Folds band envelopes into 12 (or 24, 36, ...) pitch-class bins per hop.
+ * Intended for Scale::Log banks with several bands per semitone, but works
+ * with any band layout. The folding weights are precomputed in configure(),
+ * so the per-hop fold is a dense band-major matrix product whose inner loop
+ * over bins vectorizes.
+ *
+ * A running tuning estimate (deviation from the reference in cents) is
+ * computed as the energy-weighted circular mean of the band positions
+ * within a semitone.
+ */
+
+#pragma once
+
+#include "scales.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace cortix {
+
+class ChromaExtractor {
+public:
+    struct Config {
+        int numBins = 12;            // Multiple of 12
+        float referenceHz = 440.0f;  // Pitch of bin 9 (A) at zero tuning offset
+        float tuningCents = 0.0f;    // Applied to the folding weights
+        float minHz = 50.0f;         // Bands outside this range are ignored
+        float maxHz = 5000.0f;
+        bool normalize = true;       // Scale each frame so its max bin is 1
+        float tuningSmoothing = 0.99f; // Per-hop leak of the tuning estimate
+    };
+
+    ChromaExtractor() = default;
+
+    ChromaExtractor(const Config& config, const std::vector<BandInfo>& bands) {
+        configure(config, bands);
+    }
+
+    void configure(const Config& config, const std::vector<BandInfo>& bands) {
+        config_ = config;
+        config_.numBins = std::max(12, config.numBins / 12 * 12);
+        numBands_ = static_cast<int>(bands.size());
+
+        const int nc = config_.numBins;
+        const float binsPerSemitone = nc / 12.0f;
+        const float refHz = config.referenceHz * std::pow(2.0f, config.tuningCents / 1200.0f);
+
+        weights_.assign(static_cast<size_t>(numBands_) * nc, 0.0f);
+        tuningCos_.assign(numBands_, 0.0f);
+        tuningSin_.assign(numBands_, 0.0f);
+
+        for (int b = 0; b < numBands_; b++) {
+            const BandInfo& band = bands[b];
+            if (band.centerHz < config.minHz || band.centerHz > config.maxHz) continue;
+
+            // Position in bins, with bin 0 = C
+            const float semis = 12.0f * std::log2(band.centerHz / refHz) + 9.0f;
+            const float pos = semis * binsPerSemitone;
+
+            // Bands wider than a bin smear across pitch classes; spread
+            // them accordingly and give them less total weight.
+            const float widthBins = 12.0f * binsPerSemitone *
+                std::log2(band.highHz / std::max(band.lowHz, 1.0f));
+            const float sigma = 0.5f * std::max(1.0f, widthBins);
+            const float total = 1.0f / std::max(1.0f, widthBins);
+
+            float* w = weights_.data() + static_cast<size_t>(b) * nc;
+            float sum = 0.0f;
+            for (int c = 0; c < nc; c++) {
+                float d = std::fmod(c - pos, static_cast<float>(nc));
+                if (d < -0.5f * nc) d += nc;
+                if (d > 0.5f * nc) d -= nc;
+                w[c] = std::exp(-0.5f * d * d / (sigma * sigma));
+                sum += w[c];
+            }
+            for (int c = 0; c < nc; c++) {
+                w[c] *= total / sum;
+            }
+
+            const float phase = 2.0f * static_cast<float>(M_PI) *
+                12.0f * std::log2(band.centerHz / config.referenceHz);
+            tuningCos_[b] = std::cos(phase);
+            tuningSin_[b] = std::sin(phase);
+        }
+
+        chroma_.assign(nc, 0.0f);
+        reset();
+    }
+
+    void reset() {
+        std::fill(chroma_.begin(), chroma_.end(), 0.0f);
+        tuningRe_ = 0.0f;
+        tuningIm_ = 0.0f;
+    }
+
+    /// Fold the band energies of one envelope frame (numBands magnitudes)
+    const std::vector<float>& process(const float* envelope) {
+        const int nc = config_.numBins;
+        std::fill(chroma_.begin(), chroma_.end(), 0.0f);
+
+        float re = 0.0f;
+        float im = 0.0f;
+        for (int b = 0; b < numBands_; b++) {
+            const float e = envelope[b];
+            const float p = e * e;
+            const float* w = weights_.data() + static_cast<size_t>(b) * nc;
+            for (int c = 0; c < nc; c++) {
+                chroma_[c] += p * w[c];
+            }
+            re += p * tuningCos_[b];
+            im += p * tuningSin_[b];
+        }
+
+        if (config_.normalize) {
+            const float peak = *std::max_element(chroma_.begin(), chroma_.end());
+            if (peak > 1e-12f) {
+                const float inv = 1.0f / peak;
+                for (int c = 0; c < nc; c++) chroma_[c] *= inv;
+            }
+        }
+
+        const float a = config_.tuningSmoothing;
+        tuningRe_ = a * tuningRe_ + (1.0f - a) * re;
+        tuningIm_ = a * tuningIm_ + (1.0f - a) * im;
+
+        return chroma_;
+    }
+
+    /// Chroma vector from the last frame (bin 0 = C)
+    const std::vector<float>& chroma() const { return chroma_; }
+
+    int numBins() const { return config_.numBins; }
+
+    /// Estimated tuning offset from the reference in cents (-50..50)
+    float tuningCents() const {
+        if (tuningRe_ == 0.0f && tuningIm_ == 0.0f) return 0.0f;
+        return 100.0f * std::atan2(tuningIm_, tuningRe_) / (2.0f * static_cast<float>(M_PI));
+    }
+
+private:
+    Config config_;
+    int numBands_ = 0;
+    std::vector<float> weights_;    // [band][bin]
+    std::vector<float> tuningCos_;
+    std::vector<float> tuningSin_;
+    std::vector<float> chroma_;
+    float tuningRe_ = 0.0f;
+    float tuningIm_ = 0.0f;
+};
+
+} // namespace cortix
@@ -12,8 +12,25 @@
 #pragma once
 
 #include "scales.h"
+#include "fastmath.h"
 #include "gammatone.h"
+#include "pitch.h"
+#include "chroma.h"
+#include "cepstrum.h"
+#include "descriptors.h"
+#include "tempo.h"
+#include "peaks.h"
+#include "noisefloor.h"
+#include "inhibition.h"
+#include "statistics.h"
+#include "fingerprint.h"
+#include "changepoint.h"
+#include "activity.h"
 #include "analyser.h"
+#include "batch.h"
+#include "accumulator.h"
+#include "pcm.h"
+#include "framecodec.h"
 
 namespace cortix {
 
@@ -0,0 +1,185 @@
+/*
+ * Cortix - C API
+ *
+ * Stable C ABI over the header-only library, built as the cortix_c shared
+ * library for FFI consumers (Python ctypes, Go cgo, Java FFM/JNA, ...).
+ *
+ * - Objects are opaque handles created and destroyed through this API.
+ * - Every call works on whole blocks: process calls take a buffer of
+ *   samples (float32 or int16, optionally interleaved multi-channel),
+ *   and frames are retrieved in bulk into caller-owned buffers. Hop
+ *   frames are queued inside the handle (up to max_queued_frames; older
+ *   frames are dropped and counted beyond that) until read.
+ * - Configuration structs start with their own size, so fields can be
+ *   appended in later versions without breaking existing callers. Fill
+ *   them with the matching *_init() function first.
+ * - Nothing here throws or aborts; failures are reported as negative
+ *   cortix_status values.
+ *
+ * An analyser handle must not be used from two threads at once. Pool
+ * functions are thread-safe, except that a stream must not be removed
+ * while another thread submits to it. Reading a stream's frames while it
+ * is removed is safe; the read sees the frames queued so far or
+ * CORTIX_ERROR_UNKNOWN_STREAM.
+ */
+
+#ifndef CORTIX_C_H
+#define CORTIX_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(CORTIX_C_BUILD)
+#    define CORTIX_C_EXPORT __declspec(dllexport)
+#  else
+#    define CORTIX_C_EXPORT __declspec(dllimport)
+#  endif
+#else
+#  define CORTIX_C_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CORTIX_C_ABI_VERSION 1
+
+typedef enum cortix_status {
+    CORTIX_OK = 0,
+    CORTIX_ERROR_INVALID_ARGUMENT = -1,
+    CORTIX_ERROR_OUT_OF_MEMORY = -2,
+    CORTIX_ERROR_FULL = -3,             /* Queue limit or stream limit reached */
+    CORTIX_ERROR_UNKNOWN_STREAM = -4,
+    CORTIX_ERROR_INTERNAL = -5
+} cortix_status;
+
+typedef enum cortix_scale {
+    CORTIX_SCALE_LINEAR = 0,
+    CORTIX_SCALE_LOG = 1,
+    CORTIX_SCALE_BARK = 2,
+    CORTIX_SCALE_ERB = 3,
+    CORTIX_SCALE_MEL = 4
+} cortix_scale;
+
+typedef enum cortix_priority {
+    CORTIX_PRIORITY_REALTIME = 0,
+    CORTIX_PRIORITY_OFFLINE = 1
+} cortix_priority;
+
+typedef struct cortix_config {
+    uint32_t struct_size;               /* sizeof(cortix_config) */
+    float sample_rate;                  /* 48000 */
+    int32_t num_bands;                  /* 40 */
+    int32_t hop_size;                   /* 128 samples per frame */
+    float min_hz;                       /* 20 */
+    float max_hz;                       /* 20000, capped at sample_rate / 2 */
+    float smoothing_ms;                 /* 5 */
+    int32_t scale;                      /* cortix_scale, CORTIX_SCALE_ERB */
+    int32_t max_queued_frames;          /* 1024 frames held for read_frames() */
+} cortix_config;
+
+typedef struct cortix_pool_config {
+    uint32_t struct_size;               /* sizeof(cortix_pool_config) */
+    int32_t num_threads;                /* 0 = hardware concurrency */
+    int32_t max_streams;                /* 65536 */
+    int64_t max_queued_samples;         /* 48000 per stream before submits are refused */
+    double realtime_budget_ms;          /* 10, deadline of real-time blocks */
+} cortix_pool_config;
+
+typedef struct cortix_analyser cortix_analyser;
+typedef struct cortix_pool cortix_pool;
+
+/* One block for cortix_process_batch() */
+typedef struct cortix_packet {
+    cortix_analyser* analyser;
+    const float* samples;               /* Mono */
+    int32_t num_samples;
+} cortix_packet;
+
+typedef struct cortix_pool_stats {
+    int64_t processed_blocks;
+    int64_t rejected_blocks;
+    int64_t realtime_deadline_misses;
+    int64_t offline_deadline_misses;
+    int64_t steals;
+} cortix_pool_stats;
+
+CORTIX_C_EXPORT int cortix_abi_version(void);
+CORTIX_C_EXPORT const char* cortix_version_string(void);
+CORTIX_C_EXPORT const char* cortix_status_string(int status);
+
+CORTIX_C_EXPORT void cortix_config_init(cortix_config* config);
+CORTIX_C_EXPORT void cortix_pool_config_init(cortix_pool_config* config);
+
+/*-------------------------------------------------------------------------
+ * Analyser (one stream, caller's thread)
+ */
+
+/* Returns NULL on invalid configuration or allocation failure */
+CORTIX_C_EXPORT cortix_analyser* cortix_analyser_create(const cortix_config* config);
+CORTIX_C_EXPORT void cortix_analyser_destroy(cortix_analyser* analyser);
+CORTIX_C_EXPORT void cortix_analyser_reset(cortix_analyser* analyser);
+
+CORTIX_C_EXPORT int32_t cortix_analyser_num_bands(const cortix_analyser* analyser);
+CORTIX_C_EXPORT int32_t cortix_analyser_hop_size(const cortix_analyser* analyser);
+
+/* Band centre frequencies (num_bands floats) */
+CORTIX_C_EXPORT cortix_status cortix_analyser_center_hz(const cortix_analyser* analyser, float* out);
+
+/* Process num_frames sample frames of interleaved audio (averaged to mono) */
+CORTIX_C_EXPORT cortix_status cortix_analyser_process_f32(cortix_analyser* analyser, const float* samples,
+                                                          int64_t num_frames, int32_t channels);
+CORTIX_C_EXPORT cortix_status cortix_analyser_process_s16(cortix_analyser* analyser, const int16_t* samples,
+                                                          int64_t num_frames, int32_t channels);
+
+/* Process blocks for many analysers in one call (grouped by design inside) */
+CORTIX_C_EXPORT cortix_status cortix_process_batch(const cortix_packet* packets, int32_t num_packets);
+
+/* Hop frames waiting to be read */
+CORTIX_C_EXPORT int64_t cortix_analyser_frames_available(const cortix_analyser* analyser);
+
+/* Move up to max_frames queued frames out, oldest first: envelopes gets
+ * max_frames * num_bands floats, sample_positions (may be NULL) one entry
+ * per frame. Returns the number of frames read or a negative status. */
+CORTIX_C_EXPORT int64_t cortix_analyser_read_frames(cortix_analyser* analyser, float* envelopes,
+                                                    int64_t* sample_positions, int64_t max_frames);
+
+/* Frames dropped because the queue was full */
+CORTIX_C_EXPORT int64_t cortix_analyser_dropped_frames(const cortix_analyser* analyser);
+
+/* Current envelope (num_bands floats) */
+CORTIX_C_EXPORT cortix_status cortix_analyser_envelope(const cortix_analyser* analyser, float* out);
+
+/*-------------------------------------------------------------------------
+ * Pool (many streams, worker threads)
+ */
+
+CORTIX_C_EXPORT cortix_pool* cortix_pool_create(const cortix_pool_config* config);
+CORTIX_C_EXPORT void cortix_pool_destroy(cortix_pool* pool);
+
+/* Returns a stream id (>= 0) or a negative status */
+CORTIX_C_EXPORT int32_t cortix_pool_add_stream(cortix_pool* pool, const cortix_config* config, int32_t priority);
+CORTIX_C_EXPORT cortix_status cortix_pool_remove_stream(cortix_pool* pool, int32_t stream);
+
+/* Queue a block (copied). CORTIX_ERROR_FULL if the stream's queue is full. */
+CORTIX_C_EXPORT cortix_status cortix_pool_submit_f32(cortix_pool* pool, int32_t stream, const float* samples,
+                                                     int64_t num_frames, int32_t channels);
+CORTIX_C_EXPORT cortix_status cortix_pool_submit_s16(cortix_pool* pool, int32_t stream, const int16_t* samples,
+                                                     int64_t num_frames, int32_t channels);
+
+/* Block until every submitted block has been processed */
+CORTIX_C_EXPORT void cortix_pool_drain(cortix_pool* pool);
+
+CORTIX_C_EXPORT int64_t cortix_pool_frames_available(cortix_pool* pool, int32_t stream);
+CORTIX_C_EXPORT int64_t cortix_pool_read_frames(cortix_pool* pool, int32_t stream, float* envelopes,
+                                                int64_t* sample_positions, int64_t max_frames);
+CORTIX_C_EXPORT int64_t cortix_pool_dropped_frames(cortix_pool* pool, int32_t stream);
+
+CORTIX_C_EXPORT cortix_status cortix_pool_get_stats(const cortix_pool* pool, cortix_pool_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CORTIX_C_H */
@@ -0,0 +1,743 @@
+/*
+ * Cortix - Local Analysis Daemon
+ *
+ * AnalysisServer accepts PCM streams from local processes over a UNIX
+ * domain socket (framed protocol in protocol.h), analyses them on a
+ * shared AnalyserPool and streams envelope frames back to every
+ * connection subscribed to the stream. AnalysisClient is a small
+ * blocking client for the same protocol.
+ *
+ * I/O runs on one thread driven by epoll. Pool workers encode each frame
+ * once and append it to the output buffer of every subscriber; a
+ * connection is handed to the I/O thread (through an eventfd) only when
+ * its buffer goes from empty to non-empty, so frames that pile up while a
+ * write is pending leave in a single write() call. A subscriber that
+ * stops reading loses frames beyond maxOutputBytes instead of stalling
+ * the pool; control replies are never dropped.
+ *
+ * Streams belong to the connection that opened them: only it may feed or
+ * close them, and they are closed when it disconnects (subscribers then
+ * get StreamClosed). Any connection may subscribe to any stream.
+ *
+ * Linux only (epoll, eventfd); not included by cortix.h.
+ */
+
+#pragma once
+
+#include "pool.h"
+#include "protocol.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <algorithm>
+
+namespace cortix {
+
+class AnalysisServer {
+public:
+    struct Config {
+        std::string socketPath = "/tmp/cortixd.sock";
+        AnalyserPool::Config pool;
+        int maxConnections = 1024;
+        size_t maxOutputBytes = 8 << 20;    // Per connection; frames beyond this are dropped
+        int maxBands = 1024;                // Largest stream setup accepted
+        int maxHopSize = 16384;
+    };
+
+    /// Server counters (snapshot)
+    struct Stats {
+        int64_t connections = 0;        // Currently open
+        int64_t streams = 0;            // Currently open
+        int64_t audioBlocks = 0;
+        int64_t rejectedBlocks = 0;     // Refused by pool backpressure
+        int64_t framesQueued = 0;       // Frame messages queued to subscribers
+        int64_t framesDropped = 0;      // ... dropped for slow subscribers
+        int64_t bytesWritten = 0;
+        int64_t writeCalls = 0;
+    };
+
+    explicit AnalysisServer(const Config& config)
+        : config_(config), pool_(std::make_unique<AnalyserPool>(config.pool)) {}
+
+    ~AnalysisServer() {
+        // Stop the workers first: frame callbacks use the connections and the wake fd
+        pool_.reset();
+        for (auto& entry : connections_) ::close(entry.first);
+        if (listenFd_ >= 0) {
+            ::close(listenFd_);
+            ::unlink(config_.socketPath.c_str());
+        }
+        if (wakeFd_ >= 0) ::close(wakeFd_);
+        if (epollFd_ >= 0) ::close(epollFd_);
+    }
+
+    AnalysisServer(const AnalysisServer&) = delete;
+    AnalysisServer& operator=(const AnalysisServer&) = delete;
+
+    /// Bind and listen on the socket path (replacing a stale socket file).
+    /// Returns false on failure, with errno set.
+    bool start() {
+        sockaddr_un addr{};
+        if (config_.socketPath.empty() || config_.socketPath.size() >= sizeof(addr.sun_path)) {
+            errno = ENAMETOOLONG;
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, config_.socketPath.c_str(), config_.socketPath.size());
+
+        listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd_ < 0) return false;
+        ::unlink(config_.socketPath.c_str());
+        if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) return false;
+        if (::listen(listenFd_, 128) < 0) return false;
+
+        epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd_ < 0 || wakeFd_ < 0) return false;
+        return watch(listenFd_, EPOLLIN, EPOLL_CTL_ADD) && watch(wakeFd_, EPOLLIN, EPOLL_CTL_ADD);
+    }
+
+    /// Serve until stop()
+    void run() {
+        while (poll(-1)) {}
+    }
+
+    /// One round of I/O. Returns false once stop() has been called.
+    bool poll(int timeoutMs) {
+        if (stopping_.load(std::memory_order_acquire)) return false;
+        // Closed streams with a block still running are retried shortly
+        if (!closing_.empty() && (timeoutMs < 0 || timeoutMs > kReapMs)) timeoutMs = kReapMs;
+        epoll_event events[64];
+        const int n = ::epoll_wait(epollFd_, events, 64, timeoutMs);
+        for (int i = 0; i < n; i++) {
+            const int fd = events[i].data.fd;
+            if (fd == listenFd_) {
+                accept();
+            } else if (fd == wakeFd_) {
+                uint64_t count;
+                while (::read(wakeFd_, &count, sizeof(count)) > 0) {}
+            } else {
+                auto it = connections_.find(fd);
+                if (it == connections_.end()) continue;
+                std::shared_ptr<Connection> c = it->second;
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    if (!readFrom(*c)) {
+                        closeConnection(c);
+                        continue;
+                    }
+                }
+                if (!flush(*c)) closeConnection(c);
+            }
+        }
+        flushDirty();
+        reapClosing();
+        return !stopping_.load(std::memory_order_acquire);
+    }
+
+    /// Ask run() to return. Safe from other threads and signal handlers.
+    void stop() {
+        stopping_.store(true, std::memory_order_release);
+        wake();
+    }
+
+    Stats stats() const {
+        Stats stats;
+        stats.connections = numConnections_.load(std::memory_order_relaxed);
+        stats.streams = numStreams_.load(std::memory_order_relaxed);
+        stats.audioBlocks = audioBlocks_.load(std::memory_order_relaxed);
+        stats.rejectedBlocks = rejectedBlocks_.load(std::memory_order_relaxed);
+        stats.framesQueued = framesQueued_.load(std::memory_order_relaxed);
+        stats.framesDropped = framesDropped_.load(std::memory_order_relaxed);
+        stats.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+        stats.writeCalls = writeCalls_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    AnalyserPool& pool() { return *pool_; }
+    const std::string& socketPath() const { return config_.socketPath; }
+
+private:
+    static constexpr size_t kCompactBytes = 64 << 10;  // Sent prefix worth erasing
+    static constexpr int kReapMs = 2;                   // Poll interval while streams are closing
+
+    struct Connection {
+        int fd = -1;
+        protocol::MessageParser input;
+        std::vector<uint32_t> owned;        // Streams opened here (I/O thread only)
+        std::vector<uint32_t> subscribed;   // (I/O thread only)
+        bool writeArmed = false;            // EPOLLOUT requested (I/O thread only)
+        std::atomic<bool> closed{false};
+
+        std::mutex outMutex;                // Guards the fields below
+        std::vector<uint8_t> output;
+        size_t written = 0;                 // Bytes of output already sent
+        bool dirty = false;                 // Queued for the I/O thread
+    };
+
+    struct StreamEntry {
+        uint32_t id = 0;
+        int numBands = 0;
+        int hopSize = 0;
+        Connection* owner = nullptr;
+        std::mutex mutex;                   // Guards subscribers
+        std::vector<std::shared_ptr<Connection>> subscribers;
+    };
+
+    bool watch(int fd, uint32_t events, int op) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        return ::epoll_ctl(epollFd_, op, fd, &ev) == 0;
+    }
+
+    void wake() {
+        const uint64_t one = 1;
+        if (wakeFd_ >= 0) {
+            ssize_t r = ::write(wakeFd_, &one, sizeof(one));
+            (void)r;
+        }
+    }
+
+    void accept() {
+        for (;;) {
+            const int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            if (static_cast<int>(connections_.size()) >= config_.maxConnections || !watch(fd, EPOLLIN, EPOLL_CTL_ADD)) {
+                ::close(fd);
+                continue;
+            }
+            auto c = std::make_shared<Connection>();
+            c->fd = fd;
+            connections_[fd] = std::move(c);
+            numConnections_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /// Read and handle what is available (a bounded amount, so one busy
+    /// client cannot starve the others). False on EOF or a framing error.
+    bool readFrom(Connection& c) {
+        uint8_t buffer[65536];
+        for (int reads = 0; reads < 16; reads++) {
+            const ssize_t n = ::recv(c.fd, buffer, sizeof(buffer), 0);
+            if (n == 0) return false;
+            if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+            c.input.append(buffer, static_cast<size_t>(n));
+            protocol::Message message;
+            while (c.input.next(message)) {
+                handle(c, message);
+            }
+            if (c.input.failed()) return false;
+        }
+        return true;
+    }
+
+    void handle(Connection& c, const protocol::Message& message) {
+        using protocol::MessageType;
+        using protocol::ErrorCode;
+        protocol::PayloadReader in(message);
+
+        switch (message.type) {
+            case MessageType::OpenStream: {
+                const uint32_t tag = in.u32();
+                protocol::StreamSetup setup;
+                const bool valid = in.readSetup(setup);
+                setup.maxHz = std::min(setup.maxHz, 0.5f * setup.sampleRate);
+                if (!valid || setup.maxHz <= setup.minHz || setup.numBands > config_.maxBands ||
+                    setup.hopSize > config_.maxHopSize) {
+                    reply(c, [&](protocol::MessageWriter& w) { w.error(ErrorCode::BadMessage, tag, "invalid stream setup"); });
+                    return;
+                }
+                openStream(c, tag, setup);
+                return;
+            }
+            case MessageType::Audio: {
+                const uint32_t id = in.u32();
+                const int numSamples = static_cast<int>(in.remaining() / 4);
+                StreamEntry* entry = find(c, id, true);
+                if (!entry || !in.ok()) return;
+                samples_.resize(static_cast<size_t>(numSamples));
+                in.floats(samples_.data(), numSamples);
+                audioBlocks_.fetch_add(1, std::memory_order_relaxed);
+                if (numSamples > 0 && !pool_->submit(static_cast<AnalyserPool::StreamId>(id), samples_.data(), numSamples)) {
+                    rejectedBlocks_.fetch_add(1, std::memory_order_relaxed);
+                    reply(c, [&](protocol::MessageWriter& w) { w.error(ErrorCode::Backpressure, id, "audio block dropped"); });
+                }
+                return;
+            }
+            case MessageType::Subscribe: {
+                const uint32_t id = in.u32();
+                StreamEntry* entry = find(c, id, false);
+                if (!entry) return;
+                if (std::find(c.subscribed.begin(), c.subscribed.end(), id) == c.subscribed.end()) {
+                    c.subscribed.push_back(id);
+                    std::lock_guard<std::mutex> lock(entry->mutex);
+                    entry->subscribers.push_back(connections_[c.fd]);
+                }
+                // Frames follow the acknowledgement
+                reply(c, [&](protocol::MessageWriter& w) { w.subscribed(id, entry->numBands, entry->hopSize); });
+                return;
+            }
+            case MessageType::Unsubscribe: {
+                const uint32_t id = in.u32();
+                StreamEntry* entry = find(c, id, false);
+                if (entry) unsubscribe(c, *entry);
+                return;
+            }
+            case MessageType::CloseStream: {
+                const uint32_t id = in.u32();
+                if (find(c, id, true)) closeStream(id);
+                return;
+            }
+            default:
+                reply(c, [&](protocol::MessageWriter& w) { w.error(ErrorCode::BadMessage, 0, "unexpected message type"); });
+                return;
+        }
+    }
+
+    void openStream(Connection& c, uint32_t tag, const protocol::StreamSetup& setup) {
+        // Streams with identical settings share a pool design, so they batch
+        AnalyserPool::DesignId design = -1;
+        for (const auto& d : designs_) {
+            const protocol::StreamSetup& s = d.first;
+            if (s.sampleRate == setup.sampleRate && s.numBands == setup.numBands && s.hopSize == setup.hopSize &&
+                s.minHz == setup.minHz && s.maxHz == setup.maxHz && s.scale == setup.scale) {
+                design = d.second;
+                break;
+            }
+        }
+        if (design < 0) {
+            Analyser::Config config;
+            config.sampleRate = setup.sampleRate;
+            config.numBands = setup.numBands;
+            config.hopSize = setup.hopSize;
+            config.minHz = setup.minHz;
+            config.maxHz = setup.maxHz;
+            config.scale = setup.scale;
+            design = pool_->addDesign(config);
+            designs_.emplace_back(setup, design);
+        }
+
+        const AnalyserPool::StreamId id = pool_->addStream(
+            design, setup.realTime ? AnalyserPool::Priority::RealTime : AnalyserPool::Priority::Offline);
+        if (id < 0) {
+            reply(c, [&](protocol::MessageWriter& w) { w.error(protocol::ErrorCode::TooManyStreams, tag, "stream limit reached"); });
+            return;
+        }
+
+        auto entry = std::make_unique<StreamEntry>();
+        entry->id = static_cast<uint32_t>(id);
+        entry->numBands = setup.numBands;
+        entry->hopSize = setup.hopSize;
+        entry->owner = &c;
+        StreamEntry* e = entry.get();
+        pool_->setFrameCallback(id, [this, e](const Analyser::Frame& frame) { publish(*e, frame); });
+        streams_[entry->id] = std::move(entry);
+        c.owned.push_back(static_cast<uint32_t>(id));
+        numStreams_.fetch_add(1, std::memory_order_relaxed);
+
+        reply(c, [&](protocol::MessageWriter& w) {
+            w.streamOpened(tag, static_cast<uint32_t>(id), setup.numBands, setup.hopSize);
+        });
+    }
+
+    /// Look up a stream for a request, replying with an error if it fails
+    StreamEntry* find(Connection& c, uint32_t id, bool mustOwn) {
+        auto it = streams_.find(id);
+        if (it == streams_.end()) {
+            reply(c, [&](protocol::MessageWriter& w) { w.error(protocol::ErrorCode::UnknownStream, id, "unknown stream"); });
+            return nullptr;
+        }
+        if (mustOwn && it->second->owner != &c) {
+            reply(c, [&](protocol::MessageWriter& w) { w.error(protocol::ErrorCode::NotOwner, id, "stream owned by another connection"); });
+            return nullptr;
+        }
+        return it->second.get();
+    }
+
+    void unsubscribe(Connection& c, StreamEntry& entry) {
+        c.subscribed.erase(std::remove(c.subscribed.begin(), c.subscribed.end(), entry.id), c.subscribed.end());
+        std::lock_guard<std::mutex> lock(entry.mutex);
+        auto& subs = entry.subscribers;
+        subs.erase(std::remove_if(subs.begin(), subs.end(),
+                                  [&](const std::shared_ptr<Connection>& s) { return s.get() == &c; }),
+                   subs.end());
+    }
+
+    void closeStream(uint32_t id) {
+        auto it = streams_.find(id);
+        if (it == streams_.end()) return;
+        StreamEntry& entry = *it->second;
+
+        // Never wait here for a running block: that would stall every
+        // connection. Its callback finds no subscribers left below, and the
+        // entry is kept in closing_ until the pool lets go of it.
+        const bool released = pool_->tryRemoveStream(static_cast<AnalyserPool::StreamId>(id));
+
+        std::vector<std::shared_ptr<Connection>> subscribers;
+        {
+            std::lock_guard<std::mutex> lock(entry.mutex);
+            subscribers.swap(entry.subscribers);
+        }
+        for (auto& s : subscribers) {
+            s->subscribed.erase(std::remove(s->subscribed.begin(), s->subscribed.end(), id), s->subscribed.end());
+            if (s->closed) continue;
+            reply(*s, [&](protocol::MessageWriter& w) { w.streamCommand(protocol::MessageType::StreamClosed, id); });
+        }
+        Connection* owner = entry.owner;
+        owner->owned.erase(std::remove(owner->owned.begin(), owner->owned.end(), id), owner->owned.end());
+        if (!released) closing_.push_back(std::move(it->second));
+        streams_.erase(it);
+        numStreams_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// Free closed streams whose last block has finished
+    void reapClosing() {
+        closing_.erase(std::remove_if(closing_.begin(), closing_.end(),
+                                      [this](const std::unique_ptr<StreamEntry>& e) {
+                                          return pool_->tryRemoveStream(static_cast<AnalyserPool::StreamId>(e->id));
+                                      }),
+                       closing_.end());
+    }
+
+    void closeConnection(const std::shared_ptr<Connection>& c) {
+        if (c->closed.exchange(true)) return;
+        const std::vector<uint32_t> owned = c->owned;
+        for (uint32_t id : owned) closeStream(id);
+        const std::vector<uint32_t> subscribed = c->subscribed;
+        for (uint32_t id : subscribed) {
+            auto it = streams_.find(id);
+            if (it != streams_.end()) unsubscribe(*c, *it->second);
+        }
+        ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, c->fd, nullptr);
+        ::close(c->fd);
+        connections_.erase(c->fd);
+        numConnections_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// Frame callback, on a pool worker: encode once, queue for every subscriber
+    void publish(StreamEntry& entry, const Analyser::Frame& frame) {
+        thread_local std::vector<uint8_t> encoded;
+        encoded.clear();
+        protocol::MessageWriter(encoded).frame(entry.id, frame.index, frame.samplePosition,
+                                               frame.envelope, frame.numBands);
+        std::lock_guard<std::mutex> lock(entry.mutex);
+        for (const auto& s : entry.subscribers) {
+            if (queue(s, encoded, true)) {
+                framesQueued_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                framesDropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Append bytes to a connection's output; hand it to the I/O thread if
+    /// it was idle. Droppable data is refused beyond maxOutputBytes.
+    bool queue(const std::shared_ptr<Connection>& c, const std::vector<uint8_t>& bytes, bool droppable) {
+        bool wakeup = false;
+        {
+            std::lock_guard<std::mutex> lock(c->outMutex);
+            if (c->closed.load(std::memory_order_relaxed)) return false;
+            if (droppable && c->output.size() - c->written + bytes.size() > config_.maxOutputBytes) return false;
+            c->output.insert(c->output.end(), bytes.begin(), bytes.end());
+            if (!c->dirty) {
+                c->dirty = true;
+                std::lock_guard<std::mutex> dirtyLock(dirtyMutex_);
+                wakeup = dirty_.empty();
+                dirty_.push_back(c);
+            }
+        }
+        if (wakeup) wake();
+        return true;
+    }
+
+    /// Queue a control reply (I/O thread; never dropped)
+    template <typename Encode>
+    void reply(Connection& c, Encode encode) {
+        replyBuffer_.clear();
+        protocol::MessageWriter w(replyBuffer_);
+        encode(w);
+        auto it = connections_.find(c.fd);
+        if (it != connections_.end()) queue(it->second, replyBuffer_, false);
+    }
+
+    void flushDirty() {
+        std::vector<std::shared_ptr<Connection>> dirty;
+        {
+            std::lock_guard<std::mutex> lock(dirtyMutex_);
+            dirty.swap(dirty_);
+        }
+        for (auto& c : dirty) {
+            if (c->closed) continue;
+            if (!flush(*c)) closeConnection(c);
+        }
+    }
+
+    /// Write pending output without blocking. False if the peer is gone.
+    bool flush(Connection& c) {
+        std::lock_guard<std::mutex> lock(c.outMutex);
+        while (c.written < c.output.size()) {
+            const ssize_t n = ::send(c.fd, c.output.data() + c.written, c.output.size() - c.written,
+                                     MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+                if (!c.writeArmed) {
+                    c.writeArmed = watch(c.fd, EPOLLIN | EPOLLOUT, EPOLL_CTL_MOD);
+                }
+                // A subscriber that never fully drains would otherwise grow
+                // the buffer forever: drop the sent prefix once it dominates
+                if (c.written >= kCompactBytes && 2 * c.written >= c.output.size()) {
+                    c.output.erase(c.output.begin(), c.output.begin() + static_cast<std::ptrdiff_t>(c.written));
+                    c.written = 0;
+                }
+                return true;        // Stays dirty until EPOLLOUT
+            }
+            c.written += static_cast<size_t>(n);
+            bytesWritten_.fetch_add(n, std::memory_order_relaxed);
+            writeCalls_.fetch_add(1, std::memory_order_relaxed);
+        }
+        c.output.clear();
+        c.written = 0;
+        c.dirty = false;
+        if (c.writeArmed) {
+            watch(c.fd, EPOLLIN, EPOLL_CTL_MOD);
+            c.writeArmed = false;
+        }
+        return true;
+    }
+
+    Config config_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+    std::atomic<bool> stopping_{false};
+
+    std::unordered_map<int, std::shared_ptr<Connection>> connections_;     // By fd (I/O thread)
+    std::unordered_map<uint32_t, std::unique_ptr<StreamEntry>> streams_;   // By id (I/O thread)
+    std::vector<std::unique_ptr<StreamEntry>> closing_;   // Closed, block still running (I/O thread)
+    std::vector<std::pair<protocol::StreamSetup, AnalyserPool::DesignId>> designs_;
+    std::vector<float> samples_;
+    std::vector<uint8_t> replyBuffer_;
+
+    std::mutex dirtyMutex_;
+    std::vector<std::shared_ptr<Connection>> dirty_;   // Output waiting for the I/O thread
+
+    std::atomic<int64_t> numConnections_{0};
+    std::atomic<int64_t> numStreams_{0};
+    std::atomic<int64_t> audioBlocks_{0};
+    std::atomic<int64_t> rejectedBlocks_{0};
+    std::atomic<int64_t> framesQueued_{0};
+    std::atomic<int64_t> framesDropped_{0};
+    std::atomic<int64_t> bytesWritten_{0};
+    std::atomic<int64_t> writeCalls_{0};
+
+    std::unique_ptr<AnalyserPool> pool_;    // Declared last: its workers call into the members above
+};
+
+//=============================================================================
+// Blocking client
+//=============================================================================
+
+class AnalysisClient {
+public:
+    struct ReceivedFrame {
+        uint32_t stream = 0;
+        int64_t index = 0;
+        int64_t samplePosition = 0;
+        std::vector<float> envelope;
+    };
+
+    struct Error {
+        protocol::ErrorCode code = protocol::ErrorCode::BadMessage;
+        uint32_t subject = 0;           // Request tag or stream id
+        std::string message;
+    };
+
+    AnalysisClient() = default;
+    ~AnalysisClient() { close(); }
+
+    AnalysisClient(const AnalysisClient&) = delete;
+    AnalysisClient& operator=(const AnalysisClient&) = delete;
+
+    bool connect(const std::string& socketPath) {
+        close();
+        sockaddr_un addr{};
+        if (socketPath.size() >= sizeof(addr.sun_path)) return false;
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size());
+        fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) return false;
+        if (::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        input_ = protocol::MessageParser();
+        frames_.clear();
+    }
+
+    bool connected() const { return fd_ >= 0; }
+
+    /// Open a stream; returns its id, or -1 on error or timeout
+    int64_t openStream(const protocol::StreamSetup& setup, int timeoutMs = 5000) {
+        const uint32_t tag = nextTag_++;
+        out_.clear();
+        protocol::MessageWriter(out_).openStream(tag, setup);
+        if (!send()) return -1;
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        protocol::Message message;
+        while (receive(message, deadline)) {
+            if (message.type == protocol::MessageType::StreamOpened) {
+                protocol::PayloadReader in(message);
+                if (in.u32() == tag) return in.u32();
+            } else if (message.type == protocol::MessageType::Error && errors_.back().subject == tag) {
+                return -1;
+            }
+        }
+        return -1;
+    }
+
+    /// Subscribe to a stream and wait for the acknowledgement; every frame
+    /// the stream produces after that is delivered
+    bool subscribe(uint32_t stream, int timeoutMs = 5000) {
+        if (!command(protocol::MessageType::Subscribe, stream)) return false;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        protocol::Message message;
+        while (receive(message, deadline)) {
+            protocol::PayloadReader in(message);
+            if (message.type == protocol::MessageType::Subscribed && in.u32() == stream) return true;
+            if (message.type == protocol::MessageType::Error && errors_.back().subject == stream) return false;
+        }
+        return false;
+    }
+
+    bool unsubscribe(uint32_t stream) { return command(protocol::MessageType::Unsubscribe, stream); }
+    bool closeStream(uint32_t stream) { return command(protocol::MessageType::CloseStream, stream); }
+
+    bool sendAudio(uint32_t stream, const float* samples, int numSamples) {
+        out_.clear();
+        protocol::MessageWriter(out_).audio(stream, samples, numSamples);
+        return send();
+    }
+
+    /// Next frame of any subscribed stream; false on timeout or disconnect
+    bool readFrame(ReceivedFrame& frame, int timeoutMs = 5000) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        protocol::Message message;
+        while (frames_.empty() && receive(message, deadline)) {}
+        if (frames_.empty()) return false;
+        frame = std::move(frames_.front());
+        frames_.pop_front();
+        return true;
+    }
+
+    /// Errors reported by the server so far
+    const std::vector<Error>& errors() const { return errors_; }
+
+    /// Streams the server reported closed
+    const std::vector<uint32_t>& closedStreams() const { return closed_; }
+
+    /// Handle whatever arrives within the timeout (errors, closed streams,
+    /// frames queued for readFrame)
+    void pump(int timeoutMs) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        protocol::Message message;
+        while (receive(message, deadline)) {}
+    }
+
+private:
+    bool command(protocol::MessageType type, uint32_t stream) {
+        out_.clear();
+        protocol::MessageWriter(out_).streamCommand(type, stream);
+        return send();
+    }
+
+    bool send() {
+        size_t sent = 0;
+        while (fd_ >= 0 && sent < out_.size()) {
+            const ssize_t n = ::send(fd_, out_.data() + sent, out_.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return fd_ >= 0;
+    }
+
+    /// Receive one message before the deadline. Frames, errors and close
+    /// notices are also recorded.
+    bool receive(protocol::Message& message, std::chrono::steady_clock::time_point deadline) {
+        while (fd_ >= 0 && !input_.next(message)) {
+            if (input_.failed()) return false;
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            pollfd p{fd_, POLLIN, 0};
+            if (left <= 0 || ::poll(&p, 1, static_cast<int>(left)) <= 0) return false;
+            uint8_t buffer[65536];
+            const ssize_t n = ::recv(fd_, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) continue;
+                return false;
+            }
+            input_.append(buffer, static_cast<size_t>(n));
+        }
+        if (fd_ < 0) return false;
+
+        protocol::PayloadReader in(message);
+        switch (message.type) {
+            case protocol::MessageType::Frame: {
+                ReceivedFrame frame;
+                frame.stream = in.u32();
+                frame.index = in.i64();
+                frame.samplePosition = in.i64();
+                const int numBands = in.u16();
+                if (in.u16() != static_cast<uint16_t>(protocol::FrameEncoding::Float32)) break;  // The server sends float32
+                frame.envelope.resize(numBands);
+                if (in.floats(frame.envelope.data(), numBands)) frames_.push_back(std::move(frame));
+                break;
+            }
+            case protocol::MessageType::Error: {
+                Error error;
+                error.code = static_cast<protocol::ErrorCode>(in.u32());
+                error.subject = in.u32();
+                error.message = in.text();
+                errors_.push_back(error);
+                break;
+            }
+            case protocol::MessageType::StreamClosed:
+                closed_.push_back(in.u32());
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    int fd_ = -1;
+    uint32_t nextTag_ = 1;
+    protocol::MessageParser input_;
+    std::vector<uint8_t> out_;
+    std::deque<ReceivedFrame> frames_;
+    std::vector<Error> errors_;
+    std::vector<uint32_t> closed_;
+};
+
+} // namespace cortix
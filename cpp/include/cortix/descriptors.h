@@ -0,0 +1,246 @@
+/*
+ * Cortix - Spectral Descriptors
+ *
+ * Per-hop centroid, spread, flatness, rolloff and slope computed from the
+ * band envelope. Bands are treated as spectral samples at BandInfo::centerHz
+ * with a weight proportional to BandInfo::bandwidthHz, so the results
+ * approximate the linear-frequency definitions for any band scale.
+ *
+ * All moment and log sums are gathered in a single fused pass that keeps
+ * kLanes independent partial sums, which lets the compiler vectorize the
+ * reductions without fast-math. Rolloff needs a cumulative sum and does a
+ * short extra scan when enabled. Results are kept in a struct-of-arrays
+ * ring so dashboards can read a whole column at once.
+ */
+
+#pragma once
+
+#include "scales.h"
+#include "fastmath.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace cortix {
+
+struct DescriptorFrame {
+    float centroidHz = 0.0f;
+    float spreadHz = 0.0f;
+    float flatness = 0.0f;          // Geometric / arithmetic mean, 0..1
+    float rolloffHz = 0.0f;
+    float slopeDbPerOctave = 0.0f;  // Regression of level on log2(frequency)
+};
+
+/// Struct-of-arrays time series of descriptor frames.
+/// Each column is a ring of `capacity` frames; disabled columns are empty.
+struct DescriptorSeries {
+    std::vector<float> centroidHz;
+    std::vector<float> spreadHz;
+    std::vector<float> flatness;
+    std::vector<float> rolloffHz;
+    std::vector<float> slopeDbPerOctave;
+    int capacity = 0;
+    int count = 0;      // Valid frames, up to capacity
+    int next = 0;       // Slot the next frame is written to
+
+    /// Slot of the frame `age` hops back (0 = most recent)
+    int slot(int age) const { return (next - 1 - age + 2 * capacity) % capacity; }
+};
+
+class SpectralDescriptors {
+public:
+    static constexpr int kLanes = 8;
+
+    struct Config {
+        bool centroid = true;
+        bool spread = true;
+        bool flatness = true;
+        bool rolloff = true;
+        bool slope = true;
+        float rolloffFraction = 0.85f;
+        int historyLength = 512;    // Frames kept in the series ring
+        float floor = 1e-12f;       // Added to band power before logs
+    };
+
+    SpectralDescriptors() = default;
+
+    SpectralDescriptors(const Config& config, const std::vector<BandInfo>& bands) {
+        configure(config, bands);
+    }
+
+    void configure(const Config& config, const std::vector<BandInfo>& bands) {
+        config_ = config;
+        numBands_ = static_cast<int>(bands.size());
+
+        // Pad to a whole number of lanes with zero-weight bands
+        const int padded = (numBands_ + kLanes - 1) / kLanes * kLanes;
+        freq_.assign(padded, 0.0f);
+        freqSq_.assign(padded, 0.0f);
+        octave_.assign(padded, 0.0f);
+        weight_.assign(padded, 0.0f);
+        power_.assign(padded, 0.0f);
+
+        float totalWidth = 0.0f;
+        for (const auto& b : bands) totalWidth += b.bandwidthHz;
+
+        for (int b = 0; b < numBands_; b++) {
+            freq_[b] = bands[b].centerHz;
+            freqSq_[b] = bands[b].centerHz * bands[b].centerHz;
+            octave_[b] = std::log2(std::max(bands[b].centerHz, 1.0f));
+            weight_[b] = totalWidth > 0.0f ? bands[b].bandwidthHz / totalWidth : 0.0f;
+        }
+
+        // Weighted regression constants for the slope (weights sum to 1)
+        float sx = 0.0f, sxx = 0.0f;
+        for (int b = 0; b < numBands_; b++) {
+            sx += weight_[b] * octave_[b];
+            sxx += weight_[b] * octave_[b] * octave_[b];
+        }
+        meanOctave_ = sx;
+        const float var = sxx - sx * sx;
+        invOctaveVar_ = var > 1e-9f ? 1.0f / var : 0.0f;
+
+        const int cap = std::max(1, config.historyLength);
+        series_ = DescriptorSeries{};
+        series_.capacity = cap;
+        if (config.centroid) series_.centroidHz.assign(cap, 0.0f);
+        if (config.spread) series_.spreadHz.assign(cap, 0.0f);
+        if (config.flatness) series_.flatness.assign(cap, 0.0f);
+        if (config.rolloff) series_.rolloffHz.assign(cap, 0.0f);
+        if (config.slope) series_.slopeDbPerOctave.assign(cap, 0.0f);
+
+        reset();
+    }
+
+    void reset() {
+        current_ = DescriptorFrame{};
+        series_.count = 0;
+        series_.next = 0;
+    }
+
+    /// Compute descriptors for one envelope frame and append them to the series
+    const DescriptorFrame& process(const float* envelope) {
+        current_ = compute(envelope);
+        append(series_, series_.next, current_);
+        series_.next = (series_.next + 1) % series_.capacity;
+        series_.count = std::min(series_.count + 1, series_.capacity);
+        return current_;
+    }
+
+    /// Offline variant: fill `out` with one entry per frame of a
+    /// numFrames x numBands envelope matrix, in chronological order.
+    void processBatch(const float* envelopes, int numFrames, DescriptorSeries& out) {
+        out = DescriptorSeries{};
+        out.capacity = std::max(1, numFrames);
+        if (config_.centroid) out.centroidHz.assign(out.capacity, 0.0f);
+        if (config_.spread) out.spreadHz.assign(out.capacity, 0.0f);
+        if (config_.flatness) out.flatness.assign(out.capacity, 0.0f);
+        if (config_.rolloff) out.rolloffHz.assign(out.capacity, 0.0f);
+        if (config_.slope) out.slopeDbPerOctave.assign(out.capacity, 0.0f);
+
+        for (int t = 0; t < numFrames; t++) {
+            append(out, t, compute(envelopes + static_cast<size_t>(t) * numBands_));
+        }
+        out.count = numFrames;
+        out.next = 0;
+    }
+
+    /// Descriptors of the last processed frame
+    const DescriptorFrame& current() const { return current_; }
+
+    /// Ring of recent frames, one column per enabled descriptor
+    const DescriptorSeries& series() const { return series_; }
+
+private:
+    DescriptorFrame compute(const float* envelope) {
+        const int padded = static_cast<int>(power_.size());
+        for (int b = 0; b < numBands_; b++) {
+            power_[b] = envelope[b] * envelope[b];
+        }
+
+        const bool needLog = config_.flatness || config_.slope;
+
+        // Fused pass: lane-wise partial sums of every moment we need
+        float s0[kLanes] = {}, s1[kLanes] = {}, s2[kLanes] = {};
+        float sl[kLanes] = {}, sxl[kLanes] = {};
+        for (int b = 0; b < padded; b += kLanes) {
+            for (int j = 0; j < kLanes; j++) {
+                const float w = weight_[b + j];
+                const float wp = w * power_[b + j];
+                s0[j] += wp;
+                s1[j] += wp * freq_[b + j];
+                s2[j] += wp * freqSq_[b + j];
+            }
+            if (needLog) {
+                for (int j = 0; j < kLanes; j++) {
+                    const float w = weight_[b + j];
+                    const float l = fastLog2(power_[b + j] + config_.floor);
+                    sl[j] += w * l;
+                    sxl[j] += w * octave_[b + j] * l;
+                }
+            }
+        }
+
+        float total = 0.0f, m1 = 0.0f, m2 = 0.0f, logMean = 0.0f, xLog = 0.0f;
+        for (int j = 0; j < kLanes; j++) {
+            total += s0[j];
+            m1 += s1[j];
+            m2 += s2[j];
+            logMean += sl[j];
+            xLog += sxl[j];
+        }
+
+        DescriptorFrame f;
+        if (total <= config_.floor) return f;
+
+        const float inv = 1.0f / total;
+        const float centroid = m1 * inv;
+        f.centroidHz = centroid;
+        f.spreadHz = std::sqrt(std::max(m2 * inv - centroid * centroid, 0.0f));
+
+        if (config_.flatness) {
+            f.flatness = std::min(std::exp2(logMean) * inv, 1.0f);
+        }
+        if (config_.slope) {
+            // Weighted covariance of level (dB) and octave position
+            const float cov = xLog - meanOctave_ * logMean;
+            f.slopeDbPerOctave = 3.01029996f * cov * invOctaveVar_;
+        }
+        if (config_.rolloff) {
+            const float target = config_.rolloffFraction * total;
+            float cum = 0.0f;
+            f.rolloffHz = freq_[std::max(numBands_ - 1, 0)];
+            for (int b = 0; b < numBands_; b++) {
+                cum += weight_[b] * power_[b];
+                if (cum >= target) {
+                    f.rolloffHz = freq_[b];
+                    break;
+                }
+            }
+        }
+        return f;
+    }
+
+    void append(DescriptorSeries& s, int slot, const DescriptorFrame& f) const {
+        if (config_.centroid) s.centroidHz[slot] = f.centroidHz;
+        if (config_.spread) s.spreadHz[slot] = f.spreadHz;
+        if (config_.flatness) s.flatness[slot] = f.flatness;
+        if (config_.rolloff) s.rolloffHz[slot] = f.rolloffHz;
+        if (config_.slope) s.slopeDbPerOctave[slot] = f.slopeDbPerOctave;
+    }
+
+    Config config_;
+    int numBands_ = 0;
+    std::vector<float> freq_;       // Padded to kLanes
+    std::vector<float> freqSq_;
+    std::vector<float> octave_;
+    std::vector<float> weight_;     // Normalized bandwidth
+    std::vector<float> power_;
+    float meanOctave_ = 0.0f;
+    float invOctaveVar_ = 0.0f;
+
+    DescriptorFrame current_;
+    DescriptorSeries series_;
+};
+
+} // namespace cortix
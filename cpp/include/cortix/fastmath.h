@@ -0,0 +1,60 @@
+/*
+ * Cortix - Fast Math Approximations
+ *
+ * Branch-free approximations for per-hop feature stages, written so that
+ * loops calling them auto-vectorize. Accuracy is well below the
+ * resolution that matters for spectral features (dB, cepstra).
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace cortix {
+
+/// log2(x) for normal x > 0, max abs error ~3e-5
+inline float fastLog2(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    const float exponent = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+
+    // Mantissa mapped to [1, 2), polynomial fitted to log2(1 + m)
+    bits = (bits & 0x007fffffu) | 0x3f800000u;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+    m -= 1.0f;
+
+    const float p = m * (1.4418255f + m * (-0.708678912f + m * (0.415411186f +
+                    m * (-0.194408323f + m * 0.0458789501f))));
+    return exponent + p;
+}
+
+/// Natural log, see fastLog2
+inline float fastLog(float x) {
+    return 0.693147181f * fastLog2(x);
+}
+
+/// 10 * log10(x), i.e. power to dB
+inline float fastPowerToDb(float x) {
+    return 3.01029996f * fastLog2(x);
+}
+
+/// 2^x for x in [-126, 127], max rel error ~4e-6
+inline float fastExp2(float x) {
+    // Adding 1.5 * 2^23 rounds x to an integer k held in the low mantissa bits
+    const float shifted = x + 12582912.0f;
+    uint32_t bits;
+    std::memcpy(&bits, &shifted, sizeof(bits));
+    const float f = x - (shifted - 12582912.0f);
+
+    // Taylor series of 2^f on [-0.5, 0.5]; 2^k built directly as exponent bits
+    const float p = 1.0f + f * (0.693147181f + f * (0.240226507f + f * (0.0555041087f +
+                    f * (0.00961812911f + f * 0.00133335581f))));
+    bits = (bits + 127u) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return scale * p;
+}
+
+} // namespace cortix
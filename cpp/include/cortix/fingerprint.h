@@ -0,0 +1,459 @@
+/*
+ * Cortix - Audio Fingerprinting
+ *
+ * Landmark fingerprints in the style of Wang (2003), built on the band
+ * envelope instead of an STFT.
+ *
+ * FingerprintExtractor max-pools the envelope over a few hops into
+ * fingerprint frames, picks constellation peaks (local maxima across bands
+ * that rise above a decaying, spread masking threshold, after Ellis 2009)
+ * and pairs each new peak with earlier peaks in a target zone. Every pair
+ * becomes a Landmark: a 32-bit hash of (anchor band, band delta, frame
+ * delta) plus the anchor time. The cost per hop is O(bands), and O(peaks x
+ * fan-out) at frame boundaries.
+ *
+ * FingerprintIndex stores landmarks in an open-addressing hash table
+ * (linear probing, equal hashes share a probe run) and answers queries by
+ * voting on (track, time offset): a clip taken from an indexed track
+ * produces many landmarks that agree on one offset. Queries are const and
+ * keep their votes in a QueryScratch, so threads can share one index.
+ */
+
+#pragma once
+
+#include "fastmath.h"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <istream>
+#include <ostream>
+
+namespace cortix {
+
+struct Landmark {
+    uint32_t hash = 0;      // Anchor band, band delta and frame delta
+    int32_t time = 0;       // Anchor fingerprint frame
+};
+
+//=============================================================================
+// Landmark Extraction
+//=============================================================================
+
+class FingerprintExtractor {
+public:
+    static constexpr int kMaxBands = 1024;          // Anchor band field is 10 bits
+    static constexpr int kMaxDeltaBands = 511;      // Band delta field is 10 bits
+    static constexpr int kMaxDeltaFrames = 4095;    // Frame delta field is 12 bits
+
+    struct Config {
+        int numBands = 40;
+        int frameHops = 4;              // Hops max-pooled into one fingerprint frame
+        int maxPeaksPerFrame = 5;
+        float minDb = -70.0f;           // Ignore peaks below this level
+        float maskDecayDb = 0.5f;       // Masking threshold decay per frame
+        float maskSpreadDb = 6.0f;      // Threshold falloff per band away from a peak
+        int fanOut = 5;                 // Landmarks per new peak
+        int minDeltaFrames = 1;         // Target zone, in frames before the new peak
+        int maxDeltaFrames = 32;
+        int maxDeltaBands = 16;         // Target zone half-height in bands
+    };
+
+    FingerprintExtractor() = default;
+
+    explicit FingerprintExtractor(const Config& config) {
+        configure(config);
+    }
+
+    void configure(const Config& config) {
+        config_ = config;
+        config_.numBands = std::clamp(config.numBands, 1, kMaxBands);
+        config_.frameHops = std::max(1, config.frameHops);
+        config_.maxPeaksPerFrame = std::max(1, config.maxPeaksPerFrame);
+        config_.fanOut = std::max(1, config.fanOut);
+        config_.maxDeltaFrames = std::clamp(config.maxDeltaFrames, 1, kMaxDeltaFrames);
+        config_.minDeltaFrames = std::clamp(config.minDeltaFrames, 1, config_.maxDeltaFrames);
+        config_.maxDeltaBands = std::clamp(config.maxDeltaBands, 0, kMaxDeltaBands);
+
+        const size_t nb = config_.numBands;
+        pooled_.assign(nb, 0.0f);
+        levelDb_.assign(nb, 0.0f);
+        threshold_.assign(nb, 0.0f);
+
+        // Peaks of the last maxDeltaFrames + 1 frames
+        ringFrames_ = config_.maxDeltaFrames + 1;
+        ringBands_.assign(static_cast<size_t>(ringFrames_) * config_.maxPeaksPerFrame, 0);
+        ringCount_.assign(ringFrames_, 0);
+        framePeaks_.assign(config_.maxPeaksPerFrame, 0);
+        framePeakDb_.assign(config_.maxPeaksPerFrame, 0.0f);
+        landmarks_.assign(static_cast<size_t>(config_.maxPeaksPerFrame) * config_.fanOut, Landmark{});
+
+        reset();
+    }
+
+    void reset() {
+        std::fill(pooled_.begin(), pooled_.end(), 0.0f);
+        std::fill(threshold_.begin(), threshold_.end(), config_.minDb);
+        std::fill(ringCount_.begin(), ringCount_.end(), 0);
+        hopPhase_ = 0;
+        frame_ = 0;
+        numLandmarks_ = 0;
+    }
+
+    /// Feed one envelope frame (numBands magnitudes). Returns the number of
+    /// landmarks produced by this hop, available from landmarks().
+    int process(const float* envelope) {
+        const int nb = config_.numBands;
+        for (int b = 0; b < nb; b++) {
+            pooled_[b] = std::max(pooled_[b], envelope[b]);
+        }
+
+        numLandmarks_ = 0;
+        if (++hopPhase_ < config_.frameHops) return 0;
+        hopPhase_ = 0;
+
+        pickPeaks();
+        pairPeaks();
+        std::fill(pooled_.begin(), pooled_.end(), 0.0f);
+        frame_++;
+        return numLandmarks_;
+    }
+
+    /// Count a hop without analysing it (e.g. while an activity gate is
+    /// closed), so landmark times stay aligned with the stream
+    void skip() {
+        numLandmarks_ = 0;
+        if (++hopPhase_ < config_.frameHops) return;
+        hopPhase_ = 0;
+        ringCount_[static_cast<int>(frame_ % ringFrames_)] = 0;
+        std::fill(pooled_.begin(), pooled_.end(), 0.0f);
+        frame_++;
+    }
+
+    /// Landmarks of the last hop
+    const Landmark* landmarks() const { return landmarks_.data(); }
+    int numLandmarks() const { return numLandmarks_; }
+
+    /// Fingerprint frames completed since reset()
+    int64_t frame() const { return frame_; }
+
+    /// Pack an anchor/target pair into a 32-bit hash. Never all ones: the
+    /// top anchor band has no targets above it.
+    static uint32_t makeHash(int anchorBand, int deltaBand, int deltaFrames) {
+        return (static_cast<uint32_t>(anchorBand) & 0x3ffu) << 22
+             | (static_cast<uint32_t>(deltaBand + 512) & 0x3ffu) << 12
+             | (static_cast<uint32_t>(deltaFrames) & 0xfffu);
+    }
+
+private:
+    void pickPeaks() {
+        const int nb = config_.numBands;
+        for (int b = 0; b < nb; b++) {
+            levelDb_[b] = fastPowerToDb(pooled_[b] * pooled_[b] + 1e-20f);
+            threshold_[b] = std::max(threshold_[b] - config_.maskDecayDb, config_.minDb);
+        }
+
+        // Strongest local maxima above the masking threshold
+        int count = 0;
+        for (int b = 0; b < nb; b++) {
+            const float l = levelDb_[b];
+            if (l <= threshold_[b]) continue;
+            if (b > 0 && l <= levelDb_[b - 1]) continue;
+            if (b < nb - 1 && l < levelDb_[b + 1]) continue;
+
+            int pos = count;
+            while (pos > 0 && framePeakDb_[pos - 1] < l) pos--;
+            if (pos >= config_.maxPeaksPerFrame) continue;
+            const int last = std::min(count, config_.maxPeaksPerFrame - 1);
+            for (int j = last; j > pos; j--) {
+                framePeaks_[j] = framePeaks_[j - 1];
+                framePeakDb_[j] = framePeakDb_[j - 1];
+            }
+            framePeaks_[pos] = b;
+            framePeakDb_[pos] = l;
+            count = std::min(count + 1, config_.maxPeaksPerFrame);
+        }
+
+        // Accepted peaks mask their neighbourhood in later frames
+        for (int p = 0; p < count; p++) {
+            const int band = framePeaks_[p];
+            const float l = framePeakDb_[p];
+            for (int b = 0; b < nb; b++) {
+                const float masked = l - config_.maskSpreadDb * static_cast<float>(std::abs(b - band));
+                threshold_[b] = std::max(threshold_[b], masked);
+            }
+        }
+
+        const int slot = static_cast<int>(frame_ % ringFrames_);
+        ringCount_[slot] = count;
+        std::copy(framePeaks_.begin(), framePeaks_.begin() + count,
+                  ringBands_.begin() + static_cast<size_t>(slot) * config_.maxPeaksPerFrame);
+    }
+
+    void pairPeaks() {
+        const int slot = static_cast<int>(frame_ % ringFrames_);
+        const int* targets = ringBands_.data() + static_cast<size_t>(slot) * config_.maxPeaksPerFrame;
+
+        for (int p = 0; p < ringCount_[slot]; p++) {
+            const int target = targets[p];
+            int emitted = 0;
+
+            // Newest anchors first
+            for (int dt = config_.minDeltaFrames; dt <= config_.maxDeltaFrames && emitted < config_.fanOut; dt++) {
+                if (dt > frame_) break;
+                const int anchorSlot = static_cast<int>((frame_ - dt) % ringFrames_);
+                const int* anchors = ringBands_.data() + static_cast<size_t>(anchorSlot) * config_.maxPeaksPerFrame;
+                for (int a = 0; a < ringCount_[anchorSlot] && emitted < config_.fanOut; a++) {
+                    const int delta = target - anchors[a];
+                    if (std::abs(delta) > config_.maxDeltaBands) continue;
+                    Landmark& lm = landmarks_[numLandmarks_++];
+                    lm.hash = makeHash(anchors[a], delta, dt);
+                    lm.time = static_cast<int32_t>(frame_ - dt);
+                    emitted++;
+                }
+            }
+        }
+    }
+
+    Config config_;
+    std::vector<float> pooled_;
+    std::vector<float> levelDb_;
+    std::vector<float> threshold_;  // Masking threshold per band (dB)
+
+    int ringFrames_ = 1;
+    std::vector<int> ringBands_;    // [frame slot][peak] band indices
+    std::vector<int> ringCount_;
+    std::vector<int> framePeaks_;
+    std::vector<float> framePeakDb_;
+
+    std::vector<Landmark> landmarks_;
+    int numLandmarks_ = 0;
+    int hopPhase_ = 0;
+    int64_t frame_ = 0;
+};
+
+//=============================================================================
+// Landmark Index
+//=============================================================================
+
+struct FingerprintMatch {
+    uint32_t trackId = 0;
+    int32_t offset = 0;     // Track frame minus query frame
+    int votes = 0;
+};
+
+class FingerprintIndex {
+    struct Vote {
+        uint32_t trackId = 0;
+        int32_t offset = 0;
+        int votes = 0;
+    };
+
+public:
+    /// Vote table of query(); reuse one per querying thread to avoid
+    /// reallocating it
+    class QueryScratch {
+        friend class FingerprintIndex;
+        std::vector<Vote> votes_;
+        size_t capacity_ = 64;          // Power of two, grows with query size
+    };
+
+    FingerprintIndex() {
+        clear();
+    }
+
+    /// Remove all entries
+    void clear() {
+        entries_.assign(kInitialCapacity, Entry{});
+        size_ = 0;
+    }
+
+    /// Make room for n entries without rehashing
+    void reserve(size_t n) {
+        size_t capacity = entries_.size();
+        while (n * 2 > capacity) capacity *= 2;
+        if (capacity != entries_.size()) rehash(capacity);
+    }
+
+    /// Add the landmarks of a track (times relative to the track start)
+    void add(uint32_t trackId, const Landmark* landmarks, int count) {
+        reserve(size_ + static_cast<size_t>(count));
+        for (int i = 0; i < count; i++) {
+            insert(Entry{landmarks[i].hash, trackId, landmarks[i].time});
+        }
+    }
+
+    /// Vote for (track, offset) pairs with the landmarks of a clip. Writes
+    /// up to maxMatches results, most votes first, and returns the count.
+    int query(const Landmark* landmarks, int count, FingerprintMatch* matches, int maxMatches,
+              QueryScratch& scratch) const {
+        while (scratch.capacity_ < static_cast<size_t>(count) * 4) scratch.capacity_ *= 2;
+        while (!castVotes(landmarks, count, scratch)) scratch.capacity_ *= 2;
+
+        // Top maxMatches by votes
+        int found = 0;
+        for (const Vote& v : scratch.votes_) {
+            if (v.votes == 0) continue;
+            int pos = found;
+            while (pos > 0 && matches[pos - 1].votes < v.votes) pos--;
+            if (pos >= maxMatches) continue;
+            if (found == maxMatches) found--;       // The last match drops out
+            std::copy_backward(matches + pos, matches + found, matches + found + 1);
+            matches[pos] = FingerprintMatch{v.trackId, v.offset, v.votes};
+            found++;
+        }
+        return found;
+    }
+
+    /// query() with a vote table of its own
+    int query(const Landmark* landmarks, int count, FingerprintMatch* matches, int maxMatches) const {
+        QueryScratch scratch;
+        return query(landmarks, count, matches, maxMatches, scratch);
+    }
+
+    /// Write the occupied entries (little endian, 12 bytes each)
+    bool save(std::ostream& out) const {
+        out.write(kMagic, 4);
+        writeU32(out, kVersion);
+        writeU32(out, static_cast<uint32_t>(size_ >> 32));
+        writeU32(out, static_cast<uint32_t>(size_));
+        for (const Entry& e : entries_) {
+            if (e.hash == kEmpty) continue;
+            writeU32(out, e.hash);
+            writeU32(out, e.trackId);
+            writeU32(out, static_cast<uint32_t>(e.time));
+        }
+        return static_cast<bool>(out);
+    }
+
+    /// Replace the contents with an index written by save()
+    bool load(std::istream& in) {
+        char magic[4];
+        in.read(magic, 4);
+        if (!in || !std::equal(magic, magic + 4, kMagic) || readU32(in) != kVersion) return false;
+        const uint64_t high = readU32(in);
+        const uint64_t count = (high << 32) | readU32(in);
+        if (!in || count > kMaxEntries) return false;
+
+        // A corrupt count must fail, not allocate: bound it by the bytes left
+        const std::streampos start = in.tellg();
+        if (start != std::streampos(-1)) {
+            in.seekg(0, std::ios::end);
+            const std::streamoff remaining = in.tellg() - start;
+            in.seekg(start);
+            if (!in || count > static_cast<uint64_t>(remaining) / kEntryBytes) return false;
+        }
+
+        // Unseekable streams grow the table as entries actually arrive
+        clear();
+        reserve(static_cast<size_t>(std::min<uint64_t>(count, kLoadReserve)));
+        for (uint64_t i = 0; i < count; i++) {
+            Entry e;
+            e.hash = readU32(in);
+            e.trackId = readU32(in);
+            e.time = static_cast<int32_t>(readU32(in));
+            if (!in || e.hash == kEmpty) {
+                clear();
+                return false;
+            }
+            reserve(size_ + 1);
+            insert(e);
+        }
+        return true;
+    }
+
+    /// Stored landmarks
+    size_t size() const { return size_; }
+
+    /// Table slots (a power of two, at most half full)
+    size_t capacity() const { return entries_.size(); }
+
+private:
+    static constexpr uint32_t kEmpty = 0xffffffffu;
+    static constexpr size_t kInitialCapacity = 1024;
+    static constexpr uint32_t kVersion = 2;             // 32-bit landmark hashes
+    static constexpr char kMagic[4] = {'C', 'T', 'X', 'F'};
+    static constexpr uint64_t kEntryBytes = 12;             // On disk
+    static constexpr uint64_t kMaxEntries = uint64_t{1} << 40;
+    static constexpr uint64_t kLoadReserve = uint64_t{1} << 16;
+
+    struct Entry {
+        uint32_t hash = kEmpty;
+        uint32_t trackId = 0;
+        int32_t time = 0;
+    };
+
+    static size_t mix(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    void insert(const Entry& e) {
+        const size_t mask = entries_.size() - 1;
+        size_t s = mix(e.hash) & mask;
+        while (entries_[s].hash != kEmpty) s = (s + 1) & mask;
+        entries_[s] = e;
+        size_++;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Entry> old(capacity, Entry{});
+        old.swap(entries_);
+        size_ = 0;
+        for (const Entry& e : old) {
+            if (e.hash != kEmpty) insert(e);
+        }
+    }
+
+    /// Tally (track, offset) votes; false if the vote table ran over half full
+    bool castVotes(const Landmark* landmarks, int count, QueryScratch& scratch) const {
+        std::vector<Vote>& votes = scratch.votes_;
+        votes.assign(scratch.capacity_, Vote{});
+        const size_t voteMask = scratch.capacity_ - 1;
+        size_t numVotes = 0;
+
+        const size_t mask = entries_.size() - 1;
+        for (int i = 0; i < count; i++) {
+            const uint32_t hash = landmarks[i].hash;
+            for (size_t s = mix(hash) & mask; entries_[s].hash != kEmpty; s = (s + 1) & mask) {
+                if (entries_[s].hash != hash) continue;
+                const int32_t offset = entries_[s].time - landmarks[i].time;
+                const uint32_t track = entries_[s].trackId;
+
+                size_t v = mix(track * 0x9e3779b9u ^ static_cast<uint32_t>(offset)) & voteMask;
+                while (votes[v].votes > 0 && (votes[v].trackId != track || votes[v].offset != offset)) {
+                    v = (v + 1) & voteMask;
+                }
+                if (votes[v].votes == 0) {
+                    if (++numVotes * 2 > scratch.capacity_) return false;
+                    votes[v].trackId = track;
+                    votes[v].offset = offset;
+                }
+                votes[v].votes++;
+            }
+        }
+        return true;
+    }
+
+    static void writeU32(std::ostream& out, uint32_t v) {
+        const char bytes[4] = {static_cast<char>(v), static_cast<char>(v >> 8),
+                               static_cast<char>(v >> 16), static_cast<char>(v >> 24)};
+        out.write(bytes, 4);
+    }
+
+    static uint32_t readU32(std::istream& in) {
+        unsigned char bytes[4] = {};
+        in.read(reinterpret_cast<char*>(bytes), 4);
+        return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8
+             | static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+    }
+
+    std::vector<Entry> entries_;
+    size_t size_ = 0;
+};
+
+} // namespace cortix
@@ -0,0 +1,461 @@
+/*
+ * Cortix - Quantised Frame Encoding
+ *
+ * Compact encodings of hop-frame envelopes for storage and transport. A
+ * frame of 128 float32 bands is 512 bytes; quantised to 8-bit dB it is
+ * 128 bytes, and with delta coding and bit packing a steady spectrum
+ * needs a few bits per band.
+ *
+ * Stages (delta and packing are optional):
+ *
+ * - Quantise: envelope magnitude to dB, clamped to [minDb, maxDb] and
+ *   mapped linearly onto 0..255 (uint8) or 0..65535 (uint16).
+ * - Delta: each band is coded as its change since the previous frame,
+ *   modulo the value range, so decoding reproduces the quantised values
+ *   exactly and never drifts. A keyframe, coded on its own, starts the
+ *   stream and repeats every keyframeInterval frames so that readers can
+ *   join late or resynchronise after a lost frame.
+ * - Pack: values are split into groups of 16 bands and each group keeps
+ *   only the bit planes it needs. Deltas are zigzag-mapped first, so
+ *   small changes of either sign are small numbers.
+ *
+ * Encoded frame:
+ *
+ *   u8 flags (bit 0: keyframe)
+ *   keyframes only: f32 minDb, f32 maxDb
+ *   values: numBands little-endian u8/u16, or when packed, per group of
+ *           16 bands: u8 width w, then w little-endian u16 bit planes
+ *           (bit i of plane k is bit k of the group's value i)
+ *
+ * The encoding id (FrameEncoding plus the kEncoding* flags) is carried
+ * next to the frame: in protocol.h Frame messages and in the header of
+ * the shared-memory ring.
+ *
+ * The kernels run over whole 16-lane groups, and the bit-plane kernels
+ * over a fixed number of planes (the value width), without branches on
+ * the data, so they auto-vectorise like the filterbank loops. The data
+ * only decides how many plane bytes are copied out or in.
+ */
+
+#pragma once
+
+#include "fastmath.h"
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+namespace cortix {
+
+/// Frame value formats; the low byte of an encoding id
+enum class FrameEncoding : uint16_t {
+    Float32 = 0,        // Plain float32 envelope (no codec)
+    Uint8 = 1,          // dB quantised to 8 bits
+    Uint16 = 2          // dB quantised to 16 bits
+};
+
+/// Stage flags of an encoding id
+constexpr uint16_t kEncodingDelta = 0x0100;
+constexpr uint16_t kEncodingPacked = 0x0200;
+
+namespace codec {
+
+constexpr int kGroup = 16;                      // Bands per packing group
+constexpr uint8_t kKeyframe = 0x01;
+constexpr float kDbPerLog2 = 6.02059991f;       // 20 * log10(2)
+constexpr float kMaxAbsDb = 750.0f;             // Range limit, keeps fastExp2() in range
+
+inline int numGroups(int numBands) { return (numBands + kGroup - 1) / kGroup; }
+
+inline int valueBits(uint16_t encoding) {
+    return (encoding & 0xff) == static_cast<uint16_t>(FrameEncoding::Uint16) ? 16 : 8;
+}
+
+/// Upper bound of an encoded frame's size
+inline size_t maxEncodedBytes(int numBands, uint16_t encoding) {
+    const int bits = valueBits(encoding);
+    const size_t values = (encoding & kEncodingPacked)
+        ? static_cast<size_t>(numGroups(numBands)) * (1 + 2 * bits)
+        : static_cast<size_t>(numBands) * (bits / 8);
+    return 1 + 8 + values;
+}
+
+//-----------------------------------------------------------------------------
+// Kernels
+
+/// Envelope magnitudes to quantised dB
+inline void quantizeDb(const float* envelope, int n, float minDb, float maxDb, uint32_t maxValue, uint32_t* out) {
+    // Rounded by adding 1.5 * 2^23 and clamped in that domain, so the
+    // value is read from the mantissa bits without a float-to-int conversion
+    constexpr float kRound = 12582912.0f;
+    const float scale = static_cast<float>(maxValue) / (maxDb - minDb);
+    const float top = kRound + static_cast<float>(maxValue);
+    for (int i = 0; i < n; i++) {
+        const float db = kDbPerLog2 * fastLog2(envelope[i] + 1e-30f);
+        const float x = std::min(std::max((db - minDb) * scale + kRound, kRound), top);
+        uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        out[i] = bits - 0x4b400000u;
+    }
+}
+
+/// Quantised values back to dB
+inline void dequantizeDb(const uint32_t* in, int n, float minDb, float maxDb, uint32_t maxValue, float* outDb) {
+    const float step = (maxDb - minDb) / static_cast<float>(maxValue);
+    for (int i = 0; i < n; i++) {
+        outDb[i] = minDb + static_cast<float>(in[i]) * step;
+    }
+}
+
+/// dB to magnitude, in place
+inline void dbToMagnitude(float* values, int n) {
+    for (int i = 0; i < n; i++) {
+        values[i] = fastExp2(values[i] * (1.0f / kDbPerLog2));
+    }
+}
+
+/// Change since the previous frame, modulo 2^bits; zigzag-mapped if asked
+inline void deltaEncode(const uint32_t* values, const uint32_t* previous, int n, int bits, bool zigzag,
+                        uint32_t* out) {
+    const uint32_t mask = (1u << bits) - 1;
+    if (!zigzag) {
+        for (int i = 0; i < n; i++) out[i] = (values[i] - previous[i]) & mask;
+        return;
+    }
+    const int shift = 32 - bits;
+    for (int i = 0; i < n; i++) {
+        // Sign-extend the modular difference, then 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+        const int32_t d = static_cast<int32_t>((values[i] - previous[i]) << shift) >> shift;
+        out[i] = (static_cast<uint32_t>(d) << 1) ^ static_cast<uint32_t>(d >> 31);
+    }
+}
+
+inline void deltaDecode(const uint32_t* in, const uint32_t* previous, int n, int bits, bool zigzag,
+                        uint32_t* values) {
+    const uint32_t mask = (1u << bits) - 1;
+    if (!zigzag) {
+        for (int i = 0; i < n; i++) values[i] = (previous[i] + in[i]) & mask;
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        const uint32_t d = (in[i] >> 1) ^ (0u - (in[i] & 1u));
+        values[i] = (previous[i] + d) & mask;
+    }
+}
+
+/// Significant bits of v < 2^24 (0 for 0), read from the exponent of
+/// float(v) instead of a loop over the bits
+inline int bitWidth(uint32_t v) {
+    const float x = static_cast<float>(v);
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return std::max(static_cast<int>(bits >> 23) - 126, 0);
+}
+
+/// Bit-plane pack whole groups (values padded to numGroups * 16) of
+/// bits-wide values. Returns the bytes written.
+inline size_t packGroups(const uint32_t* values, int numGroups, int bits, uint8_t* out) {
+    uint8_t* p = out;
+    uint8_t planes[2 * 16];
+    for (int g = 0; g < numGroups; g++) {
+        const uint32_t* v = values + g * kGroup;
+        uint32_t any = 0;
+        for (int i = 0; i < kGroup; i++) any |= v[i];
+        const int width = bitWidth(any);
+
+        // All planes of the value width; the first width of them are kept
+        for (int k = 0; k < bits; k++) {
+            uint32_t plane = 0;
+            for (int i = 0; i < kGroup; i++) plane |= ((v[i] >> k) & 1u) << i;
+            planes[2 * k] = static_cast<uint8_t>(plane);
+            planes[2 * k + 1] = static_cast<uint8_t>(plane >> 8);
+        }
+        *p++ = static_cast<uint8_t>(width);
+        std::memcpy(p, planes, static_cast<size_t>(2 * width));
+        p += 2 * width;
+    }
+    return static_cast<size_t>(p - out);
+}
+
+/// Unpack groups written by packGroups() for bits-wide values. Returns the
+/// bytes consumed, or 0 if the input is short or a width exceeds bits.
+inline size_t unpackGroups(const uint8_t* in, size_t size, int numGroups, int bits, uint32_t* values) {
+    size_t pos = 0;
+    uint8_t planes[2 * 16];
+    for (int g = 0; g < numGroups; g++) {
+        if (pos >= size) return 0;
+        const int width = in[pos++];
+        if (width > bits || size - pos < static_cast<size_t>(2 * width)) return 0;
+
+        // Missing high planes are zero
+        std::memset(planes, 0, sizeof(planes));
+        std::memcpy(planes, in + pos, static_cast<size_t>(2 * width));
+        pos += 2 * width;
+
+        uint32_t* v = values + g * kGroup;
+        for (int i = 0; i < kGroup; i++) v[i] = 0;
+        for (int k = 0; k < bits; k++) {
+            const uint32_t plane = static_cast<uint32_t>(planes[2 * k]) | static_cast<uint32_t>(planes[2 * k + 1]) << 8;
+            for (int i = 0; i < kGroup; i++) v[i] |= ((plane >> i) & 1u) << k;
+        }
+    }
+    return pos;
+}
+
+inline uint8_t* putValues(const uint32_t* values, int n, int bits, uint8_t* out) {
+    if (bits == 8) {
+        for (int i = 0; i < n; i++) out[i] = static_cast<uint8_t>(values[i]);
+        return out + n;
+    }
+    for (int i = 0; i < n; i++) {
+        out[2 * i] = static_cast<uint8_t>(values[i]);
+        out[2 * i + 1] = static_cast<uint8_t>(values[i] >> 8);
+    }
+    return out + 2 * n;
+}
+
+inline void getValues(const uint8_t* in, int n, int bits, uint32_t* values) {
+    if (bits == 8) {
+        for (int i = 0; i < n; i++) values[i] = in[i];
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        values[i] = static_cast<uint32_t>(in[2 * i]) | static_cast<uint32_t>(in[2 * i + 1]) << 8;
+    }
+}
+
+inline uint8_t* putF32(float v, uint8_t* out) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, 4);
+    for (int i = 0; i < 4; i++) out[i] = static_cast<uint8_t>(bits >> (8 * i));
+    return out + 4;
+}
+
+inline float getF32(const uint8_t* in) {
+    const uint32_t bits = static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+                          static_cast<uint32_t>(in[2]) << 16 | static_cast<uint32_t>(in[3]) << 24;
+    float v;
+    std::memcpy(&v, &bits, 4);
+    return v;
+}
+
+} // namespace codec
+
+//=============================================================================
+// Encoder
+//=============================================================================
+
+class FrameEncoder {
+public:
+    struct Config {
+        FrameEncoding precision = FrameEncoding::Uint8;    // Uint8 or Uint16
+        float minDb = -100.0f;          // Quantisation range; values outside are clamped
+        float maxDb = 0.0f;
+        bool delta = false;             // Code changes since the previous frame
+        int keyframeInterval = 64;      // Frames per keyframe when delta coding
+        bool packed = false;            // Zigzag and bit-plane packing
+    };
+
+    FrameEncoder() {
+        configure(40, Config{});
+    }
+
+    FrameEncoder(int numBands, const Config& config) {
+        configure(numBands, config);
+    }
+
+    void configure(int numBands, const Config& config) {
+        config_ = config;
+        if (config_.precision != FrameEncoding::Uint16) config_.precision = FrameEncoding::Uint8;
+        config_.minDb = std::min(std::max(config_.minDb, -codec::kMaxAbsDb), codec::kMaxAbsDb - 1.0f);
+        config_.maxDb = std::min(config_.maxDb, codec::kMaxAbsDb);
+        if (!(config_.maxDb > config_.minDb)) config_.maxDb = config_.minDb + 1.0f;
+        config_.keyframeInterval = std::max(1, config_.keyframeInterval);
+        numBands_ = std::max(1, numBands);
+        bits_ = codec::valueBits(encoding());
+
+        // Padded to whole groups; the padding stays zero
+        const size_t padded = static_cast<size_t>(codec::numGroups(numBands_)) * codec::kGroup;
+        quantized_.assign(padded, 0);
+        previous_.assign(padded, 0);
+        values_.assign(padded, 0);
+        reset();
+    }
+
+    /// Make the next frame a keyframe
+    void reset() {
+        sinceKeyframe_ = -1;
+    }
+
+    int numBands() const { return numBands_; }
+    const Config& config() const { return config_; }
+
+    /// Encoding id for Frame messages and the shared-memory ring
+    uint16_t encoding() const {
+        return static_cast<uint16_t>(static_cast<uint16_t>(config_.precision) |
+                                     (config_.delta ? kEncodingDelta : 0) |
+                                     (config_.packed ? kEncodingPacked : 0));
+    }
+
+    size_t maxEncodedBytes() const { return codec::maxEncodedBytes(numBands_, encoding()); }
+
+    /// Encode one envelope (numBands magnitudes) into out, which must hold
+    /// maxEncodedBytes(). Returns the bytes written.
+    size_t encode(const float* envelope, uint8_t* out) {
+        const uint32_t maxValue = (1u << bits_) - 1;
+        codec::quantizeDb(envelope, numBands_, config_.minDb, config_.maxDb, maxValue, quantized_.data());
+
+        const bool keyframe = !config_.delta || sinceKeyframe_ < 0 ||
+                              sinceKeyframe_ + 1 >= config_.keyframeInterval;
+        sinceKeyframe_ = keyframe ? 0 : sinceKeyframe_ + 1;
+
+        uint8_t* p = out;
+        *p++ = keyframe ? codec::kKeyframe : 0;
+        const uint32_t* values = quantized_.data();
+        if (keyframe) {
+            p = codec::putF32(config_.minDb, p);
+            p = codec::putF32(config_.maxDb, p);
+        } else {
+            codec::deltaEncode(quantized_.data(), previous_.data(), numBands_, bits_, config_.packed,
+                               values_.data());
+            values = values_.data();
+        }
+        if (config_.packed) {
+            p += codec::packGroups(values, codec::numGroups(numBands_), bits_, p);
+        } else {
+            p = codec::putValues(values, numBands_, bits_, p);
+        }
+        std::swap(quantized_, previous_);
+        return static_cast<size_t>(p - out);
+    }
+
+    /// Append one encoded envelope to a buffer
+    void encode(const float* envelope, std::vector<uint8_t>& out) {
+        const size_t at = out.size();
+        out.resize(at + maxEncodedBytes());
+        out.resize(at + encode(envelope, out.data() + at));
+    }
+
+private:
+    Config config_;
+    int numBands_ = 0;
+    int bits_ = 8;
+    int sinceKeyframe_ = -1;        // Frames since the last keyframe; -1 before the first
+    std::vector<uint32_t> quantized_;
+    std::vector<uint32_t> previous_;
+    std::vector<uint32_t> values_;
+};
+
+//=============================================================================
+// Decoder
+//=============================================================================
+
+class FrameDecoder {
+public:
+    FrameDecoder() = default;
+
+    FrameDecoder(int numBands, uint16_t encoding) {
+        configure(numBands, encoding);
+    }
+
+    /// False if the encoding id is not a quantised encoding (Float32 frames
+    /// need no decoder)
+    bool configure(int numBands, uint16_t encoding) {
+        const uint16_t precision = encoding & 0xff;
+        if (numBands <= 0 || (encoding & ~(0xff | kEncodingDelta | kEncodingPacked)) ||
+            (precision != static_cast<uint16_t>(FrameEncoding::Uint8) &&
+             precision != static_cast<uint16_t>(FrameEncoding::Uint16))) {
+            return false;
+        }
+        encoding_ = encoding;
+        numBands_ = numBands;
+        bits_ = codec::valueBits(encoding);
+        const size_t padded = static_cast<size_t>(codec::numGroups(numBands_)) * codec::kGroup;
+        values_.assign(padded, 0);
+        previous_.assign(padded, 0);
+        reset();
+        return true;
+    }
+
+    /// Forget the reference frame, e.g. after a lost frame; delta frames
+    /// are then skipped until the next keyframe
+    void reset() {
+        synced_ = false;
+    }
+
+    int numBands() const { return numBands_; }
+    uint16_t encoding() const { return encoding_; }
+
+    /// Holding a reference frame (delta frames can be decoded)
+    bool synced() const { return synced_; }
+
+    /// Delta frames skipped while waiting for a keyframe
+    int64_t skippedFrames() const { return skipped_; }
+
+    /// Decode one frame into numBands dB values. Returns false for corrupt
+    /// input and for delta frames before the first keyframe.
+    bool decodeDb(const uint8_t* data, size_t size, float* outDb) {
+        if (numBands_ == 0 || size < 1 || (data[0] & ~codec::kKeyframe)) return false;
+        const bool keyframe = (data[0] & codec::kKeyframe) != 0;
+        size_t pos = 1;
+        float minDb = minDb_, maxDb = maxDb_;
+        if (keyframe) {
+            if (size < pos + 8) return false;
+            minDb = codec::getF32(data + pos);
+            maxDb = codec::getF32(data + pos + 4);
+            pos += 8;
+            if (!(maxDb > minDb) || minDb < -codec::kMaxAbsDb || maxDb > codec::kMaxAbsDb) return false;
+        } else if (!(encoding_ & kEncodingDelta)) {
+            return false;
+        } else if (!synced_) {
+            skipped_++;
+            return false;
+        }
+
+        const bool delta = !keyframe;
+        const bool packed = (encoding_ & kEncodingPacked) != 0;
+        const uint32_t* values = values_.data();
+        if (packed) {
+            // Zigzag-mapped deltas of b-bit values need up to b bits
+            const size_t used = codec::unpackGroups(data + pos, size - pos, codec::numGroups(numBands_), bits_,
+                                                    values_.data());
+            if (used == 0 || pos + used != size) return false;
+        } else {
+            if (size - pos != static_cast<size_t>(numBands_) * (bits_ / 8)) return false;
+            codec::getValues(data + pos, numBands_, bits_, values_.data());
+        }
+        if (delta) {
+            codec::deltaDecode(values_.data(), previous_.data(), numBands_, bits_, packed, previous_.data());
+            values = previous_.data();
+        } else {
+            std::copy(values_.begin(), values_.begin() + numBands_, previous_.begin());
+        }
+
+        minDb_ = minDb;
+        maxDb_ = maxDb;
+        synced_ = true;
+        codec::dequantizeDb(values, numBands_, minDb_, maxDb_, (1u << bits_) - 1, outDb);
+        return true;
+    }
+
+    /// Same, as envelope magnitudes
+    bool decode(const uint8_t* data, size_t size, float* envelope) {
+        if (!decodeDb(data, size, envelope)) return false;
+        codec::dbToMagnitude(envelope, numBands_);
+        return true;
+    }
+
+private:
+    uint16_t encoding_ = 0;
+    int numBands_ = 0;
+    int bits_ = 8;
+    bool synced_ = false;
+    float minDb_ = 0.0f;
+    float maxDb_ = 1.0f;
+    int64_t skipped_ = 0;
+    std::vector<uint32_t> values_;
+    std::vector<uint32_t> previous_;    // Quantised values of the last decoded frame
+};
+
+} // namespace cortix
@@ -0,0 +1,218 @@
+/*
+ * Cortix - Buffered Frame Output
+ *
+ * Writes hop frames to a file descriptor (a pipe, file or socket) for
+ * shell pipelines. Two formats:
+ *
+ * - Messages: a StreamInfo message (sample rate, hop, band centres)
+ *   followed by one Frame message per hop, as defined in protocol.h.
+ *   Self-describing; read back with protocol::MessageParser. With
+ *   `quantize`, frames carry the envelope in a framecodec.h encoding
+ *   (8/16-bit dB, optionally delta coded and bit packed) instead of
+ *   float32.
+ * - Raw: numBands float32 (little-endian) per hop and nothing else.
+ *
+ * Frames are encoded into large buffers that a writer thread hands to
+ * write(). Up to maxPendingBuffers full buffers can wait for a slow
+ * consumer before the producer blocks, so short stalls downstream do not
+ * stall the analysis; the time spent blocked is reported.
+ *
+ * POSIX (write(2)) and threads; not included by cortix.h.
+ */
+
+#pragma once
+
+#include "analyser.h"
+#include "protocol.h"
+#include "framecodec.h"
+#include <unistd.h>
+#include <cerrno>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+
+namespace cortix {
+
+class FrameWriter {
+public:
+    enum class Format { Messages, Raw };
+
+    struct Config {
+        Format format = Format::Messages;
+        size_t bufferBytes = 1 << 20;   // Handed to write() when full
+        int maxPendingBuffers = 16;     // Full buffers queued before the producer blocks
+        uint32_t streamId = 0;          // Stream field of the messages
+        bool quantize = false;          // Messages only: encode frames with `encoding`
+        FrameEncoder::Config encoding;
+    };
+
+    /// Counters (snapshot)
+    struct Stats {
+        int64_t frames = 0;
+        int64_t bytesWritten = 0;
+        int64_t writeCalls = 0;
+        int peakPendingBuffers = 0;
+        double stallSeconds = 0.0;      // Producer time spent waiting for the consumer
+    };
+
+    FrameWriter(int fd, const Config& config) : fd_(fd), config_(config) {
+        config_.maxPendingBuffers = std::max(1, config.maxPendingBuffers);
+        current_.reserve(config_.bufferBytes + 4096);
+        thread_ = std::thread([this] { run(); });
+    }
+
+    explicit FrameWriter(int fd) : FrameWriter(fd, Config{}) {}
+
+    ~FrameWriter() { finish(); }
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    /// Describe the stream (Messages format only); call before the first frame
+    void begin(const Analyser& analyser) {
+        if (config_.format != Format::Messages) return;
+        std::vector<float> centers(analyser.numBands());
+        for (int b = 0; b < analyser.numBands(); b++) centers[b] = analyser.centerHz(b);
+        protocol::MessageWriter(current_).streamInfo(config_.streamId, analyser.sampleRate(), analyser.hopSize(),
+                                                     centers.data(), analyser.numBands());
+    }
+
+    /// Append one frame. Returns false once a write has failed (e.g. the
+    /// reader closed the pipe); later frames are discarded.
+    bool write(const Analyser::Frame& frame) {
+        if (failed_.load(std::memory_order_relaxed)) return false;
+        if (config_.format == Format::Messages && config_.quantize) {
+            if (!encoderReady_ || encoder_.numBands() != frame.numBands) {
+                encoder_.configure(frame.numBands, config_.encoding);
+                encoderReady_ = true;
+            }
+            protocol::MessageWriter(current_).frame(config_.streamId, frame.index, frame.samplePosition,
+                                                    frame.envelope, encoder_);
+        } else if (config_.format == Format::Messages) {
+            protocol::MessageWriter(current_).frame(config_.streamId, frame.index, frame.samplePosition,
+                                                    frame.envelope, frame.numBands);
+        } else {
+            protocol::MessageWriter(current_).floats(frame.envelope, frame.numBands);
+        }
+        frames_++;
+        if (current_.size() >= config_.bufferBytes) handOff();
+        return true;
+    }
+
+    /// Write everything out and stop the writer thread. Returns false if
+    /// any write failed.
+    bool finish() {
+        if (thread_.joinable()) {
+            if (!current_.empty()) handOff();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_ = true;
+            }
+            ready_.notify_one();
+            thread_.join();
+        }
+        return !failed_.load();
+    }
+
+    bool failed() const { return failed_.load(std::memory_order_relaxed); }
+
+    Stats stats() const {
+        Stats stats;
+        stats.frames = frames_;
+        stats.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+        stats.writeCalls = writeCalls_.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.peakPendingBuffers = peakPending_;
+        stats.stallSeconds = stallSeconds_;
+        return stats;
+    }
+
+private:
+    /// Queue the current buffer for the writer thread, blocking while the
+    /// queue is full
+    void handOff() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (static_cast<int>(pending_.size()) >= config_.maxPendingBuffers) {
+            const auto start = std::chrono::steady_clock::now();
+            space_.wait(lock, [this] { return static_cast<int>(pending_.size()) < config_.maxPendingBuffers; });
+            stallSeconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        pending_.push_back(std::move(current_));
+        peakPending_ = std::max(peakPending_, static_cast<int>(pending_.size()));
+        if (!spare_.empty()) {
+            current_ = std::move(spare_.back());
+            spare_.pop_back();
+        } else {
+            current_ = std::vector<uint8_t>();
+            current_.reserve(config_.bufferBytes + 4096);
+        }
+        current_.clear();
+        lock.unlock();
+        ready_.notify_one();
+    }
+
+    void run() {
+        for (;;) {
+            std::vector<uint8_t> buffer;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [this] { return done_ || !pending_.empty(); });
+                if (pending_.empty()) return;
+                buffer = std::move(pending_.front());
+                pending_.pop_front();
+            }
+
+            if (!failed_.load(std::memory_order_relaxed)) writeAll(buffer);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                buffer.clear();
+                if (static_cast<int>(spare_.size()) < config_.maxPendingBuffers) spare_.push_back(std::move(buffer));
+            }
+            space_.notify_one();
+        }
+    }
+
+    void writeAll(const std::vector<uint8_t>& buffer) {
+        size_t done = 0;
+        while (done < buffer.size()) {
+            const ssize_t n = ::write(fd_, buffer.data() + done, buffer.size() - done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                failed_.store(true);
+                return;
+            }
+            done += static_cast<size_t>(n);
+            bytesWritten_.fetch_add(n, std::memory_order_relaxed);
+            writeCalls_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    int fd_;
+    Config config_;
+    std::vector<uint8_t> current_;          // Being filled by the producer
+    int64_t frames_ = 0;
+    FrameEncoder encoder_;                  // Configured at the first frame
+    bool encoderReady_ = false;
+
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;         // Buffers to write, or done
+    std::condition_variable space_;         // Room in the queue
+    std::deque<std::vector<uint8_t>> pending_;
+    std::vector<std::vector<uint8_t>> spare_;
+    bool done_ = false;
+    int peakPending_ = 0;
+    double stallSeconds_ = 0.0;
+
+    std::atomic<bool> failed_{false};
+    std::atomic<int64_t> bytesWritten_{0};
+    std::atomic<int64_t> writeCalls_{0};
+    std::thread thread_;
+};
+
+} // namespace cortix
@@ -16,6 +16,7 @@
 #include "scales.h"
 #include <vector>
 #include <cmath>
+#include <cstdint>
 #include <algorithm>
 
 namespace cortix {
@@ -92,10 +93,38 @@ private:
 //=============================================================================
 // Gammatone Filterbank
 // Bank of gammatone filters with configurable spacing
+//
+// Bands are packed into groups of kLanes. Each group stores every
+// coefficient and state variable as a run of kLanes floats
+// ([group][field][lane]), so the per-sample loop over a group has a fixed
+// trip count, no cross-lane dependencies and a single base pointer, and
+// compiles to SIMD code. Padding lanes have zero gain and stay silent.
+//
+// Optional auditory stages after the basilar membrane run in the same
+// loop:
+//   - inner hair cell: half-wave rectification, square-root compression
+//     and a 2nd-order lowpass (two one-pole sections)
+//   - neural adaptation: up to five divisive feedback loops with the
+//     time constants of Dau et al. (1996)
+// When enabled, the envelope follows the adapted hair-cell output instead
+// of the resonator magnitude.
+//
+// An active-band mask restricts the work to a subset of bands. Bands are
+// mapped to lane slots through a permutation, and changing the mask swaps
+// slots so that the active bands are packed into the leading groups; only
+// those groups run. Bands outside them are frozen and, when re-enabled,
+// fast-forwarded as if their input had been silent in the meantime.
+//
+// zoom() moves the same pool of bands to a new frequency range without
+// reallocating or resetting: coefficients are recomputed in place and
+// each band inherits the state of the nearest band before the zoom.
 //=============================================================================
 
 class GammatoneFilterbank {
 public:
+    static constexpr int kLanes = 8;
+    static constexpr int kMaxAdaptationLoops = 5;
+
     struct Config {
         int numBands = 40;
         float minHz = 20.0f;
@@ -103,6 +132,11 @@ public:
         float sampleRate = 48000.0f;
         Scale scale = Scale::ERB;
         float smoothingMs = 5.0f;
+
+        bool innerHairCell = false;     // Rectify, compress and lowpass each band
+        float ihcCutoffHz = 1000.0f;    // Hair-cell lowpass cutoff
+        int adaptationLoops = 0;        // 0..kMaxAdaptationLoops, requires innerHairCell
+        float adaptationFloor = 1e-5f;  // Minimum hair-cell level fed to adaptation
     };
 
     GammatoneFilterbank() = default;
@@ -113,16 +147,36 @@ public:
 
     void configure(const Config& config) {
         config_ = config;
+        config_.adaptationLoops = config.innerHairCell
+            ? std::clamp(config.adaptationLoops, 0, kMaxAdaptationLoops) : 0;
 
         // Generate band frequencies according to scale
         bands_ = generateBands(config.scale, config.numBands, config.minHz, config.maxHz);
 
-        // Create filters
-        filters_.resize(config.numBands);
+        numGroups_ = (config.numBands + kLanes - 1) / kLanes;
+        bank_.assign(static_cast<size_t>(numGroups_) * kGroupSize, 0.0f);
+
+        // Identity band <-> slot mapping with every band running
+        slotOf_.resize(config.numBands);
+        bandAt_.resize(config.numBands);
         for (int i = 0; i < config.numBands; i++) {
-            float bw = erbBandwidth(bands_[i].centerHz);
-            filters_[i].configure(bands_[i].centerHz, bw, config.sampleRate);
+            slotOf_[i] = i;
+            bandAt_[i] = i;
         }
+        running_.assign(config.numBands, 1);
+        frozenAt_.assign(config.numBands, 0);
+        ringLeft_.assign(config.numBands, 0);
+        settleLeft_.assign(config.numBands, 0);
+        numActive_ = config.numBands;
+        runningGroups_ = numGroups_;
+        runningSlots_ = config.numBands;
+
+        // Resonator coefficients (see GammatoneFilter::configure)
+        updateCoefficients();
+
+        // Zoom scratch space, sized once so zoom() never allocates
+        previousBands_.resize(config.numBands);
+        scratch_.assign(bank_.size(), 0.0f);
 
         // Envelope smoothing coefficient
         if (config.smoothingMs > 0) {
@@ -132,17 +186,53 @@ public:
             smoothCoeff_ = 0.0f;
         }
 
+        // Hair-cell lowpass and adaptation loop coefficients
+        ihcCoeff_ = std::exp(-2.0f * static_cast<float>(M_PI) * config.ihcCutoffHz / config.sampleRate);
+        static constexpr float kAdaptationTau[kMaxAdaptationLoops] = {0.005f, 0.050f, 0.129f, 0.253f, 0.500f};
+        for (int l = 0; l < kMaxAdaptationLoops; l++) {
+            adaptCoeff_[l] = std::exp(-1.0f / (kAdaptationTau[l] * config.sampleRate));
+            // Steady state of loop l for the floor input is floor^(1/2^(l+1))
+            adaptFloor_[l] = std::pow(config.adaptationFloor, 1.0f / static_cast<float>(2 << l));
+        }
+
+        // Frozen bands ring out at least this many samples exactly: 8 time
+        // constants of the envelope, hair-cell and fastest adaptation smoothers
+        float settleSeconds = std::max(config.smoothingMs / 1000.0f, 1.0f / (2.0f * static_cast<float>(M_PI) * config.ihcCutoffHz));
+        if (config_.adaptationLoops > 0) settleSeconds = std::max(settleSeconds, kAdaptationTau[0]);
+        settleSamples_ = static_cast<int>(std::ceil(8.0f * settleSeconds * config.sampleRate));
+
+        // ... then steps the adaptation loops in 1 ms blocks
+        adaptStep_ = std::max(1, static_cast<int>(0.001f * config.sampleRate));
+        adaptSettleSamples_ = static_cast<int64_t>(std::ceil(8.0f * kAdaptationTau[std::max(0, config_.adaptationLoops - 1)] * config.sampleRate));
+        for (int l = 0; l < kMaxAdaptationLoops; l++) {
+            adaptStepCoeff_[l] = std::pow(adaptCoeff_[l], static_cast<float>(adaptStep_));
+        }
+        envStepCoeff_ = std::pow(smoothCoeff_, static_cast<float>(adaptStep_));
+
         // Allocate output buffers
-        magnitudes_.resize(config.numBands, 0.0f);
-        envelope_.resize(config.numBands, 0.0f);
+        rangeMask_.assign(config.numBands, 1);
+        magnitudes_.assign(config.numBands, 0.0f);
+        envelope_.assign(config.numBands, 0.0f);
+        neural_.assign(config.innerHairCell ? config.numBands : 0, 0.0f);
+
+        reset();
     }
 
     void reset() {
-        for (auto& f : filters_) {
-            f.reset();
+        for (int g = 0; g < numGroups_; g++) {
+            float* f = group(g);
+            std::fill(f + kState * kLanes, f + kGroupSize, 0.0f);
+            for (int l = 0; l < config_.adaptationLoops; l++) {
+                std::fill(f + (kAdapt + l) * kLanes, f + (kAdapt + l + 1) * kLanes, adaptFloor_[l]);
+            }
         }
         std::fill(magnitudes_.begin(), magnitudes_.end(), 0.0f);
         std::fill(envelope_.begin(), envelope_.end(), 0.0f);
+        std::fill(neural_.begin(), neural_.end(), 0.0f);
+        std::fill(frozenAt_.begin(), frozenAt_.end(), 0);
+        std::fill(ringLeft_.begin(), ringLeft_.end(), 0);
+        std::fill(settleLeft_.begin(), settleLeft_.end(), 0);
+        sampleCount_ = 0;
     }
 
     /// Process a block of samples
@@ -150,23 +240,155 @@ public:
         for (int i = 0; i < numSamples; i++) {
             tick(input[i]);
         }
+        sampleCount_ += numSamples;
+        ringOut(numSamples);
+        publish();
     }
 
+    /// Process a block of samples and also write the real band signals
+    /// (sample-major: bandSignals[i * numBands + band]) for stages that
+    /// need the fine structure, such as the correlogram pitch tracker.
+    void process(const float* input, int numSamples, float* bandSignals) {
+        const int nb = config_.numBands;
+        for (int i = 0; i < numSamples; i++) {
+            tick(input[i]);
+            float* out = bandSignals + static_cast<size_t>(i) * nb;
+            for (int s = 0; s < runningSlots_; s++) {
+                out[bandAt_[s]] = slotValue(s, kOutRe);
+            }
+            for (int s = runningSlots_; s < nb; s++) {
+                out[bandAt_[s]] = 0.0f;
+            }
+        }
+        sampleCount_ += numSamples;
+        ringOut(numSamples);
+        publish();
+    }
+
+    /// Restrict processing to the bands with mask[band] != 0 (numBands
+    /// entries). Call between blocks; does not allocate. Bands that share a
+    /// lane group with an active band keep running as well.
+    void setActiveBands(const uint8_t* mask) {
+        const int nb = config_.numBands;
+
+        // Partition slots: active bands first
+        int next = 0;
+        for (int s = 0; s < nb; s++) {
+            if (mask[bandAt_[s]]) {
+                if (s != next) swapSlots(s, next);
+                next++;
+            }
+        }
+        numActive_ = next;
+        runningGroups_ = (numActive_ + kLanes - 1) / kLanes;
+        runningSlots_ = std::min(runningGroups_ * kLanes, nb);
+
+        // Freeze bands that stop running, fast-forward the ones that resume
+        for (int b = 0; b < nb; b++) {
+            const bool run = slotOf_[b] < runningSlots_;
+            if (running_[b] && !run) {
+                frozenAt_[b] = sampleCount_;
+                ringLeft_[b] = ringOutSamples(b);
+                settleLeft_[b] = config_.adaptationLoops > 0 ? adaptSettleSamples_ : 0;
+            } else if (!running_[b] && run) {
+                fastForward(b, sampleCount_ - frozenAt_[b]);
+            }
+            running_[b] = run ? 1 : 0;
+        }
+    }
+
+    /// Activate only the bands whose centre lies in [minHz, maxHz]
+    void setActiveRange(float minHz, float maxHz) {
+        for (int b = 0; b < config_.numBands; b++) {
+            rangeMask_[b] = (bands_[b].centerHz >= minHz && bands_[b].centerHz <= maxHz) ? 1 : 0;
+        }
+        setActiveBands(rangeMask_.data());
+    }
+
+    /// Run every band again
+    void setAllBandsActive() {
+        std::fill(rangeMask_.begin(), rangeMask_.end(), 1);
+        setActiveBands(rangeMask_.data());
+    }
+
+    /// Redistribute the bands over [minHz, maxHz] with the configured
+    /// scale. Buffers are reused and every band takes over the filter and
+    /// envelope state of the old band nearest to its new centre, so the
+    /// display does not drop to zero. The band mask stays indexed by band.
+    /// Does not allocate; safe to call between blocks on the audio thread.
+    void zoom(float minHz, float maxHz) {
+        const int nb = config_.numBands;
+        if (nb == 0) return;
+
+        std::copy(bands_.begin(), bands_.end(), previousBands_.begin());
+        std::copy(bank_.begin(), bank_.end(), scratch_.begin());
+        config_.minHz = minHz;
+        config_.maxHz = maxHz;
+        generateBands(config_.scale, nb, minHz, maxHz, bands_.data());
+
+        // Both band lists are sorted, so the nearest old band is found
+        // with a single forward sweep
+        int src = 0;
+        for (int b = 0; b < nb; b++) {
+            const float target = hzToErb(bands_[b].centerHz);
+            while (src + 1 < nb &&
+                   std::abs(hzToErb(previousBands_[src + 1].centerHz) - target) <=
+                   std::abs(hzToErb(previousBands_[src].centerHz) - target)) {
+                src++;
+            }
+            const int from = slotOf_[src], to = slotOf_[b];
+            const float* in = scratch_.data() + static_cast<size_t>(from / kLanes) * kGroupSize + from % kLanes;
+            float* out = bank_.data() + static_cast<size_t>(to / kLanes) * kGroupSize + to % kLanes;
+            for (int f = kState; f < kNumFields; f++) {
+                out[f * kLanes] = in[f * kLanes];
+            }
+        }
+
+        updateCoefficients();
+        publish();
+    }
+
+    /// Number of bands selected by the last mask
+    int numActiveBands() const { return numActive_; }
+
+    /// Whether a band is currently being computed (selected, or sharing a
+    /// lane group with a selected band)
+    bool isBandRunning(int band) const { return running_[band] != 0; }
+
     /// Get the number of bands
     int numBands() const { return config_.numBands; }
 
-    /// Get the smoothed envelope (magnitude per band)
+    /// Get the smoothed envelope (magnitude per band, or the smoothed
+    /// adapted hair-cell output when innerHairCell is enabled)
     const std::vector<float>& envelope() const { return envelope_; }
 
     /// Get raw (unsmoothed) magnitudes
     const std::vector<float>& magnitudes() const { return magnitudes_; }
 
+    /// Latest hair-cell / adaptation output per band (empty unless innerHairCell)
+    const std::vector<float>& neural() const { return neural_; }
+
+    /// Bytes of per-sample filter state (the lane groups)
+    size_t stateBytes() const { return bank_.size() * sizeof(float); }
+
     /// Get band information
     const std::vector<BandInfo>& bands() const { return bands_; }
 
     /// Get center frequency for a band in Hz
     float centerHz(int band) const { return bands_[band].centerHz; }
 
+    /// Instantaneous frequency per band (Hz) from the complex output phase
+    void instantaneousFrequency(float* outputHz) const {
+        const float scale = config_.sampleRate / (2.0f * static_cast<float>(M_PI));
+        for (int b = 0; b < config_.numBands; b++) {
+            const float outRe = lane(b, kOutRe), outIm = lane(b, kOutIm);
+            const float prevRe = lane(b, kPrevRe), prevIm = lane(b, kPrevIm);
+            const float re = outRe * prevRe + outIm * prevIm;
+            const float im = outIm * prevRe - outRe * prevIm;
+            outputHz[b] = std::atan2(im, re) * scale;
+        }
+    }
+
     /// Get the envelope in decibels
     void envelopeDb(float* output, float minDb = -100.0f) const {
         for (size_t i = 0; i < envelope_.size(); i++) {
@@ -176,24 +398,316 @@ public:
     }
 
 private:
-    void tick(float input) {
-        for (size_t i = 0; i < filters_.size(); i++) {
-            float mag = filters_[i].tick(input);
-            magnitudes_[i] = mag;
+    // Per-group field offsets (each field is kLanes floats)
+    enum Field {
+        kGain, kPoleRe, kPoleIm,                    // Coefficients
+        kState,                                     // First state field
+        kRe0 = kState, kRe1, kRe2, kRe3,            // Resonator stages
+        kIm0, kIm1, kIm2, kIm3,
+        kOutRe, kOutIm, kPrevRe, kPrevIm,           // Last two outputs
+        kMag, kEnv,                                 // Magnitude and envelope
+        kLp1, kLp2, kNeural,                        // Hair cell
+        kAdapt,                                     // Adaptation loop states
+        kNumFields = kAdapt + kMaxAdaptationLoops
+    };
+    static constexpr int kGroupSize = kNumFields * kLanes;
+
+    float* group(int g) { return bank_.data() + static_cast<size_t>(g) * kGroupSize; }
+    const float* group(int g) const { return bank_.data() + static_cast<size_t>(g) * kGroupSize; }
+
+    float& slotValue(int slot, int field) {
+        return group(slot / kLanes)[field * kLanes + slot % kLanes];
+    }
+    float slotValue(int slot, int field) const {
+        return group(slot / kLanes)[field * kLanes + slot % kLanes];
+    }
+
+    float& lane(int band, Field field) { return slotValue(slotOf_[band], field); }
+    float lane(int band, Field field) const { return slotValue(slotOf_[band], field); }
+
+    void swapSlots(int a, int b) {
+        for (int f = 0; f < kNumFields; f++) {
+            std::swap(slotValue(a, f), slotValue(b, f));
+        }
+        std::swap(bandAt_[a], bandAt_[b]);
+        slotOf_[bandAt_[a]] = a;
+        slotOf_[bandAt_[b]] = b;
+    }
+
+    /// Samples a frozen band keeps running exactly on silent input: 16 pole
+    /// time constants, after which the 4-stage cascade's t^3 * r^t tail is
+    /// below 1e-3 of its peak, or the smoothers' settle time if longer
+    int64_t ringOutSamples(int band) const {
+        const double pr = lane(band, kPoleRe), pi = lane(band, kPoleIm);
+        const double r = std::sqrt(pr * pr + pi * pi);
+        const double ring = (r > 0.0 && r < 1.0) ? std::ceil(-16.0 / std::log(r)) : 0.0;
+        return std::max(static_cast<int64_t>(settleSamples_), static_cast<int64_t>(ring));
+    }
+
+    /// Keep the frozen bands up to date over the blocks after they stop,
+    /// so that resuming one costs no more than the closed form: first the
+    /// exact ring-out, at most numSamples per band and block, then the
+    /// adaptation loops in whole 1 ms steps until the slowest has settled.
+    /// frozenAt_ moves along, and stays put once the band has settled.
+    void ringOut(int numSamples) {
+        for (int s = runningSlots_; s < config_.numBands; s++) {
+            const int band = bandAt_[s];
+            int64_t n = std::min(static_cast<int64_t>(numSamples), ringLeft_[band]);
+            if (n > 0) {
+                float* f = group(s / kLanes) + s % kLanes;
+                for (int64_t i = 0; i < n; i++) {
+                    tickLanes<1>(f, 0.0f);
+                }
+                ringLeft_[band] -= n;
+            } else if (settleLeft_[band] > 0) {
+                n = std::min(sampleCount_ - frozenAt_[band], settleLeft_[band]);
+                if (n < settleLeft_[band]) n -= n % adaptStep_;
+                fastForward(band, n);
+                settleLeft_[band] -= n;
+            }
+            frozenAt_[band] += n;
+        }
+    }
 
-            if (smoothCoeff_ > 0) {
-                envelope_[i] = smoothCoeff_ * envelope_[i] + (1.0f - smoothCoeff_) * mag;
+    /// Advance a frozen band by the n samples of silent input since
+    /// frozenAt_, in closed form: ringOut() has already run its ring-out.
+    /// With no input left that is exact for the resonator cascade
+    /// (coupling between stages included) and the hair-cell lowpass pair;
+    /// the nonlinear adaptation loops are stepped in 1 ms blocks and the
+    /// envelope relaxes towards the resulting output.
+    void fastForward(int band, int64_t n) {
+        if (n <= 0) return;
+        const double pr = lane(band, kPoleRe), pi = lane(band, kPoleIm);
+        const double r = std::sqrt(pr * pr + pi * pi);
+
+        // Stage k of a cascade of identical poles p after m silent samples:
+        // s_k[m] = p^m * sum_j C(m + k - j - 1, k - j) * s_j[0]
+        double re0[4], im0[4];
+        for (int s = 0; s < 4; s++) {
+            re0[s] = lane(band, static_cast<Field>(kRe0 + s));
+            im0[s] = lane(band, static_cast<Field>(kIm0 + s));
+        }
+        auto cascade = [&](double m, int stage, double& re, double& im) {
+            const double binomial[4] = {1.0, m, m * (m + 1.0) / 2.0, m * (m + 1.0) * (m + 2.0) / 6.0};
+            double sumRe = 0.0, sumIm = 0.0;
+            for (int j = 0; j <= stage; j++) {
+                sumRe += binomial[stage - j] * re0[j];
+                sumIm += binomial[stage - j] * im0[j];
+            }
+            const double decay = std::pow(r, m);
+            const double angle = std::fmod(std::atan2(pi, pr) * m, 2.0 * M_PI);
+            const double cr = decay * std::cos(angle), ci = decay * std::sin(angle);
+            re = sumRe * cr - sumIm * ci;
+            im = sumRe * ci + sumIm * cr;
+        };
+        const double m = static_cast<double>(n);
+        double re, im;
+        for (int s = 0; s < 4; s++) {
+            cascade(m, s, re, im);
+            lane(band, static_cast<Field>(kRe0 + s)) = static_cast<float>(re);
+            lane(band, static_cast<Field>(kIm0 + s)) = static_cast<float>(im);
+        }
+        cascade(m - 1.0, 3, re, im);
+        lane(band, kPrevRe) = static_cast<float>(re);
+        lane(band, kPrevIm) = static_cast<float>(im);
+        const float outRe = lane(band, kRe3), outIm = lane(band, kIm3);
+        lane(band, kOutRe) = outRe;
+        lane(band, kOutIm) = outIm;
+        lane(band, kMag) = std::sqrt(outRe * outRe + outIm * outIm);
+
+        float target = lane(band, kMag);
+        int64_t remaining = n;
+        if (config_.innerHairCell) {
+            // Hair-cell lowpass pair: lp2[t] = c^t * (lp2[0] + t * (1 - c) * lp1[0])
+            const double c = ihcCoeff_;
+            const double lp1 = lane(band, kLp1), lp2 = lane(band, kLp2);
+            auto hairCell = [&](double t) { return std::pow(c, t) * (lp2 + t * (1.0 - c) * lp1); };
+            lane(band, kLp2) = static_cast<float>(hairCell(m));
+            lane(band, kLp1) = static_cast<float>(std::pow(c, m) * lp1);
+
+            // Adaptation loops and the envelope following them, in steps,
+            // or settled outright once the slowest loop has
+            float* state = &lane(band, kAdapt);
+            const float floor = config_.adaptationFloor;
+            const int loops = config_.adaptationLoops;
+            auto adapt = [&](float y, bool update) {
+                if (loops > 0) y = std::max(y, floor);
+                for (int l = 0; l < loops; l++) {
+                    y /= state[l * kLanes];
+                    if (update) {
+                        state[l * kLanes] = std::max(adaptStepCoeff_[l] * state[l * kLanes] +
+                                                     (1.0f - adaptStepCoeff_[l]) * y, adaptFloor_[l]);
+                    }
+                }
+                return y;
+            };
+            int64_t stepped = 0;
+            if (n >= adaptSettleSamples_ || settleLeft_[band] == 0) {
+                for (int l = 0; l < loops; l++) state[l * kLanes] = adaptFloor_[l];
             } else {
-                envelope_[i] = mag;
+                float& env = lane(band, kEnv);
+                for (; stepped + adaptStep_ <= n; stepped += adaptStep_) {
+                    const float y = adapt(static_cast<float>(hairCell(static_cast<double>(stepped + adaptStep_))), true);
+                    env = envStepCoeff_ * env + (1.0f - envStepCoeff_) * y;
+                }
+            }
+            target = adapt(lane(band, kLp2), false);
+            lane(band, kNeural) = target;
+            remaining = n - stepped;
+        }
+        const float smooth = static_cast<float>(std::pow(static_cast<double>(smoothCoeff_), static_cast<double>(remaining)));
+        lane(band, kEnv) = target + (lane(band, kEnv) - target) * smooth;
+    }
+
+    /// Recompute gain and pole of every band from bands_, one lane group
+    /// at a time so each field is written as a contiguous run
+    void updateCoefficients() {
+        const float twoPiOverFs = 2.0f * static_cast<float>(M_PI) / config_.sampleRate;
+        for (int g = 0; g < numGroups_; g++) {
+            float* f = group(g);
+            float centre[kLanes];
+            for (int j = 0; j < kLanes; j++) {
+                const int slot = g * kLanes + j;
+                centre[j] = slot < config_.numBands ? bands_[bandAt_[slot]].centerHz : 0.0f;
+            }
+            for (int j = 0; j < kLanes; j++) {
+                const float omega = twoPiOverFs * centre[j];
+                const float bw = twoPiOverFs * erbBandwidth(centre[j]);
+                const float r = std::exp(-bw);
+                const float d = 1.0f - r;
+                const bool live = centre[j] > 0.0f;
+                f[kPoleRe * kLanes + j] = live ? r * std::cos(omega) : 0.0f;
+                f[kPoleIm * kLanes + j] = live ? r * std::sin(omega) : 0.0f;
+                f[kGain * kLanes + j] = live ? d * d * d * d * 2.0f : 0.0f;
             }
         }
     }
 
+    void tick(float input) {
+        for (int g = 0; g < runningGroups_; g++) {
+            tickLanes<kLanes>(group(g), input);
+        }
+    }
+
+    /// One sample for Lanes consecutive lanes starting at f (a lane group,
+    /// or a single lane for fastForward); fields stay kLanes floats apart
+    template <int Lanes>
+    void tickLanes(float* f, float input) {
+        const float k = smoothCoeff_;
+        const bool ihc = config_.innerHairCell;
+
+        // Cascade of 4 complex resonators
+        for (int j = 0; j < Lanes; j++) {
+            const float pr = f[kPoleRe * kLanes + j];
+            const float pi = f[kPoleIm * kLanes + j];
+            float re = input * f[kGain * kLanes + j];
+            float im = 0.0f;
+            for (int s = 0; s < 4; s++) {
+                float& sr = f[(kRe0 + s) * kLanes + j];
+                float& si = f[(kIm0 + s) * kLanes + j];
+                const float newRe = re + pr * sr - pi * si;
+                const float newIm = im + pi * sr + pr * si;
+                sr = newRe;
+                si = newIm;
+                re = newRe;
+                im = newIm;
+            }
+            f[kPrevRe * kLanes + j] = f[kOutRe * kLanes + j];
+            f[kPrevIm * kLanes + j] = f[kOutIm * kLanes + j];
+            f[kOutRe * kLanes + j] = re;
+            f[kOutIm * kLanes + j] = im;
+            f[kMag * kLanes + j] = std::sqrt(std::max(re * re + im * im, 0.0f));
+        }
+
+        if (!ihc) {
+            for (int j = 0; j < Lanes; j++) {
+                f[kEnv * kLanes + j] = k * f[kEnv * kLanes + j] + (1.0f - k) * f[kMag * kLanes + j];
+            }
+            return;
+        }
+
+        // Inner hair cell: rectify, compress, 2nd-order lowpass
+        const float c = ihcCoeff_;
+        for (int j = 0; j < Lanes; j++) {
+            const float h = std::sqrt(std::max(f[kOutRe * kLanes + j], 0.0f));
+            const float lp1 = c * f[kLp1 * kLanes + j] + (1.0f - c) * h;
+            const float lp2 = c * f[kLp2 * kLanes + j] + (1.0f - c) * lp1;
+            f[kLp1 * kLanes + j] = lp1;
+            f[kLp2 * kLanes + j] = lp2;
+            f[kNeural * kLanes + j] = lp2;
+        }
+
+        // Neural adaptation: each loop divides by its own lowpassed output
+        if (config_.adaptationLoops > 0) {
+            const float floor = config_.adaptationFloor;
+            for (int j = 0; j < Lanes; j++) {
+                f[kNeural * kLanes + j] = std::max(f[kNeural * kLanes + j], floor);
+            }
+            for (int l = 0; l < config_.adaptationLoops; l++) {
+                const float a = adaptCoeff_[l];
+                const float minState = adaptFloor_[l];
+                float* state = f + (kAdapt + l) * kLanes;
+                for (int j = 0; j < Lanes; j++) {
+                    const float y = f[kNeural * kLanes + j] / state[j];
+                    state[j] = std::max(a * state[j] + (1.0f - a) * y, minState);
+                    f[kNeural * kLanes + j] = y;
+                }
+            }
+        }
+
+        for (int j = 0; j < Lanes; j++) {
+            f[kEnv * kLanes + j] = k * f[kEnv * kLanes + j] + (1.0f - k) * f[kNeural * kLanes + j];
+        }
+    }
+
+    /// Copy per-band outputs from the lane groups to the public vectors.
+    /// Frozen bands keep their last values while ringOut() moves them on.
+    void publish() {
+        for (int b = 0; b < config_.numBands; b++) {
+            if (!running_[b]) continue;
+            magnitudes_[b] = lane(b, kMag);
+            envelope_[b] = lane(b, kEnv);
+        }
+        for (size_t b = 0; b < neural_.size(); b++) {
+            if (running_[b]) neural_[b] = lane(static_cast<int>(b), kNeural);
+        }
+    }
+
     Config config_;
     std::vector<BandInfo> bands_;
-    std::vector<GammatoneFilter> filters_;
+
+    int numGroups_ = 0;
+    std::vector<float> bank_;       // [group][field][lane]
+
+    // Active-band mask state
+    std::vector<int> slotOf_;       // Band -> lane slot
+    std::vector<int> bandAt_;       // Lane slot -> band
+    std::vector<uint8_t> running_;
+    std::vector<uint8_t> rangeMask_;
+    std::vector<int64_t> frozenAt_; // Sample count a frozen band's state is at
+    std::vector<int64_t> ringLeft_; // Samples of its ring-out still to run
+    std::vector<int64_t> settleLeft_;   // ... then of adaptation loop steps
+    int numActive_ = 0;
+    int runningGroups_ = 0;
+    int runningSlots_ = 0;
+    int64_t sampleCount_ = 0;
+
+    // Zoom scratch space
+    std::vector<BandInfo> previousBands_;
+    std::vector<float> scratch_;
+
+    float ihcCoeff_ = 0.0f;
+    float adaptCoeff_[kMaxAdaptationLoops] = {};
+    float adaptFloor_[kMaxAdaptationLoops] = {};
+    int settleSamples_ = 0;             // ringOut(): shortest exact ring-out
+    int adaptStep_ = 1;                 // ... adaptation loop step after it
+    int64_t adaptSettleSamples_ = 0;
+    float adaptStepCoeff_[kMaxAdaptationLoops] = {};
+    float envStepCoeff_ = 0.0f;
+
     std::vector<float> magnitudes_;
     std::vector<float> envelope_;
+    std::vector<float> neural_;
     float smoothCoeff_ = 0.0f;
 };
 
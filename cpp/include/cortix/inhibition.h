@@ -0,0 +1,148 @@
+/*
+ * Cortix - Lateral Inhibition
+ *
+ * Spectral sharpening across neighbouring bands. Gammatone bands overlap
+ * heavily, so a single partial excites several of them; convolving the
+ * envelope with a difference-of-Gaussians kernel (narrow excitatory
+ * centre, wide inhibitory surround) narrows the response back towards
+ * the band that holds the partial, much like lateral inhibition in the
+ * cochlear nucleus (Shamma 1985).
+ *
+ * Distances are measured in ERB-rate units between band centres, so the
+ * kernel follows whatever spacing generateBands() produced. Weights are
+ * precomputed per band in configure() and stored offset-major
+ * ([offset][band]); each hop is then 2R+1 element-wise multiply-adds over
+ * all bands, which vectorizes.
+ */
+
+#pragma once
+
+#include "scales.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace cortix {
+
+class LateralInhibition {
+public:
+    struct Config {
+        float excitationErb = 0.5f;     // Std dev of the excitatory centre
+        float inhibitionErb = 2.0f;     // Std dev of the inhibitory surround
+        float strength = 0.9f;          // Surround weight relative to the centre, 0 = off
+        float extentSigmas = 3.0f;      // Kernel truncated at this many surround std devs
+        int maxRadius = 16;             // Cap on the kernel half-width in bands
+    };
+
+    LateralInhibition() = default;
+
+    LateralInhibition(const Config& config, const std::vector<BandInfo>& bands) {
+        configure(config, bands);
+    }
+
+    void configure(const Config& config, const std::vector<BandInfo>& bands) {
+        config_ = config;
+        numBands_ = static_cast<int>(bands.size());
+
+        std::vector<float> erb(numBands_);
+        for (int b = 0; b < numBands_; b++) {
+            erb[b] = hzToErb(bands[b].centerHz);
+        }
+
+        // Half-width in bands: the widest neighbourhood any band needs
+        const float extent = config.extentSigmas * std::max(config.inhibitionErb, config.excitationErb);
+        radius_ = 0;
+        for (int b = 0; b < numBands_; b++) {
+            int r = 0;
+            while (r < config.maxRadius &&
+                   ((b - r - 1 >= 0 && erb[b] - erb[b - r - 1] <= extent) ||
+                    (b + r + 1 < numBands_ && erb[b + r + 1] - erb[b] <= extent))) {
+                r++;
+            }
+            radius_ = std::max(radius_, r);
+        }
+
+        // Per-band DoG: each Gaussian normalized over the neighbours that
+        // exist, so edge bands see the same centre/surround balance
+        const int taps = 2 * radius_ + 1;
+        weights_.assign(static_cast<size_t>(taps) * numBands_, 0.0f);
+        std::vector<float> centre(taps), surround(taps);
+        const float ce = 0.5f / std::max(config.excitationErb * config.excitationErb, 1e-6f);
+        const float ci = 0.5f / std::max(config.inhibitionErb * config.inhibitionErb, 1e-6f);
+
+        for (int b = 0; b < numBands_; b++) {
+            float sumC = 0.0f, sumS = 0.0f;
+            for (int o = -radius_; o <= radius_; o++) {
+                const int n = b + o;
+                float c = 0.0f, s = 0.0f;
+                if (n >= 0 && n < numBands_) {
+                    const float d = erb[n] - erb[b];
+                    if (std::abs(d) <= extent) {
+                        c = std::exp(-d * d * ce);
+                        s = std::exp(-d * d * ci);
+                    }
+                }
+                centre[o + radius_] = c;
+                surround[o + radius_] = s;
+                sumC += c;
+                sumS += s;
+            }
+            const float gc = sumC > 0.0f ? 1.0f / sumC : 0.0f;
+            const float gs = sumS > 0.0f ? config.strength / sumS : 0.0f;
+            for (int t = 0; t < taps; t++) {
+                weights_[static_cast<size_t>(t) * numBands_ + b] = gc * centre[t] - gs * surround[t];
+            }
+        }
+
+        // Input copy with radius_ zeros on each side, so taps need no bounds checks
+        padded_.assign(numBands_ + 2 * radius_, 0.0f);
+        output_.assign(numBands_, 0.0f);
+    }
+
+    void reset() {
+        std::fill(output_.begin(), output_.end(), 0.0f);
+    }
+
+    /// Sharpen one envelope frame (numBands magnitudes). Output is half-wave
+    /// rectified; a flat spectrum comes out scaled by (1 - strength).
+    const std::vector<float>& process(const float* envelope) {
+        const int nb = numBands_;
+        std::copy(envelope, envelope + nb, padded_.begin() + radius_);
+        std::fill(output_.begin(), output_.end(), 0.0f);
+
+        float* out = output_.data();
+        for (int t = 0; t <= 2 * radius_; t++) {
+            const float* w = weights_.data() + static_cast<size_t>(t) * nb;
+            const float* x = padded_.data() + t;
+            for (int b = 0; b < nb; b++) {
+                out[b] += w[b] * x[b];
+            }
+        }
+        for (int b = 0; b < nb; b++) {
+            out[b] = std::max(out[b], 0.0f);
+        }
+        return output_;
+    }
+
+    /// Sharpened envelope of the last frame
+    const std::vector<float>& output() const { return output_; }
+
+    /// Kernel half-width in bands
+    int radius() const { return radius_; }
+
+    /// Kernel weight applied to band (band + offset) for output band `band`
+    float weight(int band, int offset) const {
+        if (offset < -radius_ || offset > radius_) return 0.0f;
+        return weights_[static_cast<size_t>(offset + radius_) * numBands_ + band];
+    }
+
+private:
+    Config config_;
+    int numBands_ = 0;
+    int radius_ = 0;
+    std::vector<float> weights_;    // [offset + radius][band]
+    std::vector<float> padded_;
+    std::vector<float> output_;
+};
+
+} // namespace cortix
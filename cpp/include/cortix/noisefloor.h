@@ -0,0 +1,152 @@
+/*
+ * Cortix - Adaptive Noise Floor
+ *
+ * Per-band noise floor by minimum statistics (Martin 2001): the minimum
+ * of the smoothed band power over a sliding window, scaled by a bias
+ * factor. The window is split into U sub-windows of V hops; each hop only
+ * updates the running sub-window minimum, and the U stored minima are
+ * folded once per sub-window, so the cost is O(bands) per hop whatever the
+ * window length. Every step is an element-wise loop across bands and
+ * vectorizes.
+ *
+ * Detectors can gate on snrDb() instead of absolute levels.
+ */
+
+#pragma once
+
+#include "fastmath.h"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+
+namespace cortix {
+
+class NoiseFloorTracker {
+public:
+    struct Config {
+        int numBands = 40;
+        float hopRateHz = 375.0f;
+        float windowSeconds = 1.5f;   // Minimum search window
+        int numSubwindows = 8;
+        float smoothingMs = 40.0f;    // Power smoothing before the minimum
+        float bias = 1.5f;            // Compensates the minimum's underestimate
+        float minDb = -120.0f;
+    };
+
+    NoiseFloorTracker() = default;
+
+    explicit NoiseFloorTracker(const Config& config) {
+        configure(config);
+    }
+
+    void configure(const Config& config) {
+        config_ = config;
+        config_.numSubwindows = std::max(1, config.numSubwindows);
+
+        const int windowHops = std::max(1, static_cast<int>(config.windowSeconds * config.hopRateHz));
+        subwindowHops_ = std::max(1, windowHops / config_.numSubwindows);
+
+        const float tau = config.smoothingMs / 1000.0f * config.hopRateHz;
+        smoothCoeff_ = tau > 0.0f ? std::exp(-1.0f / tau) : 0.0f;
+        minPower_ = std::pow(10.0f, config.minDb / 10.0f);
+
+        const size_t nb = config.numBands;
+        smoothed_.assign(nb, 0.0f);
+        subMin_.assign(nb, 0.0f);
+        windowMin_.assign(nb, 0.0f);
+        ring_.assign(nb * config_.numSubwindows, 0.0f);
+        floor_.assign(nb, 0.0f);
+        floorDb_.assign(nb, config.minDb);
+        snrDb_.assign(nb, 0.0f);
+
+        reset();
+    }
+
+    void reset() {
+        const float inf = std::numeric_limits<float>::max();
+        std::fill(smoothed_.begin(), smoothed_.end(), 0.0f);
+        std::fill(subMin_.begin(), subMin_.end(), inf);
+        std::fill(windowMin_.begin(), windowMin_.end(), inf);
+        std::fill(ring_.begin(), ring_.end(), inf);
+        std::fill(floor_.begin(), floor_.end(), minPower_);
+        std::fill(floorDb_.begin(), floorDb_.end(), config_.minDb);
+        std::fill(snrDb_.begin(), snrDb_.end(), 0.0f);
+        subwindowPhase_ = 0;
+        ringPos_ = 0;
+        frames_ = 0;
+    }
+
+    /// Update the floor from one envelope frame (numBands magnitudes)
+    void process(const float* envelope) {
+        const int nb = config_.numBands;
+        const float a = frames_ == 0 ? 0.0f : smoothCoeff_;
+        const float bias = config_.bias;
+        const float minPower = minPower_;
+
+        for (int b = 0; b < nb; b++) {
+            const float p = envelope[b] * envelope[b];
+            const float s = a * smoothed_[b] + (1.0f - a) * p;
+            smoothed_[b] = s;
+            subMin_[b] = std::min(subMin_[b], s);
+            floor_[b] = std::max(bias * std::min(windowMin_[b], subMin_[b]), minPower);
+        }
+        for (int b = 0; b < nb; b++) {
+            floorDb_[b] = fastPowerToDb(floor_[b]);
+            snrDb_[b] = fastPowerToDb(smoothed_[b] + minPower) - floorDb_[b];
+        }
+
+        if (++subwindowPhase_ == subwindowHops_) {
+            subwindowPhase_ = 0;
+            rotateSubwindow();
+        }
+        frames_++;
+    }
+
+    /// Noise floor power per band (linear magnitude squared)
+    const std::vector<float>& floor() const { return floor_; }
+
+    /// Noise floor per band in dB
+    const std::vector<float>& floorDb() const { return floorDb_; }
+
+    /// Smoothed level over the floor per band in dB
+    const std::vector<float>& snrDb() const { return snrDb_; }
+
+private:
+    void rotateSubwindow() {
+        const int nb = config_.numBands;
+        const float inf = std::numeric_limits<float>::max();
+
+        std::copy(subMin_.begin(), subMin_.end(), ring_.begin() + static_cast<size_t>(ringPos_) * nb);
+        ringPos_ = (ringPos_ + 1) % config_.numSubwindows;
+        std::fill(subMin_.begin(), subMin_.end(), inf);
+
+        std::fill(windowMin_.begin(), windowMin_.end(), inf);
+        for (int u = 0; u < config_.numSubwindows; u++) {
+            const float* slot = ring_.data() + static_cast<size_t>(u) * nb;
+            for (int b = 0; b < nb; b++) {
+                windowMin_[b] = std::min(windowMin_[b], slot[b]);
+            }
+        }
+    }
+
+    Config config_;
+    int subwindowHops_ = 1;
+    float smoothCoeff_ = 0.0f;
+    float minPower_ = 0.0f;
+
+    std::vector<float> smoothed_;
+    std::vector<float> subMin_;     // Running minimum of the current sub-window
+    std::vector<float> windowMin_;  // Minimum over the stored sub-windows
+    std::vector<float> ring_;       // [subwindow][band] minima
+    std::vector<float> floor_;
+    std::vector<float> floorDb_;
+    std::vector<float> snrDb_;
+
+    int subwindowPhase_ = 0;
+    int ringPos_ = 0;
+    int64_t frames_ = 0;
+};
+
+} // namespace cortix
@@ -0,0 +1,129 @@
+/*
+ * Cortix - Raw PCM Decoding
+ *
+ * Converts interleaved little-endian PCM (s16 or f32, any channel count),
+ * as produced by e.g. `ffmpeg -f s16le -ac 2 -`, into mono float samples
+ * by averaging the channels. Input may arrive in arbitrary byte pieces;
+ * an incomplete sample frame at the end of one piece is carried over to
+ * the next.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <string>
+#include <algorithm>
+
+namespace cortix {
+
+enum class PcmFormat {
+    S16,        // Signed 16-bit little-endian
+    F32         // 32-bit float little-endian
+};
+
+/// Parse "s16"/"s16le" or "f32"/"f32le"; false if unknown
+inline bool parsePcmFormat(const std::string& name, PcmFormat& format) {
+    if (name == "s16" || name == "s16le") {
+        format = PcmFormat::S16;
+        return true;
+    }
+    if (name == "f32" || name == "f32le") {
+        format = PcmFormat::F32;
+        return true;
+    }
+    return false;
+}
+
+class PcmDecoder {
+public:
+    static constexpr int kMaxChannels = 64;
+
+    /// Callers validate channels against 1..kMaxChannels; out-of-range
+    /// counts are clamped only to keep the carry buffer in bounds
+    PcmDecoder(PcmFormat format, int channels)
+        : format_(format),
+          channels_(channels < 1 ? 1 : (channels > kMaxChannels ? kMaxChannels : channels)) {
+        frameBytes_ = channels_ * (format_ == PcmFormat::S16 ? 2 : 4);
+    }
+
+    /// Bytes per interleaved sample frame
+    int frameBytes() const { return frameBytes_; }
+    int channels() const { return channels_; }
+
+    /// Largest number of mono samples decode() can return for n bytes
+    size_t maxSamples(size_t numBytes) const {
+        return (numBytes + static_cast<size_t>(carried_)) / static_cast<size_t>(frameBytes_);
+    }
+
+    /// Decode bytes into mono samples; returns the number written to out
+    /// (at most maxSamples(numBytes))
+    size_t decode(const uint8_t* bytes, size_t numBytes, float* out) {
+        size_t written = 0;
+
+        // Complete a frame left over from the previous piece
+        if (carried_ > 0) {
+            const size_t take = std::min(numBytes, static_cast<size_t>(frameBytes_ - carried_));
+            std::memcpy(carry_ + carried_, bytes, take);
+            carried_ += static_cast<int>(take);
+            bytes += take;
+            numBytes -= take;
+            if (carried_ < frameBytes_) return 0;
+            out[written++] = frame(carry_);
+            carried_ = 0;
+        }
+
+        const size_t frames = numBytes / static_cast<size_t>(frameBytes_);
+        if (format_ == PcmFormat::S16 && channels_ == 1) {
+            for (size_t i = 0; i < frames; i++) {
+                out[written + i] = s16(bytes + 2 * i);
+            }
+        } else {
+            for (size_t i = 0; i < frames; i++) {
+                out[written + i] = frame(bytes + i * frameBytes_);
+            }
+        }
+        written += frames;
+
+        const size_t rest = numBytes - frames * frameBytes_;
+        std::memcpy(carry_, bytes + frames * frameBytes_, rest);
+        carried_ = static_cast<int>(rest);
+        return written;
+    }
+
+    /// Bytes of an incomplete frame held back
+    int pendingBytes() const { return carried_; }
+
+private:
+    static float s16(const uint8_t* p) {
+        const int16_t v = static_cast<int16_t>(static_cast<uint16_t>(p[0]) | static_cast<uint16_t>(p[1]) << 8);
+        return static_cast<float>(v) * (1.0f / 32768.0f);
+    }
+
+    static float f32(const uint8_t* p) {
+        const uint32_t bits = static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+                              static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+        float v;
+        std::memcpy(&v, &bits, 4);
+        return v;
+    }
+
+    float frame(const uint8_t* p) const {
+        float sum = 0.0f;
+        if (format_ == PcmFormat::S16) {
+            for (int c = 0; c < channels_; c++) sum += s16(p + 2 * c);
+        } else {
+            for (int c = 0; c < channels_; c++) sum += f32(p + 4 * c);
+        }
+        return sum / static_cast<float>(channels_);
+    }
+
+    PcmFormat format_;
+    int channels_;
+    int frameBytes_;
+    uint8_t carry_[kMaxChannels * 4];
+    int carried_ = 0;
+};
+
+} // namespace cortix
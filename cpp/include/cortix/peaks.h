@@ -0,0 +1,218 @@
+/*
+ * Cortix - Spectral Peaks and Partial Tracking
+ *
+ * Picks per-hop spectral peaks from the band envelope and links them into
+ * partial tracks over time (hum, whistles, feedback).
+ *
+ * Peak frequencies come from the filterbank's complex instantaneous
+ * frequency when it is supplied and lies inside the band; otherwise from
+ * parabolic interpolation of the dB envelope across bands. Tracks live in
+ * a fixed pool of slots allocated in configure(), and matching is a
+ * greedy nearest-frequency search, so process() never allocates.
+ */
+
+#pragma once
+
+#include "scales.h"
+#include "fastmath.h"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+namespace cortix {
+
+struct SpectralPeak {
+    float freqHz = 0.0f;
+    float magnitudeDb = 0.0f;
+    int band = 0;
+};
+
+struct PartialTrack {
+    int id = -1;                // Unique per tracker, -1 for a free slot
+    bool active = false;
+    int64_t startFrame = 0;     // Hop index where the track was born
+    int length = 0;             // Hops with a matched peak
+    int missed = 0;             // Consecutive hops without a match
+    float freqHz = 0.0f;        // Smoothed frequency
+    float magnitudeDb = 0.0f;   // Last matched level
+};
+
+class PartialTracker {
+public:
+    struct Config {
+        int maxPeaks = 16;
+        int maxTracks = 32;
+        float minDb = -80.0f;           // Ignore peaks below this level
+        float minProminenceDb = 3.0f;   // Above the mean of the bands two away
+        float maxJumpCents = 50.0f;     // Max frequency change to continue a track
+        int maxMissedFrames = 3;        // Hops a track survives without a match
+        float freqSmoothing = 0.5f;     // 0 = follow peaks exactly
+    };
+
+    PartialTracker() = default;
+
+    PartialTracker(const Config& config, const std::vector<BandInfo>& bands) {
+        configure(config, bands);
+    }
+
+    void configure(const Config& config, const std::vector<BandInfo>& bands) {
+        config_ = config;
+        config_.maxPeaks = std::max(1, config.maxPeaks);
+        config_.maxTracks = std::max(1, config.maxTracks);
+        bands_ = bands;
+
+        levelDb_.assign(bands.size(), 0.0f);
+        peaks_.assign(config_.maxPeaks, SpectralPeak{});
+        tracks_.assign(config_.maxTracks, PartialTrack{});
+        peakTrack_.assign(config_.maxPeaks, -1);
+        trackMatched_.assign(config_.maxTracks, 0);
+
+        reset();
+    }
+
+    void reset() {
+        std::fill(tracks_.begin(), tracks_.end(), PartialTrack{});
+        numPeaks_ = 0;
+        frame_ = 0;
+        nextId_ = 0;
+    }
+
+    /// Process one envelope frame. instantaneousHz (one per band) is optional.
+    void process(const float* envelope, const float* instantaneousHz = nullptr) {
+        pickPeaks(envelope, instantaneousHz);
+        updateTracks();
+        frame_++;
+    }
+
+    /// Peaks of the last frame, strongest first
+    const SpectralPeak* peaks() const { return peaks_.data(); }
+    int numPeaks() const { return numPeaks_; }
+
+    /// All track slots; check PartialTrack::active
+    const std::vector<PartialTrack>& tracks() const { return tracks_; }
+
+    /// Track slot matched by peak i of the last frame, or -1
+    int trackForPeak(int i) const { return peakTrack_[i]; }
+
+private:
+    void pickPeaks(const float* envelope, const float* instantaneousHz) {
+        const int nb = static_cast<int>(bands_.size());
+        for (int b = 0; b < nb; b++) {
+            levelDb_[b] = fastPowerToDb(envelope[b] * envelope[b] + 1e-20f);
+        }
+
+        numPeaks_ = 0;
+        for (int b = 1; b < nb - 1; b++) {
+            const float l = levelDb_[b];
+            if (l < config_.minDb || l <= levelDb_[b - 1] || l < levelDb_[b + 1]) continue;
+
+            const float left = levelDb_[std::max(b - 2, 0)];
+            const float right = levelDb_[std::min(b + 2, nb - 1)];
+            if (l - 0.5f * (left + right) < config_.minProminenceDb) continue;
+
+            // Parabolic interpolation across bands
+            const float a = levelDb_[b - 1];
+            const float c = levelDb_[b + 1];
+            const float denom = a - 2.0f * l + c;
+            const float delta = denom < 0.0f ? 0.5f * (a - c) / denom : 0.0f;
+
+            SpectralPeak peak;
+            peak.band = b;
+            peak.magnitudeDb = l - 0.25f * (a - c) * delta;
+
+            const float inst = instantaneousHz ? instantaneousHz[b] : 0.0f;
+            if (inst >= bands_[b].lowHz && inst <= bands_[b].highHz) {
+                peak.freqHz = inst;
+            } else {
+                const int other = delta >= 0.0f ? b + 1 : b - 1;
+                const float t = std::abs(delta);
+                peak.freqHz = bands_[b].centerHz * std::pow(bands_[other].centerHz / bands_[b].centerHz, t);
+            }
+
+            insertPeak(peak);
+        }
+    }
+
+    void insertPeak(const SpectralPeak& peak) {
+        int pos = numPeaks_;
+        while (pos > 0 && peaks_[pos - 1].magnitudeDb < peak.magnitudeDb) pos--;
+        if (pos >= config_.maxPeaks) return;
+        const int last = std::min(numPeaks_, config_.maxPeaks - 1);
+        for (int j = last; j > pos; j--) {
+            peaks_[j] = peaks_[j - 1];
+        }
+        peaks_[pos] = peak;
+        numPeaks_ = std::min(numPeaks_ + 1, config_.maxPeaks);
+    }
+
+    void updateTracks() {
+        const int nt = config_.maxTracks;
+        std::fill(trackMatched_.begin(), trackMatched_.end(), 0);
+
+        // Strongest peaks claim the nearest free track first
+        const float maxRatio = config_.maxJumpCents / 1200.0f;
+        for (int p = 0; p < numPeaks_; p++) {
+            const SpectralPeak& peak = peaks_[p];
+            int best = -1;
+            float bestDist = maxRatio;
+            for (int t = 0; t < nt; t++) {
+                if (!tracks_[t].active || trackMatched_[t]) continue;
+                const float dist = std::abs(std::log2(peak.freqHz / tracks_[t].freqHz));
+                if (dist <= bestDist) {
+                    bestDist = dist;
+                    best = t;
+                }
+            }
+
+            if (best < 0) {
+                // Birth: take a free slot, or drop the peak if the pool is full
+                for (int t = 0; t < nt; t++) {
+                    if (!tracks_[t].active) {
+                        best = t;
+                        PartialTrack& track = tracks_[t];
+                        track.id = nextId_++;
+                        track.active = true;
+                        track.startFrame = frame_;
+                        track.length = 0;
+                        track.freqHz = peak.freqHz;
+                        break;
+                    }
+                }
+            }
+
+            peakTrack_[p] = best;
+            if (best < 0) continue;
+
+            PartialTrack& track = tracks_[best];
+            const float s = track.length > 0 ? config_.freqSmoothing : 0.0f;
+            track.freqHz = s * track.freqHz + (1.0f - s) * peak.freqHz;
+            track.magnitudeDb = peak.magnitudeDb;
+            track.length++;
+            track.missed = 0;
+            trackMatched_[best] = 1;
+        }
+
+        // Age unmatched tracks and free the ones that ran out
+        for (int t = 0; t < nt; t++) {
+            PartialTrack& track = tracks_[t];
+            if (!track.active || trackMatched_[t]) continue;
+            if (++track.missed > config_.maxMissedFrames) {
+                track = PartialTrack{};
+            }
+        }
+    }
+
+    Config config_;
+    std::vector<BandInfo> bands_;
+    std::vector<float> levelDb_;
+    std::vector<SpectralPeak> peaks_;
+    std::vector<PartialTrack> tracks_;
+    std::vector<int> peakTrack_;
+    std::vector<char> trackMatched_;
+    int numPeaks_ = 0;
+    int64_t frame_ = 0;
+    int nextId_ = 0;
+};
+
+} // namespace cortix
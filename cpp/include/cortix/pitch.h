@@ -0,0 +1,228 @@
+/*
+ * Cortix - Correlogram Pitch Estimation
+ *
+ * Summary-autocorrelation (SACF) pitch tracker running on gammatone band
+ * signals, after Meddis & Hewitt (1991) and Tolonen & Karjalainen (2000).
+ *
+ * Each band is half-wave rectified, square-root compressed, decimated to
+ * an analysis rate of ~12 kHz and DC-blocked. A running (leaky)
+ * autocorrelation is kept per lag, already summed across bands, so the
+ * per-sample cost is O(bands * lags) with a contiguous inner loop over
+ * lags. F0 candidates are picked once per hop from the enhanced SACF.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace cortix {
+
+constexpr int kMaxPitchCandidates = 8;
+
+struct PitchCandidate {
+    float f0Hz = 0.0f;      // Fundamental frequency estimate
+    float salience = 0.0f;  // Normalized SACF peak height (0..1)
+};
+
+struct PitchEstimate {
+    int numCandidates = 0;
+    PitchCandidate candidates[kMaxPitchCandidates];  // Sorted by salience, descending
+};
+
+//=============================================================================
+// Correlogram Pitch Tracker
+//=============================================================================
+
+class CorrelogramPitch {
+public:
+    static constexpr int kMaxStretch = 5;   // Highest period multiple suppressed
+
+    struct Config {
+        int numBands = 40;
+        float sampleRate = 48000.0f;
+        float minF0 = 60.0f;
+        float maxF0 = 1000.0f;
+        float analysisRateHz = 12000.0f;  // Upper bound on the decimated rate
+        float integrationMs = 25.0f;      // Leaky autocorrelation time constant
+        int maxCandidates = 4;            // At most kMaxPitchCandidates
+        float minSalience = 0.1f;         // Peaks below this are ignored
+    };
+
+    CorrelogramPitch() = default;
+
+    explicit CorrelogramPitch(const Config& config) {
+        configure(config);
+    }
+
+    void configure(const Config& config) {
+        config_ = config;
+        config_.maxCandidates = std::clamp(config.maxCandidates, 1, kMaxPitchCandidates);
+
+        decimation_ = std::max(1, static_cast<int>(std::ceil(config.sampleRate / config.analysisRateHz)));
+        rate_ = config.sampleRate / decimation_;
+
+        minLag_ = std::max(2, static_cast<int>(std::floor(rate_ / config.maxF0)));
+        maxLag_ = std::max(minLag_ + 2, static_cast<int>(std::ceil(rate_ / config.minF0)));
+        lineLength_ = maxLag_ + 1;
+
+        leak_ = std::exp(-1.0f / (config.integrationMs / 1000.0f * rate_));
+        // DC tracker must be slower than the longest period of interest
+        dcCoeff_ = std::exp(-1.0f / (0.05f * rate_));
+
+        // Mirrored delay lines: each band stores 2 * lineLength_ samples so
+        // that lags 0..maxLag_ are always one contiguous run.
+        lines_.assign(static_cast<size_t>(config.numBands) * lineLength_ * 2, 0.0f);
+        accum_.assign(config.numBands, 0.0f);
+        dc_.assign(config.numBands, 0.0f);
+        acf_.assign(lineLength_, 0.0f);
+        summary_.assign(lineLength_, 0.0f);
+
+        reset();
+    }
+
+    void reset() {
+        std::fill(lines_.begin(), lines_.end(), 0.0f);
+        std::fill(accum_.begin(), accum_.end(), 0.0f);
+        std::fill(dc_.begin(), dc_.end(), 0.0f);
+        std::fill(acf_.begin(), acf_.end(), 0.0f);
+        std::fill(summary_.begin(), summary_.end(), 0.0f);
+        phase_ = 0;
+        linePos_ = 0;
+        estimate_ = PitchEstimate{};
+    }
+
+    /// Feed band signals (sample-major: bandSignals[i * numBands + band])
+    void process(const float* bandSignals, int numSamples) {
+        const int nb = config_.numBands;
+        for (int i = 0; i < numSamples; i++) {
+            const float* x = bandSignals + static_cast<size_t>(i) * nb;
+            for (int b = 0; b < nb; b++) {
+                accum_[b] += std::sqrt(std::max(x[b], 0.0f));
+            }
+            if (++phase_ == decimation_) {
+                phase_ = 0;
+                pushDecimated();
+            }
+        }
+    }
+
+    /// Pick F0 candidates from the current SACF (call once per hop)
+    const PitchEstimate& updateEstimate() {
+        const float norm = acf_[0] > 1e-12f ? 1.0f / acf_[0] : 0.0f;
+
+        // Enhanced SACF: clip, then subtract the 2x..5x time-stretched
+        // copies to suppress peaks at multiples of the period. 2x alone
+        // leaves the peak at 3x the period as tall as the period's own.
+        for (int k = 0; k <= maxLag_; k++) {
+            summary_[k] = std::max(acf_[k] * norm, 0.0f);
+        }
+        for (int factor = 2; factor <= kMaxStretch; factor++) {
+            const float inv = 1.0f / factor;
+            for (int k = maxLag_; k >= 1; k--) {
+                const float pos = k * inv;
+                const int h = static_cast<int>(pos);
+                const float frac = pos - h;
+                const float stretched = summary_[h] + frac * (summary_[h + 1] - summary_[h]);
+                summary_[k] = std::max(summary_[k] - stretched, 0.0f);
+            }
+        }
+
+        PitchEstimate est;
+        for (int k = minLag_; k < maxLag_; k++) {
+            const float a = summary_[k - 1];
+            const float b = summary_[k];
+            const float c = summary_[k + 1];
+            if (b < config_.minSalience || b <= a || b < c) continue;
+
+            // Parabolic interpolation of the peak lag
+            const float denom = a - 2.0f * b + c;
+            const float delta = denom < 0.0f ? 0.5f * (a - c) / denom : 0.0f;
+            PitchCandidate cand;
+            cand.f0Hz = rate_ / (k + delta);
+            cand.salience = std::min(b - 0.25f * (a - c) * delta, 1.0f);
+
+            // Insert into the sorted candidate list
+            int pos = est.numCandidates;
+            while (pos > 0 && est.candidates[pos - 1].salience < cand.salience) pos--;
+            if (pos >= config_.maxCandidates) continue;
+            const int last = std::min(est.numCandidates, config_.maxCandidates - 1);
+            for (int j = last; j > pos; j--) {
+                est.candidates[j] = est.candidates[j - 1];
+            }
+            est.candidates[pos] = cand;
+            est.numCandidates = std::min(est.numCandidates + 1, config_.maxCandidates);
+        }
+
+        estimate_ = est;
+        return estimate_;
+    }
+
+    /// Most recent estimate
+    const PitchEstimate& estimate() const { return estimate_; }
+
+    /// Enhanced, normalized SACF from the last update (index = lag)
+    const std::vector<float>& summary() const { return summary_; }
+
+    /// Frequency in Hz corresponding to an SACF lag
+    float lagToHz(float lag) const { return lag > 0.0f ? rate_ / lag : 0.0f; }
+
+    /// Decimated analysis rate in Hz
+    float analysisRate() const { return rate_; }
+
+    /// Bytes of running state (delay lines and autocorrelation)
+    size_t stateBytes() const {
+        return (lines_.size() + accum_.size() + dc_.size() + acf_.size()) * sizeof(float);
+    }
+
+private:
+    void pushDecimated() {
+        const int nb = config_.numBands;
+        const float scale = 1.0f / decimation_;
+
+        linePos_ = (linePos_ == 0) ? lineLength_ - 1 : linePos_ - 1;
+
+        for (int k = 0; k <= maxLag_; k++) {
+            acf_[k] *= leak_;
+        }
+
+        for (int b = 0; b < nb; b++) {
+            const float v = accum_[b] * scale;
+            accum_[b] = 0.0f;
+            dc_[b] = dcCoeff_ * dc_[b] + (1.0f - dcCoeff_) * v;
+            const float x = v - dc_[b];
+
+            // Newest sample at linePos_, so line[k] is the sample k steps back
+            float* line = lines_.data() + static_cast<size_t>(b) * lineLength_ * 2;
+            line[linePos_] = x;
+            line[linePos_ + lineLength_] = x;
+
+            const float* past = line + linePos_;
+            for (int k = 0; k <= maxLag_; k++) {
+                acf_[k] += x * past[k];
+            }
+        }
+    }
+
+    Config config_;
+    int decimation_ = 1;
+    float rate_ = 48000.0f;
+    int minLag_ = 2;
+    int maxLag_ = 4;
+    int lineLength_ = 5;
+    float leak_ = 0.0f;
+    float dcCoeff_ = 0.0f;
+
+    int phase_ = 0;
+    int linePos_ = 0;
+
+    std::vector<float> lines_;
+    std::vector<float> accum_;
+    std::vector<float> dc_;
+    std::vector<float> acf_;
+    std::vector<float> summary_;
+    PitchEstimate estimate_;
+};
+
+} // namespace cortix
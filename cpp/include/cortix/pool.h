@@ -0,0 +1,754 @@
+/*
+ * Cortix - Multi-Stream Analyser Pool
+ *
+ * Hosts many independent streams, each with its own Analyser, on a fixed
+ * set of worker threads.
+ *
+ * - Ordering: a stream is queued on at most one worker at a time and its
+ *   blocks are processed in submission order, so frame callbacks of one
+ *   stream never run concurrently or out of order.
+ * - Work stealing: each worker owns a queue of ready streams. A stream is
+ *   queued on its home worker (the worker owning its tile) so its state
+ *   stays in one cache; idle workers steal from the back of other queues.
+ * - Batching: streams are created from registered designs (an
+ *   Analyser::Config). A worker takes up to batchSize consecutive ready
+ *   streams of the same design and runs them back to back, so the same
+ *   vectorized band loops, trip counts and stage set stay hot.
+ * - Backpressure: submit() refuses a block when the stream already has
+ *   maxQueuedSamples waiting, and per-stream and pool counters report
+ *   queue depth, rejections and steals.
+ * - Placement: workers are spread over NUMA nodes (optionally pinned),
+ *   streams are grouped per design into tiles whose state fits in L2 and
+ *   every tile lives on one worker. Stream state is built by the home
+ *   worker while bound to its node, so first touch (from that thread's
+ *   own malloc arena) puts it in local memory, and the node its pages
+ *   actually landed on is read back from the kernel. Thieves prefer
+ *   victims on their own node. placement() reports where streams ran.
+ * - Priorities: streams are real-time or offline. Every block carries a
+ *   deadline (by default submit time plus the class budget). Ready
+ *   real-time streams are served earliest deadline first, ahead of all
+ *   offline work, and an offline visit yields to them at the next block
+ *   boundary. classStats() reports deadline misses, preemptions and a
+ *   log2 latency histogram per class.
+ *
+ * This header needs threads; it is not included by cortix.h.
+ */
+
+#pragma once
+
+#include "analyser.h"
+#include "topology.h"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <chrono>
+#include <array>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+namespace cortix {
+
+class AnalyserPool {
+public:
+    using StreamId = int;
+    using DesignId = int;
+    using Clock = std::chrono::steady_clock;
+
+    /// Scheduling class of a stream
+    enum class Priority { RealTime = 0, Offline = 1 };
+    static constexpr int kNumPriorities = 2;
+    static constexpr int kLatencyBins = 24;     // log2 microseconds, up to ~16 s
+
+    struct Config {
+        int numThreads = 0;                 // 0 = hardware concurrency
+        int maxStreams = 65536;
+        int batchSize = 8;                  // Streams of one design run back to back
+        int maxBlocksPerVisit = 16;         // Fairness: requeue a stream after this many blocks
+        int64_t maxQueuedSamples = 48000;   // Per stream, before submit() refuses blocks
+
+        bool pinThreads = false;            // Bind each worker to one CPU
+        bool firstTouch = true;             // Build stream state on the home worker, on its node
+        int64_t tileBytes = 0;              // Stream state per tile; 0 = L2 size
+
+        double realTimeBudgetMs = 10.0;     // Default deadline after submit; 0 = none
+        double offlineBudgetMs = 0.0;
+    };
+
+    /// Counters for one stream (snapshot)
+    struct StreamStats {
+        int64_t queuedSamples = 0;      // Submitted but not yet processed
+        int64_t peakQueuedSamples = 0;
+        int64_t processedSamples = 0;
+        int64_t processedBlocks = 0;
+        int64_t rejectedBlocks = 0;     // Refused by backpressure
+        int node = 0;                   // NUMA node the stream's state landed on
+        int tile = 0;
+        int homeWorker = 0;
+        Priority priority = Priority::Offline;
+        int64_t deadlineMisses = 0;
+    };
+
+    /// Pool-wide counters (snapshot)
+    struct PoolStats {
+        int64_t processedBlocks = 0;
+        int64_t rejectedBlocks = 0;
+        int64_t batches = 0;            // Worker visits
+        int64_t batchedStreams = 0;     // Streams run in those visits
+        int64_t steals = 0;             // Visits taken from another worker's queue
+    };
+
+    /// Per-class scheduling counters (snapshot)
+    struct ClassStats {
+        int64_t processedBlocks = 0;
+        int64_t deadlineMisses = 0;     // Blocks finished after their deadline
+        int64_t preemptions = 0;        // Visits cut short for real-time work
+        int64_t maxLatencyUs = 0;       // Submit to processed
+        std::array<int64_t, kLatencyBins> latencyHistogram{};  // Bin k: < 2^(k+1) us
+
+        /// Upper edge in microseconds of the bin holding latency quantile q
+        int64_t latencyQuantileUs(float q) const {
+            int64_t total = 0;
+            for (int64_t c : latencyHistogram) total += c;
+            if (total == 0) return 0;
+            const int64_t target = std::max<int64_t>(1, static_cast<int64_t>(std::ceil(q * total)));
+            int64_t sum = 0;
+            for (int k = 0; k < kLatencyBins; k++) {
+                sum += latencyHistogram[k];
+                if (sum >= target) return int64_t(2) << k;
+            }
+            return int64_t(2) << (kLatencyBins - 1);
+        }
+    };
+
+    /// Where workers sit and how often streams ran on their own node
+    struct PlacementStats {
+        struct WorkerInfo {
+            int cpu = -1;               // Assigned CPU
+            int node = 0;
+            bool pinned = false;
+            int64_t streamRuns = 0;     // Stream visits on this worker
+            int64_t remoteRuns = 0;     // ... of streams whose state is on another node
+        };
+        std::vector<WorkerInfo> workers;
+        int numNodes = 1;
+        int64_t l2Bytes = 0;
+        int numTiles = 0;
+        int64_t localRuns = 0;
+        int64_t remoteRuns = 0;
+        int64_t misplacedStreams = 0;   // Open streams whose state is off their home node
+    };
+
+    AnalyserPool() : AnalyserPool(Config{}) {}
+
+    explicit AnalyserPool(const Config& config, const CpuTopology& topology = CpuTopology::detect())
+        : config_(config), topology_(topology) {
+        config_.batchSize = std::max(1, config.batchSize);
+        config_.maxBlocksPerVisit = std::max(1, config.maxBlocksPerVisit);
+        config_.maxStreams = std::max(1, config.maxStreams);
+        int threads = config.numThreads > 0 ? config.numThreads
+                                            : static_cast<int>(std::thread::hardware_concurrency());
+        threads = std::max(1, threads);
+
+        streams_.resize(config_.maxStreams);
+        if (config_.tileBytes <= 0) config_.tileBytes = topology_.l2Bytes;
+
+        // Spread workers over the nodes, one CPU each
+        const std::vector<int> cpus = topology_.interleavedCpus();
+        workers_.reserve(threads);
+        for (int i = 0; i < threads; i++) {
+            auto w = std::make_unique<Worker>();
+            w->cpu = cpus[i % cpus.size()];
+            w->node = topology_.nodeOfCpu(w->cpu);
+            workers_.push_back(std::move(w));
+        }
+
+        // Steal from workers on the same node first
+        for (int i = 0; i < threads; i++) {
+            for (int k = 1; k < threads; k++) {
+                const int v = (i + k) % threads;
+                if (workers_[v]->node == workers_[i]->node) workers_[i]->victims.push_back(v);
+            }
+            for (int k = 1; k < threads; k++) {
+                const int v = (i + k) % threads;
+                if (workers_[v]->node != workers_[i]->node) workers_[i]->victims.push_back(v);
+            }
+        }
+
+        for (int i = 0; i < threads; i++) {
+            workers_[i]->thread = std::thread([this, i] { run(i); });
+        }
+    }
+
+    ~AnalyserPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            stop_ = true;
+        }
+        sleepCv_.notify_all();
+        for (auto& w : workers_) {
+            w->thread.join();
+        }
+    }
+
+    AnalyserPool(const AnalyserPool&) = delete;
+    AnalyserPool& operator=(const AnalyserPool&) = delete;
+
+    /// Register an analyser design; streams created from it are batched together
+    DesignId addDesign(const Analyser::Config& config) {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        designs_.push_back(config);
+        const Analyser probe(config);
+        const int64_t bytes = std::max<int64_t>(1, static_cast<int64_t>(probe.stateBytes()));
+        designTiles_.push_back(DesignTiles{std::max<int64_t>(1, config_.tileBytes / bytes), -1, 0, 0});
+        return static_cast<DesignId>(designs_.size() - 1);
+    }
+
+    /// Create a stream from a design. Returns -1 when maxStreams are in use.
+    /// Submit to a stream only between addStream() and removeStream().
+    /// With firstTouch on a multi-node topology the home worker builds the
+    /// stream state, so this waits for that worker to finish its current visit.
+    StreamId addStream(DesignId design, Priority priority = Priority::Offline) {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        for (int i = 0; i < config_.maxStreams; i++) {
+            const int id = (nextStream_ + i) % config_.maxStreams;
+            if (streams_[id]) continue;
+
+            // Fill the design's current tile, or open a new one on the next worker
+            DesignTiles& tiles = designTiles_[design];
+            if (tiles.tile < 0 || tiles.fill >= tiles.streamsPerTile) {
+                tiles.tile = numTiles_++;
+                tiles.worker = nextTileWorker_;
+                tiles.fill = 0;
+                nextTileWorker_ = (nextTileWorker_ + 1) % static_cast<int>(workers_.size());
+            }
+            tiles.fill++;
+            const Worker& home = *workers_[tiles.worker];
+
+            // Pinning the caller alone is not enough: its malloc arena hands
+            // back pages it already touched, wherever that was
+            std::unique_ptr<Stream> stream;
+            if (config_.firstTouch && topology_.nodes.size() > 1) {
+                runOnWorker(tiles.worker, [&] {
+                    ScopedAffinity onNode(topology_.nodes[home.node].cpus);
+                    stream = std::make_unique<Stream>(designs_[design]);
+                });
+            } else {
+                stream = std::make_unique<Stream>(designs_[design]);
+            }
+            const int node = topology_.nodeOfAddress(stream.get());
+            stream->id = id;
+            stream->design = design;
+            stream->home = tiles.worker;
+            stream->tile = tiles.tile;
+            stream->node = node >= 0 ? node : home.node;
+            stream->priority = priority;
+            if (stream->node != home.node) misplacedStreams_++;
+            streams_[id] = std::move(stream);
+            nextStream_ = id + 1;
+            return id;
+        }
+        return -1;
+    }
+
+    /// Drop a stream and its queued blocks. Waits for a running block to finish.
+    void removeStream(StreamId id) {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        Stream* s = streams_[id].get();
+        if (!s) return;
+        // The worker releases the stream under its lock and signals it
+        {
+            std::unique_lock<std::mutex> queueLock(s->mutex);
+            close(*s);
+            s->released.wait(queueLock, [s] { return !s->scheduled.load(std::memory_order_acquire); });
+        }
+        freeStream(id);
+    }
+
+    /// removeStream() without the wait, for threads that must not block: the
+    /// stream stops taking and running blocks at once, but while a block is
+    /// still running it stays allocated (its frame callback may still be
+    /// called) and this returns false. Call again until it returns true.
+    bool tryRemoveStream(StreamId id) {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        Stream* s = streams_[id].get();
+        if (!s) return true;
+        {
+            std::lock_guard<std::mutex> queueLock(s->mutex);
+            close(*s);
+            if (s->scheduled.load(std::memory_order_acquire)) return false;
+        }
+        freeStream(id);
+        return true;
+    }
+
+    /// Called on a worker thread for every frame of the stream. Set before
+    /// submitting to the stream.
+    void setFrameCallback(StreamId id, Analyser::FrameCallback callback) {
+        streams_[id]->analyser.setFrameCallback(std::move(callback));
+    }
+
+    /// Queue a block of samples for a stream (copied). Returns false if the
+    /// stream is over its queue limit; the block is then dropped and counted.
+    /// The block's deadline is the submit time plus the class budget.
+    bool submit(StreamId id, const float* samples, int numSamples) {
+        const Stream* s = streams_[id].get();
+        if (!s) return false;
+        const Clock::time_point now = Clock::now();
+        const double budgetMs = s->priority == Priority::RealTime ? config_.realTimeBudgetMs
+                                                                  : config_.offlineBudgetMs;
+        const Clock::time_point deadline = budgetMs > 0.0
+            ? now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(budgetMs))
+            : Clock::time_point::max();
+        return submitBlock(id, samples, numSamples, deadline, now);
+    }
+
+    /// Same, with an explicit deadline for this block
+    bool submit(StreamId id, const float* samples, int numSamples, Clock::time_point deadline) {
+        return submitBlock(id, samples, numSamples, deadline, Clock::now());
+    }
+
+    /// Block until every submitted block has been processed
+    void drain() {
+        std::unique_lock<std::mutex> lock(drainMutex_);
+        drainCv_.wait(lock, [this] { return outstandingBlocks_.load(std::memory_order_acquire) == 0; });
+    }
+
+    StreamStats streamStats(StreamId id) const {
+        const Stream* s = streams_[id].get();
+        StreamStats stats;
+        if (!s) return stats;
+        std::lock_guard<std::mutex> lock(s->mutex);
+        stats.queuedSamples = s->queuedSamples;
+        stats.peakQueuedSamples = s->peakQueuedSamples;
+        stats.processedSamples = s->processedSamples;
+        stats.processedBlocks = s->processedBlocks;
+        stats.rejectedBlocks = s->rejectedBlocks;
+        stats.node = s->node;
+        stats.tile = s->tile;
+        stats.homeWorker = s->home;
+        stats.priority = s->priority;
+        stats.deadlineMisses = s->deadlineMisses;
+        return stats;
+    }
+
+    PlacementStats placement() const {
+        PlacementStats stats;
+        stats.numNodes = static_cast<int>(topology_.nodes.size());
+        stats.l2Bytes = topology_.l2Bytes;
+        {
+            std::lock_guard<std::mutex> lock(controlMutex_);
+            stats.numTiles = numTiles_;
+            stats.misplacedStreams = misplacedStreams_;
+        }
+        for (const auto& w : workers_) {
+            PlacementStats::WorkerInfo info;
+            info.cpu = w->cpu;
+            info.node = w->node;
+            info.pinned = w->pinned.load(std::memory_order_relaxed);
+            info.streamRuns = w->streamRuns.load(std::memory_order_relaxed);
+            info.remoteRuns = w->remoteRuns.load(std::memory_order_relaxed);
+            stats.localRuns += info.streamRuns - info.remoteRuns;
+            stats.remoteRuns += info.remoteRuns;
+            stats.workers.push_back(info);
+        }
+        return stats;
+    }
+
+    ClassStats classStats(Priority priority) const {
+        const ClassCounters& c = classes_[static_cast<int>(priority)];
+        ClassStats stats;
+        stats.processedBlocks = c.processedBlocks.load(std::memory_order_relaxed);
+        stats.deadlineMisses = c.deadlineMisses.load(std::memory_order_relaxed);
+        stats.preemptions = c.preemptions.load(std::memory_order_relaxed);
+        stats.maxLatencyUs = c.maxLatencyUs.load(std::memory_order_relaxed);
+        for (int k = 0; k < kLatencyBins; k++) {
+            stats.latencyHistogram[k] = c.latencyHistogram[k].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+    /// Streams of a design that share one tile
+    int64_t streamsPerTile(DesignId design) const {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        return designTiles_[design].streamsPerTile;
+    }
+
+    PoolStats stats() const {
+        PoolStats stats;
+        stats.processedBlocks = processedBlocks_.load(std::memory_order_relaxed);
+        stats.rejectedBlocks = rejectedBlocks_.load(std::memory_order_relaxed);
+        stats.batches = batches_.load(std::memory_order_relaxed);
+        stats.batchedStreams = batchedStreams_.load(std::memory_order_relaxed);
+        stats.steals = steals_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /// Analyser of a stream, e.g. to read results after drain(). Not safe
+    /// while the stream has blocks in flight.
+    const Analyser& analyser(StreamId id) const { return streams_[id]->analyser; }
+
+    int numThreads() const { return static_cast<int>(workers_.size()); }
+
+private:
+    struct Block {
+        std::vector<float> samples;
+        Clock::time_point submitted;
+        Clock::time_point deadline;
+    };
+
+    struct Stream {
+        explicit Stream(const Analyser::Config& config) : analyser(config) {}
+
+        Analyser analyser;
+        int id = 0;
+        DesignId design = 0;
+        int home = 0;                       // Worker whose queue the stream joins
+        int tile = 0;
+        int node = 0;
+        Priority priority = Priority::Offline;
+        Clock::time_point queuedDeadline;   // Head block deadline when queued (worker lock)
+
+        mutable std::mutex mutex;           // Guards the block queue and counters
+        std::deque<Block> blocks;
+        std::vector<std::vector<float>> spare;  // Recycled sample buffers
+        bool closed = false;
+        int64_t queuedSamples = 0;
+        int64_t peakQueuedSamples = 0;
+        int64_t processedSamples = 0;
+        int64_t processedBlocks = 0;
+        int64_t rejectedBlocks = 0;
+        int64_t deadlineMisses = 0;
+
+        std::atomic<bool> scheduled{false}; // In a worker queue or running
+        std::condition_variable released;   // scheduled cleared (under mutex)
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Stream*> ready[kNumPriorities];  // Real-time queue is deadline ordered
+        std::thread thread;
+        int cpu = -1;
+        int node = 0;
+        std::vector<int> victims;           // Steal order: same node first
+        std::deque<std::packaged_task<void()>> tasks;   // runOnWorker() jobs (mutex)
+        bool taskPending = false;           // tasks may be non-empty (sleepMutex_)
+        std::atomic<bool> pinned{false};
+        std::atomic<int64_t> streamRuns{0};
+        std::atomic<int64_t> remoteRuns{0};
+    };
+
+    struct DesignTiles {
+        int64_t streamsPerTile = 1;
+        int tile = -1;                      // Tile being filled
+        int worker = 0;
+        int64_t fill = 0;
+    };
+
+    struct ClassCounters {
+        std::atomic<int64_t> processedBlocks{0};
+        std::atomic<int64_t> deadlineMisses{0};
+        std::atomic<int64_t> preemptions{0};
+        std::atomic<int64_t> maxLatencyUs{0};
+        std::array<std::atomic<int64_t>, kLatencyBins> latencyHistogram{};
+    };
+
+    /// Copy a block into the stream queue and schedule the stream
+    bool submitBlock(StreamId id, const float* samples, int numSamples,
+                     Clock::time_point deadline, Clock::time_point now) {
+        Stream* s = streams_[id].get();
+        if (!s || numSamples <= 0) return false;
+        {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            if (s->closed) return false;
+            if (s->queuedSamples + numSamples > config_.maxQueuedSamples && s->queuedSamples > 0) {
+                s->rejectedBlocks++;
+                rejectedBlocks_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            Block block;
+            if (!s->spare.empty()) {
+                block.samples = std::move(s->spare.back());
+                s->spare.pop_back();
+            }
+            block.samples.assign(samples, samples + numSamples);
+            block.submitted = now;
+            block.deadline = deadline;
+            s->blocks.push_back(std::move(block));
+            s->queuedSamples += numSamples;
+            s->peakQueuedSamples = std::max(s->peakQueuedSamples, s->queuedSamples);
+            outstandingBlocks_.fetch_add(1, std::memory_order_relaxed);
+        }
+        schedule(s);
+        return true;
+    }
+
+    /// Free an idle, closed stream (control lock held)
+    void freeStream(StreamId id) {
+        const Stream& s = *streams_[id];
+        if (s.node != workers_[s.home]->node) misplacedStreams_--;
+        streams_[id].reset();
+    }
+
+    /// Run a job on a worker's thread before its next visit and wait for
+    /// it. Jobs from a worker thread (a frame callback) run in place.
+    void runOnWorker(int worker, const std::function<void()>& job) {
+        for (const auto& w : workers_) {
+            if (w->thread.get_id() == std::this_thread::get_id()) {
+                job();
+                return;
+            }
+        }
+        Worker& w = *workers_[worker];
+        std::packaged_task<void()> task(job);
+        std::future<void> done = task.get_future();
+        {
+            std::lock_guard<std::mutex> lock(w.mutex);
+            w.tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            w.taskPending = true;
+        }
+        sleepCv_.notify_all();
+        done.get();
+    }
+
+    /// Refuse further blocks and drop the queued ones (stream lock held)
+    void close(Stream& s) {
+        if (s.closed) return;
+        s.closed = true;
+        for (const Block& b : s.blocks) {
+            s.queuedSamples -= static_cast<int64_t>(b.samples.size());
+            finishBlock();
+        }
+        s.blocks.clear();
+    }
+
+    /// Queue a stream on its home worker unless it is already queued or running
+    void schedule(Stream* s) {
+        if (s->scheduled.exchange(true, std::memory_order_acq_rel)) return;
+        enqueue(s);
+    }
+
+    void enqueue(Stream* s) {
+        Worker& w = *workers_[s->home];
+        if (s->priority == Priority::RealTime) {
+            Clock::time_point deadline = Clock::time_point::max();
+            {
+                std::lock_guard<std::mutex> lock(s->mutex);
+                if (!s->blocks.empty()) deadline = s->blocks.front().deadline;
+            }
+            {
+                std::lock_guard<std::mutex> lock(w.mutex);
+                s->queuedDeadline = deadline;
+                auto& queue = w.ready[static_cast<int>(Priority::RealTime)];
+                auto it = queue.end();
+                while (it != queue.begin() && (*(it - 1))->queuedDeadline > deadline) --it;
+                queue.insert(it, s);
+            }
+            readyRealTime_.fetch_add(1, std::memory_order_release);
+        } else {
+            std::lock_guard<std::mutex> lock(w.mutex);
+            w.ready[static_cast<int>(Priority::Offline)].push_back(s);
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            readyStreams_++;
+        }
+        sleepCv_.notify_one();
+    }
+
+    /// Pop a batch of streams of one tile (hence one design) from a worker's
+    /// queue of one class. Real-time queues are always taken from the front.
+    /// readyStreams_ drops in the same critical section, so it never counts
+    /// a stream that has already left its queue.
+    int takeBatch(Worker& w, Priority priority, Stream** batch, bool fromBack) {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        auto& ready = w.ready[static_cast<int>(priority)];
+        if (ready.empty()) return 0;
+        int n = 0;
+        if (fromBack && priority == Priority::Offline) {
+            batch[n++] = ready.back();
+            ready.pop_back();
+            while (n < config_.batchSize && !ready.empty() && ready.back()->tile == batch[0]->tile) {
+                batch[n++] = ready.back();
+                ready.pop_back();
+            }
+        } else {
+            batch[n++] = ready.front();
+            ready.pop_front();
+            while (n < config_.batchSize && !ready.empty() && ready.front()->tile == batch[0]->tile) {
+                batch[n++] = ready.front();
+                ready.pop_front();
+            }
+        }
+        if (priority == Priority::RealTime) readyRealTime_.fetch_sub(n, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> sleepLock(sleepMutex_);
+            readyStreams_ -= n;
+        }
+        return n;
+    }
+
+    bool realTimePending() const {
+        return readyRealTime_.load(std::memory_order_acquire) > 0;
+    }
+
+    void run(int self) {
+        std::vector<Stream*> batch(config_.batchSize);
+        Worker& me = *workers_[self];
+        if (config_.pinThreads) {
+            me.pinned = pinCurrentThread({me.cpu});
+        }
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(sleepMutex_);
+                sleepCv_.wait(lock, [&] { return stop_ || readyStreams_ > 0 || me.taskPending; });
+                if (stop_) return;
+                me.taskPending = false;
+            }
+            std::deque<std::packaged_task<void()>> tasks;
+            {
+                std::lock_guard<std::mutex> lock(me.mutex);
+                tasks.swap(me.tasks);
+            }
+            for (auto& task : tasks) task();
+
+            // Real-time work anywhere before offline work; within a class
+            // the own queue first, then steal from the others
+            int n = 0;
+            Priority priority = Priority::RealTime;
+            for (int c = 0; n == 0 && c < kNumPriorities; c++) {
+                priority = static_cast<Priority>(c);
+                n = takeBatch(me, priority, batch.data(), false);
+                for (size_t k = 0; n == 0 && k < me.victims.size(); k++) {
+                    n = takeBatch(*workers_[me.victims[k]], priority, batch.data(), true);
+                    if (n > 0) steals_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            // Lost a race for the last ready stream: sleep until more arrive
+            if (n == 0) continue;
+
+            batches_.fetch_add(1, std::memory_order_relaxed);
+            batchedStreams_.fetch_add(n, std::memory_order_relaxed);
+            me.streamRuns.fetch_add(n, std::memory_order_relaxed);
+            for (int i = 0; i < n; i++) {
+                // Offline batches yield between streams; the rest go back in line
+                if (priority == Priority::Offline && i > 0 && realTimePending()) {
+                    classes_[static_cast<int>(Priority::Offline)].preemptions.fetch_add(1, std::memory_order_relaxed);
+                    for (int j = i; j < n; j++) enqueue(batch[j]);
+                    break;
+                }
+                if (batch[i]->node != me.node) me.remoteRuns.fetch_add(1, std::memory_order_relaxed);
+                runStream(batch[i]);
+            }
+        }
+    }
+
+    /// Process up to maxBlocksPerVisit blocks of a stream in order. Offline
+    /// streams stop early at a block boundary when real-time work is ready.
+    void runStream(Stream* s) {
+        ClassCounters& counters = classes_[static_cast<int>(s->priority)];
+        for (int visit = 0; visit < config_.maxBlocksPerVisit; visit++) {
+            if (visit > 0 && s->priority == Priority::Offline && realTimePending()) {
+                counters.preemptions.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            Block block;
+            {
+                std::lock_guard<std::mutex> lock(s->mutex);
+                if (s->blocks.empty()) break;
+                block = std::move(s->blocks.front());
+                s->blocks.pop_front();
+            }
+
+            const int n = static_cast<int>(block.samples.size());
+            s->analyser.process(block.samples.data(), n);
+            const Clock::time_point done = Clock::now();
+            const bool missed = done > block.deadline;
+            recordLatency(counters, done - block.submitted, missed);
+
+            {
+                std::lock_guard<std::mutex> lock(s->mutex);
+                if (missed) s->deadlineMisses++;
+                s->queuedSamples -= n;
+                s->processedSamples += n;
+                s->processedBlocks++;
+                s->spare.push_back(std::move(block.samples));
+            }
+            processedBlocks_.fetch_add(1, std::memory_order_relaxed);
+            finishBlock();
+        }
+
+        // Requeue while blocks remain, otherwise release the stream. The
+        // check and the release happen under the queue lock so a concurrent
+        // submit() either sees the release or its block is seen here.
+        {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            if (s->blocks.empty()) {
+                s->scheduled.store(false, std::memory_order_release);
+                if (s->closed) s->released.notify_all();
+                return;
+            }
+        }
+        enqueue(s);
+    }
+
+    static void recordLatency(ClassCounters& c, Clock::duration latency, bool missed) {
+        const int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        int bin = 0;
+        for (int64_t v = us >> 1; v > 0 && bin < kLatencyBins - 1; v >>= 1) bin++;
+        c.latencyHistogram[bin].fetch_add(1, std::memory_order_relaxed);
+        c.processedBlocks.fetch_add(1, std::memory_order_relaxed);
+        if (missed) c.deadlineMisses.fetch_add(1, std::memory_order_relaxed);
+        int64_t peak = c.maxLatencyUs.load(std::memory_order_relaxed);
+        while (us > peak && !c.maxLatencyUs.compare_exchange_weak(peak, us, std::memory_order_relaxed)) {}
+    }
+
+    void finishBlock() {
+        if (outstandingBlocks_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(drainMutex_);
+            drainCv_.notify_all();
+        }
+    }
+
+    Config config_;
+    CpuTopology topology_;
+    std::vector<Analyser::Config> designs_;
+    std::vector<DesignTiles> designTiles_;
+    int numTiles_ = 0;
+    int nextTileWorker_ = 0;
+    std::vector<std::unique_ptr<Stream>> streams_;     // Indexed by StreamId
+    std::vector<std::unique_ptr<Worker>> workers_;
+    int nextStream_ = 0;
+    int64_t misplacedStreams_ = 0;
+    mutable std::mutex controlMutex_;                   // Designs, tiles, stream slots and misplacedStreams_
+
+    std::mutex sleepMutex_;
+    std::condition_variable sleepCv_;
+    int64_t readyStreams_ = 0;                          // Streams in worker queues (lags a push)
+    std::atomic<int64_t> readyRealTime_{0};             // ... of them real-time
+    bool stop_ = false;
+
+    std::atomic<int64_t> outstandingBlocks_{0};
+    std::mutex drainMutex_;
+    std::condition_variable drainCv_;
+
+    std::atomic<int64_t> processedBlocks_{0};
+    std::atomic<int64_t> rejectedBlocks_{0};
+    std::atomic<int64_t> batches_{0};
+    std::atomic<int64_t> batchedStreams_{0};
+    std::atomic<int64_t> steals_{0};
+    ClassCounters classes_[kNumPriorities];
+};
+
+} // namespace cortix
@@ -0,0 +1,370 @@
+/*
+ * Cortix - Framed Binary Protocol
+ *
+ * Compact message format used by the analysis daemon (cortixd) and its
+ * clients. Every message is an 8-byte header followed by a payload:
+ *
+ *   u32 payload length | u16 type | u16 flags (0)
+ *
+ * All fields are little-endian; samples and unencoded envelopes are float32.
+ * Payloads by type:
+ *
+ *   OpenStream    client: u32 tag, f32 sampleRate, u16 numBands,
+ *                 u16 hopSize, f32 minHz, f32 maxHz, u8 scale,
+ *                 u8 priority (0 real-time, 1 offline), u16 reserved
+ *   StreamOpened  server: u32 tag, u32 stream, u16 numBands, u16 hopSize
+ *   Audio         client: u32 stream, f32 samples[]
+ *   Subscribe     client: u32 stream
+ *   Subscribed    server: u32 stream, u16 numBands, u16 hopSize
+ *   Unsubscribe   client: u32 stream
+ *   CloseStream   client: u32 stream
+ *   StreamClosed  server: u32 stream
+ *   Frame         server: u32 stream, i64 index, i64 samplePosition,
+ *                 u16 numBands, u16 encoding, values: f32[numBands]
+ *                 for encoding 0, else a framecodec.h encoded frame
+ *   Error         server: u32 code, u32 tag or stream, utf-8 text
+ *   StreamInfo    u32 stream, f32 sampleRate, u16 numBands, u16 hopSize,
+ *                 f32 centerHz[numBands]; starts a recorded frame stream
+ *
+ * The same messages serve as a file/pipe format (see framewriter.h).
+ *
+ * MessageWriter appends messages to a byte buffer; MessageParser takes
+ * bytes in arbitrary pieces (as read from a socket) and yields whole
+ * messages. Neither does any I/O.
+ */
+
+#pragma once
+
+#include "scales.h"
+#include "framecodec.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace cortix {
+namespace protocol {
+
+constexpr int kHeaderBytes = 8;
+constexpr uint32_t kMaxPayloadBytes = 1u << 24;
+
+enum class MessageType : uint16_t {
+    OpenStream = 1,
+    StreamOpened = 2,
+    Audio = 3,
+    Subscribe = 4,
+    Unsubscribe = 5,
+    CloseStream = 6,
+    StreamClosed = 7,
+    Frame = 8,
+    Error = 9,
+    Subscribed = 10,
+    StreamInfo = 11
+};
+
+constexpr uint16_t kLastMessageType = static_cast<uint16_t>(MessageType::StreamInfo);
+
+enum class ErrorCode : uint32_t {
+    BadMessage = 1,
+    UnknownStream = 2,
+    TooManyStreams = 3,
+    Backpressure = 4,       // Audio block refused; the stream's queue is full
+    NotOwner = 5            // Only the opening connection may feed or close a stream
+};
+
+/// Value format of Frame messages (defined with the codec)
+using FrameEncoding = cortix::FrameEncoding;
+
+/// Analysis settings requested by OpenStream
+struct StreamSetup {
+    float sampleRate = 48000.0f;
+    int numBands = 40;
+    int hopSize = 128;
+    float minHz = 20.0f;
+    float maxHz = 20000.0f;
+    Scale scale = Scale::ERB;
+    bool realTime = false;
+};
+
+//=============================================================================
+// Encoding
+//=============================================================================
+
+class MessageWriter {
+public:
+    explicit MessageWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    /// Start a message; finish it with end()
+    void begin(MessageType type) {
+        start_ = out_.size();
+        u32(0);
+        u16(static_cast<uint16_t>(type));
+        u16(0);
+    }
+
+    void end() {
+        const uint32_t length = static_cast<uint32_t>(out_.size() - start_ - kHeaderBytes);
+        for (int i = 0; i < 4; i++) out_[start_ + i] = static_cast<uint8_t>(length >> (8 * i));
+    }
+
+    void u8(uint8_t v) { out_.push_back(v); }
+    void u16(uint16_t v) { for (int i = 0; i < 2; i++) out_.push_back(static_cast<uint8_t>(v >> (8 * i))); }
+    void u32(uint32_t v) { for (int i = 0; i < 4; i++) out_.push_back(static_cast<uint8_t>(v >> (8 * i))); }
+    void i64(int64_t v) {
+        const uint64_t u = static_cast<uint64_t>(v);
+        for (int i = 0; i < 8; i++) out_.push_back(static_cast<uint8_t>(u >> (8 * i)));
+    }
+    void f32(float v) {
+        uint32_t bits;
+        std::memcpy(&bits, &v, 4);
+        u32(bits);
+    }
+    void floats(const float* v, int n) {
+        const size_t at = out_.size();
+        out_.resize(at + static_cast<size_t>(n) * 4);
+        uint8_t* dst = out_.data() + at;
+        for (int i = 0; i < n; i++) {
+            uint32_t bits;
+            std::memcpy(&bits, v + i, 4);
+            dst[4 * i] = static_cast<uint8_t>(bits);
+            dst[4 * i + 1] = static_cast<uint8_t>(bits >> 8);
+            dst[4 * i + 2] = static_cast<uint8_t>(bits >> 16);
+            dst[4 * i + 3] = static_cast<uint8_t>(bits >> 24);
+        }
+    }
+    void text(const std::string& s) { out_.insert(out_.end(), s.begin(), s.end()); }
+
+    //-------------------------------------------------------------------------
+    // Whole messages
+
+    void openStream(uint32_t tag, const StreamSetup& setup) {
+        begin(MessageType::OpenStream);
+        u32(tag);
+        f32(setup.sampleRate);
+        u16(static_cast<uint16_t>(setup.numBands));
+        u16(static_cast<uint16_t>(setup.hopSize));
+        f32(setup.minHz);
+        f32(setup.maxHz);
+        u8(static_cast<uint8_t>(setup.scale));
+        u8(setup.realTime ? 0 : 1);
+        u16(0);
+        end();
+    }
+
+    void streamOpened(uint32_t tag, uint32_t stream, int numBands, int hopSize) {
+        begin(MessageType::StreamOpened);
+        u32(tag);
+        u32(stream);
+        u16(static_cast<uint16_t>(numBands));
+        u16(static_cast<uint16_t>(hopSize));
+        end();
+    }
+
+    void subscribed(uint32_t stream, int numBands, int hopSize) {
+        begin(MessageType::Subscribed);
+        u32(stream);
+        u16(static_cast<uint16_t>(numBands));
+        u16(static_cast<uint16_t>(hopSize));
+        end();
+    }
+
+    void streamInfo(uint32_t stream, float sampleRate, int hopSize, const float* centerHz, int numBands) {
+        begin(MessageType::StreamInfo);
+        u32(stream);
+        f32(sampleRate);
+        u16(static_cast<uint16_t>(numBands));
+        u16(static_cast<uint16_t>(hopSize));
+        floats(centerHz, numBands);
+        end();
+    }
+
+    void audio(uint32_t stream, const float* samples, int numSamples) {
+        begin(MessageType::Audio);
+        u32(stream);
+        floats(samples, numSamples);
+        end();
+    }
+
+    /// Subscribe, Unsubscribe, CloseStream and StreamClosed
+    void streamCommand(MessageType type, uint32_t stream) {
+        begin(type);
+        u32(stream);
+        end();
+    }
+
+    void frame(uint32_t stream, int64_t index, int64_t samplePosition,
+               const float* envelope, int numBands) {
+        begin(MessageType::Frame);
+        u32(stream);
+        i64(index);
+        i64(samplePosition);
+        u16(static_cast<uint16_t>(numBands));
+        u16(static_cast<uint16_t>(FrameEncoding::Float32));
+        floats(envelope, numBands);
+        end();
+    }
+
+    /// Frame with the envelope quantised by encoder (see framecodec.h)
+    void frame(uint32_t stream, int64_t index, int64_t samplePosition,
+               const float* envelope, FrameEncoder& encoder) {
+        begin(MessageType::Frame);
+        u32(stream);
+        i64(index);
+        i64(samplePosition);
+        u16(static_cast<uint16_t>(encoder.numBands()));
+        u16(encoder.encoding());
+        encoder.encode(envelope, out_);
+        end();
+    }
+
+    void error(ErrorCode code, uint32_t subject, const std::string& message) {
+        begin(MessageType::Error);
+        u32(static_cast<uint32_t>(code));
+        u32(subject);
+        text(message);
+        end();
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+    size_t start_ = 0;
+};
+
+//=============================================================================
+// Decoding
+//=============================================================================
+
+struct Message {
+    MessageType type = MessageType::Error;
+    const uint8_t* payload = nullptr;
+    uint32_t length = 0;
+};
+
+/// Bounds-checked little-endian reads from one payload. After any read
+/// past the end, ok() is false and reads return zero.
+class PayloadReader {
+public:
+    PayloadReader(const uint8_t* data, uint32_t length) : data_(data), length_(length) {}
+    explicit PayloadReader(const Message& m) : PayloadReader(m.payload, m.length) {}
+
+    uint8_t u8() { return static_cast<uint8_t>(take(1)); }
+    uint16_t u16() { return static_cast<uint16_t>(take(2)); }
+    uint32_t u32() { return static_cast<uint32_t>(take(4)); }
+    int64_t i64() { return static_cast<int64_t>(take(8)); }
+    float f32() {
+        const uint32_t bits = u32();
+        float v;
+        std::memcpy(&v, &bits, 4);
+        return v;
+    }
+
+    /// Read n floats; false (and nothing read) if fewer remain
+    bool floats(float* out, int n) {
+        if (n < 0 || remaining() < static_cast<uint32_t>(n) * 4) {
+            ok_ = false;
+            return false;
+        }
+        const uint8_t* src = data_ + pos_;
+        for (int i = 0; i < n; i++) {
+            const uint32_t bits = static_cast<uint32_t>(src[4 * i]) | static_cast<uint32_t>(src[4 * i + 1]) << 8 |
+                                  static_cast<uint32_t>(src[4 * i + 2]) << 16 | static_cast<uint32_t>(src[4 * i + 3]) << 24;
+            std::memcpy(out + i, &bits, 4);
+        }
+        pos_ += static_cast<uint32_t>(n) * 4;
+        return true;
+    }
+
+    std::string text() {
+        std::string s(reinterpret_cast<const char*>(data_ + pos_), remaining());
+        pos_ = length_;
+        return s;
+    }
+
+    /// The unread rest of the payload, e.g. an encoded frame
+    const uint8_t* position() const { return data_ + pos_; }
+    uint32_t remaining() const { return length_ - pos_; }
+    bool ok() const { return ok_; }
+
+    bool readSetup(StreamSetup& setup) {
+        setup.sampleRate = f32();
+        setup.numBands = u16();
+        setup.hopSize = u16();
+        setup.minHz = f32();
+        setup.maxHz = f32();
+        const uint8_t scale = u8();
+        setup.realTime = u8() == 0;
+        u16();
+        setup.scale = static_cast<Scale>(std::min<uint8_t>(scale, static_cast<uint8_t>(Scale::Mel)));
+        return ok_ && setup.sampleRate > 0.0f && setup.numBands > 0 && setup.hopSize > 0 &&
+               setup.minHz > 0.0f && setup.maxHz > setup.minHz;
+    }
+
+private:
+    uint64_t take(int bytes) {
+        if (remaining() < static_cast<uint32_t>(bytes)) {
+            ok_ = false;
+            pos_ = length_;
+            return 0;
+        }
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++) v |= static_cast<uint64_t>(data_[pos_ + i]) << (8 * i);
+        pos_ += bytes;
+        return v;
+    }
+
+    const uint8_t* data_;
+    uint32_t length_;
+    uint32_t pos_ = 0;
+    bool ok_ = true;
+};
+
+/// Reassembles messages from a byte stream
+class MessageParser {
+public:
+    /// Append received bytes
+    void append(const uint8_t* data, size_t n) {
+        // Drop consumed bytes before growing
+        if (pos_ > 0 && pos_ == buffer_.size()) {
+            buffer_.clear();
+            pos_ = 0;
+        } else if (pos_ > 65536 && pos_ * 2 > buffer_.size()) {
+            buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(pos_));
+            pos_ = 0;
+        }
+        buffer_.insert(buffer_.end(), data, data + n);
+    }
+
+    /// Next whole message, valid until the next append(). Returns false if
+    /// more bytes are needed or the stream is corrupt (see failed()).
+    bool next(Message& message) {
+        if (failed_ || buffer_.size() - pos_ < static_cast<size_t>(kHeaderBytes)) return false;
+        PayloadReader header(buffer_.data() + pos_, kHeaderBytes);
+        const uint32_t length = header.u32();
+        const uint16_t type = header.u16();
+        if (length > kMaxPayloadBytes || type < 1 || type > kLastMessageType) {
+            failed_ = true;
+            return false;
+        }
+        if (buffer_.size() - pos_ < kHeaderBytes + static_cast<size_t>(length)) return false;
+        message.type = static_cast<MessageType>(type);
+        message.payload = buffer_.data() + pos_ + kHeaderBytes;
+        message.length = length;
+        pos_ += kHeaderBytes + length;
+        return true;
+    }
+
+    /// Framing error: oversized payload or unknown type
+    bool failed() const { return failed_; }
+
+    /// Bytes received but not yet returned as messages
+    size_t pending() const { return buffer_.size() - pos_; }
+
+private:
+    std::vector<uint8_t> buffer_;
+    size_t pos_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace protocol
+} // namespace cortix
@@ -96,16 +96,15 @@ struct BandInfo {
     float highHz;       // Upper edge frequency
 };
 
-/// Generate frequency bands spaced according to the given scale
-inline std::vector<BandInfo> generateBands(
+/// Write numBands bands spaced according to the given scale into `bands`.
+/// Does not allocate, so it can run on the audio thread.
+inline void generateBands(
     Scale scale,
     int numBands,
-    float minHz = 20.0f,
-    float maxHz = 20000.0f
+    float minHz,
+    float maxHz,
+    BandInfo* bands
 ) {
-    std::vector<BandInfo> bands;
-    bands.reserve(numBands);
-
     switch (scale) {
         case Scale::Linear: {
             float step = (maxHz - minHz) / numBands;
@@ -115,7 +114,7 @@ inline std::vector<BandInfo> generateBands(
                 b.highHz = b.lowHz + step;
                 b.centerHz = (b.lowHz + b.highHz) / 2.0f;
                 b.bandwidthHz = step;
-                bands.push_back(b);
+                bands[i] = b;
             }
             break;
         }
@@ -130,7 +129,7 @@ inline std::vector<BandInfo> generateBands(
                 b.highHz = std::pow(2.0f, logMin + (i + 1) * step);
                 b.centerHz = std::sqrt(b.lowHz * b.highHz); // Geometric mean
                 b.bandwidthHz = b.highHz - b.lowHz;
-                bands.push_back(b);
+                bands[i] = b;
             }
             break;
         }
@@ -147,7 +146,7 @@ inline std::vector<BandInfo> generateBands(
                 b.highHz = barkToHz(barkHigh);
                 b.centerHz = barkToHz((barkLow + barkHigh) / 2.0f);
                 b.bandwidthHz = b.highHz - b.lowHz;
-                bands.push_back(b);
+                bands[i] = b;
             }
             break;
         }
@@ -164,7 +163,7 @@ inline std::vector<BandInfo> generateBands(
                 b.highHz = erbToHz(erbHigh);
                 b.centerHz = erbToHz((erbLow + erbHigh) / 2.0f);
                 b.bandwidthHz = b.highHz - b.lowHz;
-                bands.push_back(b);
+                bands[i] = b;
             }
             break;
         }
@@ -181,12 +180,22 @@ inline std::vector<BandInfo> generateBands(
                 b.highHz = melToHz(melHigh);
                 b.centerHz = melToHz((melLow + melHigh) / 2.0f);
                 b.bandwidthHz = b.highHz - b.lowHz;
-                bands.push_back(b);
+                bands[i] = b;
             }
             break;
         }
     }
+}
 
+/// Generate frequency bands spaced according to the given scale
+inline std::vector<BandInfo> generateBands(
+    Scale scale,
+    int numBands,
+    float minHz = 20.0f,
+    float maxHz = 20000.0f
+) {
+    std::vector<BandInfo> bands(std::max(numBands, 0));
+    generateBands(scale, numBands, minHz, maxHz, bands.data());
     return bands;
 }
 
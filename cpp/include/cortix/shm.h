@@ -0,0 +1,467 @@
+/*
+ * Cortix - Shared-Memory Frame Ring
+ *
+ * ShmFramePublisher writes hop frames into a ring in a POSIX shared
+ * memory object (shm_open); any number of local processes attach with
+ * ShmFrameReader and read frames in place, without copies or syscalls.
+ *
+ * Layout (all offsets 64-byte aligned):
+ *
+ *   Header     magic, version, numBands, hopSize, sampleRate, capacity,
+ *              slot stride, frame encoding, band table generation,
+ *              write sequence
+ *   Band table numBands x BandInfo
+ *   Slots      capacity x { u64 stamp, i64 index, i64 samplePosition,
+ *                           u32 bytes, u32 reserved, payload }
+ *
+ * The payload is the float32 envelope, or with a quantised encoding
+ * (framecodec.h) an encoded frame of at most payloadBytes, which makes
+ * slots several times smaller. Delta-coded rings depend on the previous
+ * frame: a reader that joins late or is lapped skips frames until the
+ * next keyframe.
+ *
+ * Frame n (counting from 0) goes to slot n % capacity. Each slot is a
+ * seqlock: its stamp is 2n+1 while frame n is being written and 2n+2
+ * once complete. The single writer never waits for readers. A reader
+ * that falls more than capacity frames behind skips ahead to the oldest
+ * frame still in the ring and counts the loss as an overrun; a view it
+ * holds can be re-checked with valid() before its contents are trusted.
+ *
+ * POSIX only; not included by cortix.h.
+ */
+
+#pragma once
+
+#include "analyser.h"
+#include "scales.h"
+#include "framecodec.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <new>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace cortix {
+
+namespace shm {
+
+constexpr uint32_t kMagic = 0x53585443;     // "CTXS"
+constexpr uint32_t kVersion = 2;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory ring needs lock-free 64-bit atomics");
+
+inline size_t align64(size_t n) { return (n + 63) & ~size_t(63); }
+
+struct Header {
+    std::atomic<uint32_t> magic;            // Written last by the publisher
+    uint32_t version;
+    uint32_t numBands;
+    uint32_t hopSize;
+    float sampleRate;
+    uint32_t capacity;                      // Slots
+    uint32_t slotBytes;                     // Slot stride
+    uint32_t encoding;                      // FrameEncoding id of the payloads
+    uint32_t payloadBytes;                  // Largest payload
+    uint32_t bandTableOffset;
+    uint32_t slotsOffset;
+    std::atomic<uint32_t> closed;           // Publisher has gone away
+    std::atomic<uint32_t> bandGeneration;   // Odd while the band table is rewritten
+    alignas(64) std::atomic<uint64_t> writeSequence;    // Frames published
+};
+
+struct Slot {
+    std::atomic<uint64_t> stamp;            // 2n+1 writing frame n, 2n+2 done
+    int64_t index;
+    int64_t samplePosition;
+    uint32_t bytes;                         // Payload size
+    uint32_t reserved;
+    // Payload follows: float envelope[numBands] or an encoded frame
+};
+
+inline size_t regionBytes(int numBands, int capacity, size_t payloadBytes) {
+    return align64(sizeof(Header)) + align64(sizeof(BandInfo) * numBands) +
+           static_cast<size_t>(capacity) * align64(sizeof(Slot) + payloadBytes);
+}
+
+} // namespace shm
+
+/// A frame in the ring, read in place
+struct ShmFrameView {
+    uint64_t sequence = 0;          // Frames published before this one
+    int64_t index = 0;              // Analyser hop index
+    int64_t samplePosition = 0;
+    const float* envelope = nullptr;  // Float32 rings; null when encoded (see read())
+    int numBands = 0;
+    uint16_t encoding = 0;          // FrameEncoding id of the payload
+    const uint8_t* data = nullptr;  // Payload in place
+    uint32_t bytes = 0;
+};
+
+//=============================================================================
+// Publisher (single writer)
+//=============================================================================
+
+class ShmFramePublisher {
+public:
+    ShmFramePublisher() = default;
+    ~ShmFramePublisher() { close(); }
+
+    ShmFramePublisher(const ShmFramePublisher&) = delete;
+    ShmFramePublisher& operator=(const ShmFramePublisher&) = delete;
+
+    /// Create (or replace) the shared-memory object `name` ("/something").
+    /// Returns false on failure, with errno set.
+    bool open(const std::string& name, int numBands, int hopSize, float sampleRate,
+              const BandInfo* bands, int capacity = 1024) {
+        encoded_ = false;
+        return create(name, numBands, hopSize, sampleRate, bands, capacity,
+                      static_cast<uint32_t>(FrameEncoding::Float32), sizeof(float) * std::max(0, numBands));
+    }
+
+    /// Same, publishing frames quantised with `encoding` (see framecodec.h)
+    bool open(const std::string& name, int numBands, int hopSize, float sampleRate,
+              const BandInfo* bands, int capacity, const FrameEncoder::Config& encoding) {
+        encoder_.configure(numBands, encoding);
+        encoded_ = true;
+        return create(name, numBands, hopSize, sampleRate, bands, capacity, encoder_.encoding(),
+                      encoder_.maxEncodedBytes());
+    }
+
+    /// Same, taking the layout and band table from an analyser
+    bool open(const std::string& name, const Analyser& analyser, int capacity = 1024) {
+        return open(name, analyser.numBands(), analyser.hopSize(), analyser.sampleRate(),
+                    analyser.bands().data(), capacity);
+    }
+
+    bool open(const std::string& name, const Analyser& analyser, int capacity,
+              const FrameEncoder::Config& encoding) {
+        return open(name, analyser.numBands(), analyser.hopSize(), analyser.sampleRate(),
+                    analyser.bands().data(), capacity, encoding);
+    }
+
+    /// Mark the ring closed for readers, unmap and remove the name
+    void close() {
+        if (!region_) return;
+        header_->closed.store(1, std::memory_order_release);
+        ::munmap(region_, bytes_);
+        ::shm_unlink(name_.c_str());
+        region_ = nullptr;
+        header_ = nullptr;
+    }
+
+    bool isOpen() const { return region_ != nullptr; }
+
+    /// Write one frame (wait-free)
+    void publish(int64_t index, int64_t samplePosition, const float* envelope) {
+        const uint64_t n = sequence_;
+        shm::Slot* s = slot(static_cast<int>(n % header_->capacity));
+        s->stamp.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        s->index = index;
+        s->samplePosition = samplePosition;
+        if (encoded_) {
+            s->bytes = static_cast<uint32_t>(encoder_.encode(envelope, slotPayload(s)));
+        } else {
+            std::memcpy(slotPayload(s), envelope, sizeof(float) * header_->numBands);
+            s->bytes = header_->payloadBytes;
+        }
+        s->stamp.store(2 * n + 2, std::memory_order_release);
+        sequence_ = n + 1;
+        header_->writeSequence.store(n + 1, std::memory_order_release);
+    }
+
+    void publish(const Analyser::Frame& frame) {
+        publish(frame.index, frame.samplePosition, frame.envelope);
+    }
+
+    /// Replace the band table, e.g. after Analyser::zoom()
+    void setBands(const BandInfo* bands) {
+        const uint32_t g = header_->bandGeneration.load(std::memory_order_relaxed);
+        header_->bandGeneration.store(g + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(region_ + header_->bandTableOffset, bands, sizeof(BandInfo) * header_->numBands);
+        header_->bandGeneration.store(g + 2, std::memory_order_release);
+    }
+
+    uint64_t published() const { return sequence_; }
+    size_t regionBytes() const { return bytes_; }
+    const std::string& name() const { return name_; }
+    uint16_t encoding() const { return encoded_ ? encoder_.encoding() : 0; }
+
+private:
+    bool create(const std::string& name, int numBands, int hopSize, float sampleRate,
+                const BandInfo* bands, int capacity, uint32_t encoding, size_t payloadBytes) {
+        close();
+        if (numBands <= 0 || capacity <= 0) {
+            errno = EINVAL;
+            return false;
+        }
+        bytes_ = shm::regionBytes(numBands, capacity, payloadBytes);
+
+        // A fresh object, so readers of a previous publisher keep their old mapping
+        ::shm_unlink(name.c_str());
+        const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0) return false;
+        if (::ftruncate(fd, static_cast<off_t>(bytes_)) < 0) {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            return false;
+        }
+        void* region = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (region == MAP_FAILED) {
+            ::shm_unlink(name.c_str());
+            return false;
+        }
+        region_ = static_cast<uint8_t*>(region);
+        name_ = name;
+
+        // ftruncate zero-fills: every slot stamp starts at 0 (empty)
+        header_ = new (region_) shm::Header;
+        header_->version = shm::kVersion;
+        header_->numBands = static_cast<uint32_t>(numBands);
+        header_->hopSize = static_cast<uint32_t>(hopSize);
+        header_->sampleRate = sampleRate;
+        header_->capacity = static_cast<uint32_t>(capacity);
+        header_->slotBytes = static_cast<uint32_t>(shm::align64(sizeof(shm::Slot) + payloadBytes));
+        header_->encoding = encoding;
+        header_->payloadBytes = static_cast<uint32_t>(payloadBytes);
+        header_->bandTableOffset = static_cast<uint32_t>(shm::align64(sizeof(shm::Header)));
+        header_->slotsOffset = static_cast<uint32_t>(header_->bandTableOffset + shm::align64(sizeof(BandInfo) * numBands));
+        header_->closed.store(0, std::memory_order_relaxed);
+        header_->bandGeneration.store(0, std::memory_order_relaxed);
+        header_->writeSequence.store(0, std::memory_order_relaxed);
+        for (int s = 0; s < capacity; s++) {
+            new (slot(s)) shm::Slot{};
+        }
+        if (bands) {
+            std::memcpy(region_ + header_->bandTableOffset, bands, sizeof(BandInfo) * numBands);
+        }
+        sequence_ = 0;
+        header_->magic.store(shm::kMagic, std::memory_order_release);
+        return true;
+    }
+
+    shm::Slot* slot(int s) const {
+        return reinterpret_cast<shm::Slot*>(region_ + header_->slotsOffset + static_cast<size_t>(s) * header_->slotBytes);
+    }
+    static uint8_t* slotPayload(shm::Slot* s) {
+        return reinterpret_cast<uint8_t*>(s) + sizeof(shm::Slot);
+    }
+
+    uint8_t* region_ = nullptr;
+    shm::Header* header_ = nullptr;
+    size_t bytes_ = 0;
+    std::string name_;
+    uint64_t sequence_ = 0;
+    FrameEncoder encoder_;
+    bool encoded_ = false;
+};
+
+//=============================================================================
+// Reader (any number, any process)
+//=============================================================================
+
+class ShmFrameReader {
+public:
+    ShmFrameReader() = default;
+    ~ShmFrameReader() { close(); }
+
+    ShmFrameReader(const ShmFrameReader&) = delete;
+    ShmFrameReader& operator=(const ShmFrameReader&) = delete;
+
+    /// Map an existing ring read-only. Starts at the oldest frame still in
+    /// the ring; call seekToLatest() to see only new frames.
+    bool open(const std::string& name) {
+        close();
+        const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) return false;
+        struct stat st;
+        if (::fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(shm::Header)) {
+            ::close(fd);
+            return false;
+        }
+        bytes_ = static_cast<size_t>(st.st_size);
+        void* region = ::mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (region == MAP_FAILED) return false;
+        region_ = static_cast<const uint8_t*>(region);
+        header_ = reinterpret_cast<const shm::Header*>(region_);
+
+        if (header_->magic.load(std::memory_order_acquire) != shm::kMagic || header_->version != shm::kVersion ||
+            bytes_ < shm::regionBytes(static_cast<int>(header_->numBands), static_cast<int>(header_->capacity),
+                                      header_->payloadBytes) ||
+            (header_->encoding != static_cast<uint32_t>(FrameEncoding::Float32) &&
+             !decoder_.configure(static_cast<int>(header_->numBands), static_cast<uint16_t>(header_->encoding)))) {
+            close();
+            return false;
+        }
+        payload_.resize(header_->payloadBytes);
+        decodeNext_ = 0;
+        seekToOldest();
+        overruns_ = 0;
+        lostFrames_ = 0;
+        return true;
+    }
+
+    void close() {
+        if (region_) ::munmap(const_cast<uint8_t*>(region_), bytes_);
+        region_ = nullptr;
+        header_ = nullptr;
+    }
+
+    bool isOpen() const { return region_ != nullptr; }
+
+    int numBands() const { return static_cast<int>(header_->numBands); }
+    int hopSize() const { return static_cast<int>(header_->hopSize); }
+    float sampleRate() const { return header_->sampleRate; }
+    int capacity() const { return static_cast<int>(header_->capacity); }
+
+    /// FrameEncoding id of the ring's frames (0: float32 envelopes)
+    uint16_t encoding() const { return static_cast<uint16_t>(header_->encoding); }
+
+    /// Copy the band table (consistent even while the publisher rewrites it)
+    void bands(std::vector<BandInfo>& out) const {
+        out.resize(header_->numBands);
+        const BandInfo* table = reinterpret_cast<const BandInfo*>(region_ + header_->bandTableOffset);
+        for (;;) {
+            const uint32_t g = header_->bandGeneration.load(std::memory_order_acquire);
+            if (g & 1) continue;
+            std::memcpy(out.data(), table, sizeof(BandInfo) * out.size());
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header_->bandGeneration.load(std::memory_order_relaxed) == g) return;
+        }
+    }
+
+    /// Band table generation; changes when the publisher calls setBands()
+    uint32_t bandGeneration() const { return header_->bandGeneration.load(std::memory_order_acquire); }
+
+    /// Frames published so far
+    uint64_t published() const { return header_->writeSequence.load(std::memory_order_acquire); }
+
+    /// Frames waiting for this reader (before any overrun)
+    uint64_t available() const { return published() - next_; }
+
+    /// Whether the publisher has closed the ring
+    bool publisherClosed() const { return header_->closed.load(std::memory_order_acquire) != 0; }
+
+    void seekToLatest() { next_ = published(); }
+
+    void seekToOldest() {
+        const uint64_t w = published();
+        next_ = w > header_->capacity ? w - header_->capacity : 0;
+    }
+
+    /// Next frame, in place. Returns false if no new frame is ready. If the
+    /// reader fell behind, it skips to the oldest frame still in the ring
+    /// and counts the skipped frames.
+    bool next(ShmFrameView& view) {
+        for (;;) {
+            const uint64_t w = published();
+            if (next_ >= w) return false;
+            if (w - next_ > header_->capacity) {
+                skipTo(w - header_->capacity);
+                continue;
+            }
+
+            const shm::Slot* s = slot(next_);
+            const uint64_t stamp = s->stamp.load(std::memory_order_acquire);
+            if (stamp != 2 * next_ + 2) {
+                // Overwritten by a newer frame (or being overwritten): lapped
+                if (stamp > 2 * next_ + 2) {
+                    skipTo(next_ + 1);
+                    continue;
+                }
+                return false;
+            }
+            view.sequence = next_;
+            view.index = s->index;
+            view.samplePosition = s->samplePosition;
+            view.numBands = numBands();
+            view.encoding = encoding();
+            view.data = slotPayload(s);
+            view.bytes = std::min(s->bytes, header_->payloadBytes);
+            view.envelope = view.encoding == 0 ? reinterpret_cast<const float*>(view.data) : nullptr;
+            if (!valid(view)) {
+                skipTo(next_ + 1);
+                continue;
+            }
+            next_++;
+            return true;
+        }
+    }
+
+    /// True while the slot behind a view still holds that frame. Check after
+    /// reading a view's envelope to make sure it was not overwritten meanwhile.
+    bool valid(const ShmFrameView& view) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot(view.sequence)->stamp.load(std::memory_order_relaxed) == 2 * view.sequence + 2;
+    }
+
+    /// Next frame copied out (envelope needs numBands() floats); the copy is
+    /// validated, so it never mixes two frames. Encoded frames are decoded;
+    /// after a gap, delta frames are skipped until the next keyframe.
+    bool read(ShmFrameView& view, float* envelope) {
+        while (next(view)) {
+            if (view.encoding == 0) {
+                std::memcpy(envelope, view.envelope, sizeof(float) * view.numBands);
+            } else {
+                std::memcpy(payload_.data(), view.data, view.bytes);
+            }
+            if (!valid(view)) {
+                overruns_++;
+                lostFrames_++;
+                continue;
+            }
+            if (view.encoding != 0) {
+                if (view.sequence != decodeNext_) decoder_.reset();
+                decodeNext_ = view.sequence + 1;
+                if (!decoder_.decode(payload_.data(), view.bytes, envelope)) continue;
+            }
+            view.envelope = envelope;
+            return true;
+        }
+        return false;
+    }
+
+    /// Delta frames skipped by read() while waiting for a keyframe
+    int64_t skippedFrames() const { return decoder_.skippedFrames(); }
+
+    /// Times this reader was lapped, and frames it missed as a result
+    int64_t overruns() const { return overruns_; }
+    int64_t lostFrames() const { return lostFrames_; }
+
+private:
+    void skipTo(uint64_t sequence) {
+        overruns_++;
+        lostFrames_ += static_cast<int64_t>(sequence - next_);
+        next_ = sequence;
+    }
+
+    const shm::Slot* slot(uint64_t sequence) const {
+        return reinterpret_cast<const shm::Slot*>(region_ + header_->slotsOffset +
+            static_cast<size_t>(sequence % header_->capacity) * header_->slotBytes);
+    }
+    static const uint8_t* slotPayload(const shm::Slot* s) {
+        return reinterpret_cast<const uint8_t*>(s) + sizeof(shm::Slot);
+    }
+
+    const uint8_t* region_ = nullptr;
+    const shm::Header* header_ = nullptr;
+    size_t bytes_ = 0;
+    uint64_t next_ = 0;             // Sequence of the next frame to read
+    int64_t overruns_ = 0;
+    int64_t lostFrames_ = 0;
+    FrameDecoder decoder_;          // Encoded rings
+    std::vector<uint8_t> payload_;  // Validated copy of an encoded frame
+    uint64_t decodeNext_ = 0;       // Sequence that continues the decoder's reference frame
+};
+
+} // namespace cortix
@@ -0,0 +1,185 @@
+/*
+ * Cortix - Long-Term Band Statistics
+ *
+ * Accumulates per-band level statistics over arbitrarily long programs
+ * in constant memory:
+ * - long-term average spectrum (mean power per band)
+ * - running mean and variance of the level in dB (Welford 1962)
+ * - a fixed-bin dB histogram per band for quantiles (median, P10, P95...)
+ *
+ * Accumulators are mergeable (Chan et al. 1979 for the moments, bin-wise
+ * addition for the histograms), so chunks of a long file can be analysed
+ * in parallel and combined afterwards with the same result as a single
+ * pass. Moments are kept in double precision: at 375 hops per second an
+ * hour of audio is over a million frames.
+ */
+
+#pragma once
+
+#include "fastmath.h"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+namespace cortix {
+
+class BandStatistics {
+public:
+    struct Config {
+        int numBands = 40;
+        float minDb = -120.0f;      // Histogram range; levels outside are clamped
+        float maxDb = 20.0f;
+        float binDb = 0.5f;         // Histogram resolution
+        float floor = 1e-12f;       // Added to band power before the log
+    };
+
+    BandStatistics() = default;
+
+    explicit BandStatistics(const Config& config) {
+        configure(config);
+    }
+
+    void configure(const Config& config) {
+        config_ = config;
+        config_.binDb = std::max(config.binDb, 1e-3f);
+        numBins_ = std::max(1, static_cast<int>(std::ceil((config.maxDb - config.minDb) / config_.binDb)));
+
+        const size_t nb = config.numBands;
+        levelDb_.assign(nb, 0.0f);
+        bin_.assign(nb, 0);
+        powerMean_.assign(nb, 0.0);
+        mean_.assign(nb, 0.0);
+        m2_.assign(nb, 0.0);
+        histogram_.assign(nb * numBins_, 0);
+
+        reset();
+    }
+
+    void reset() {
+        std::fill(powerMean_.begin(), powerMean_.end(), 0.0);
+        std::fill(mean_.begin(), mean_.end(), 0.0);
+        std::fill(m2_.begin(), m2_.end(), 0.0);
+        std::fill(histogram_.begin(), histogram_.end(), 0);
+        count_ = 0;
+    }
+
+    /// Accumulate one envelope frame (numBands magnitudes)
+    void process(const float* envelope) {
+        const int nb = config_.numBands;
+        const float floor = config_.floor;
+        const float minDb = config_.minDb;
+        const float invBin = 1.0f / config_.binDb;
+        const float lastBin = static_cast<float>(numBins_ - 1);
+
+        count_++;
+        const double invCount = 1.0 / static_cast<double>(count_);
+
+        for (int b = 0; b < nb; b++) {
+            const float p = envelope[b] * envelope[b];
+            const float db = fastPowerToDb(p + floor);
+            levelDb_[b] = db;
+            // Clamp before the cast: a NaN or huge level would overflow int
+            const float pos = (db - minDb) * invBin;
+            bin_[b] = pos > 0.0f ? static_cast<int>(std::min(pos, lastBin)) : 0;
+
+            // Welford updates; every band shares the frame count
+            powerMean_[b] += (p - powerMean_[b]) * invCount;
+            const double delta = db - mean_[b];
+            mean_[b] += delta * invCount;
+            m2_[b] += delta * (db - mean_[b]);
+        }
+        for (int b = 0; b < nb; b++) {
+            histogram_[static_cast<size_t>(b) * numBins_ + bin_[b]]++;
+        }
+    }
+
+    /// Fold another accumulator into this one. Returns false, changing
+    /// nothing, unless both have the same bands and histogram bins.
+    bool merge(const BandStatistics& other) {
+        if (other.config_.numBands != config_.numBands || other.numBins_ != numBins_ ||
+            other.config_.minDb != config_.minDb || other.config_.binDb != config_.binDb) {
+            return false;
+        }
+        if (other.count_ == 0) return true;
+        if (count_ == 0) {
+            *this = other;
+            return true;
+        }
+
+        const double na = static_cast<double>(count_);
+        const double nb = static_cast<double>(other.count_);
+        const double n = na + nb;
+        for (int b = 0; b < config_.numBands; b++) {
+            const double delta = other.mean_[b] - mean_[b];
+            mean_[b] += delta * nb / n;
+            m2_[b] += other.m2_[b] + delta * delta * na * nb / n;
+            powerMean_[b] = (powerMean_[b] * na + other.powerMean_[b] * nb) / n;
+        }
+        for (size_t i = 0; i < histogram_.size(); i++) {
+            histogram_[i] += other.histogram_[i];
+        }
+        count_ += other.count_;
+        return true;
+    }
+
+    /// Frames accumulated so far
+    int64_t count() const { return count_; }
+
+    /// Long-term average spectrum: mean power of a band in dB
+    float ltasDb(int band) const {
+        return 10.0f * std::log10(static_cast<float>(powerMean_[band]) + config_.floor);
+    }
+
+    /// Mean level of a band in dB (mean of the per-frame dB values)
+    float meanDb(int band) const { return static_cast<float>(mean_[band]); }
+
+    /// Sample variance of the level of a band in dB^2
+    float varianceDb(int band) const {
+        return count_ > 1 ? static_cast<float>(m2_[band] / static_cast<double>(count_ - 1)) : 0.0f;
+    }
+
+    /// Standard deviation of the level of a band in dB
+    float stdDevDb(int band) const { return std::sqrt(varianceDb(band)); }
+
+    /// Level (dB) below which a fraction q of the frames of a band fell,
+    /// interpolated within the histogram bin
+    float quantileDb(int band, float q) const {
+        if (count_ == 0) return config_.minDb;
+        const uint64_t* h = histogram_.data() + static_cast<size_t>(band) * numBins_;
+        const double target = std::clamp(static_cast<double>(q), 0.0, 1.0) * static_cast<double>(count_);
+
+        double cum = 0.0;
+        for (int i = 0; i < numBins_; i++) {
+            const double next = cum + static_cast<double>(h[i]);
+            if (next >= target && h[i] > 0) {
+                const double frac = (target - cum) / static_cast<double>(h[i]);
+                return config_.minDb + (static_cast<float>(i) + static_cast<float>(frac)) * config_.binDb;
+            }
+            cum = next;
+        }
+        return config_.maxDb;
+    }
+
+    /// Histogram counts of a band (numBins entries from minDb upwards)
+    const uint64_t* histogram(int band) const {
+        return histogram_.data() + static_cast<size_t>(band) * numBins_;
+    }
+
+    int numBins() const { return numBins_; }
+    int numBands() const { return config_.numBands; }
+
+private:
+    Config config_;
+    int numBins_ = 1;
+
+    std::vector<float> levelDb_;
+    std::vector<int> bin_;
+    std::vector<double> powerMean_;
+    std::vector<double> mean_;
+    std::vector<double> m2_;
+    std::vector<uint64_t> histogram_;   // [band][bin]
+    int64_t count_ = 0;
+};
+
+} // namespace cortix
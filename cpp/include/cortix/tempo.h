@@ -0,0 +1,217 @@
+/*
+ * Cortix - Tempo Tracking
+ *
+ * Continuous tempo (BPM), confidence and beat phase from the band-summed
+ * onset novelty curve (half-wave rectified log spectral flux).
+ *
+ * The tempo comes from an autocorrelation of the novelty curve over a
+ * sliding rectangular window. Each hop adds the newest product and
+ * subtracts the one leaving the window, so the cost is O(lags) per hop
+ * whatever the window length. A log-Gaussian prior around a preferred
+ * tempo (Ellis 2007) reduces octave errors. Beat phase comes from a
+ * free-running oscillator at the detected period and a leaky circular
+ * mean of the novelty over the oscillator phase, which is O(1) per hop.
+ */
+
+#pragma once
+
+#include "fastmath.h"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+namespace cortix {
+
+struct TempoEstimate {
+    float bpm = 0.0f;
+    float confidence = 0.0f;   // Normalized autocorrelation at the beat period, 0..1
+    float beatPhase = 0.0f;    // 0 on the beat, rising to 1 just before the next
+};
+
+class TempoTracker {
+public:
+    struct Config {
+        int numBands = 40;
+        float hopRateHz = 375.0f;       // Frames per second
+        float minBpm = 60.0f;
+        float maxBpm = 200.0f;
+        float windowSeconds = 6.0f;     // Autocorrelation window
+        float preferredBpm = 120.0f;    // Centre of the tempo prior
+        float priorOctaves = 1.0f;      // Prior width (std dev in octaves)
+        float compression = 1000.0f;    // log(1 + c * envelope)
+        float phaseSmoothingSeconds = 4.0f;
+    };
+
+    TempoTracker() = default;
+
+    explicit TempoTracker(const Config& config) {
+        configure(config);
+    }
+
+    void configure(const Config& config) {
+        config_ = config;
+
+        const float rate = config.hopRateHz;
+        minLag_ = std::max(2, static_cast<int>(std::floor(60.0f * rate / config.maxBpm)));
+        maxLag_ = std::max(minLag_ + 2, static_cast<int>(std::ceil(60.0f * rate / config.minBpm)));
+        window_ = std::max(maxLag_ + 1, static_cast<int>(config.windowSeconds * rate));
+
+        // History must reach back window_ + maxLag_ frames
+        historyLength_ = window_ + maxLag_ + 1;
+        history_.assign(historyLength_, 0.0f);
+        acf_.assign(maxLag_ + 1, 0.0);
+
+        prior_.assign(maxLag_ + 1, 0.0f);
+        for (int k = 1; k <= maxLag_; k++) {
+            const float bpm = 60.0f * rate / k;
+            const float octaves = std::log2(bpm / config.preferredBpm) / config.priorOctaves;
+            prior_[k] = std::exp(-0.5f * octaves * octaves);
+        }
+
+        prevLog_.assign(config.numBands, 0.0f);
+        meanCoeff_ = std::exp(-1.0f / (0.5f * rate));
+        phaseLeak_ = std::exp(-1.0f / (config.phaseSmoothingSeconds * rate));
+
+        reset();
+    }
+
+    void reset() {
+        std::fill(history_.begin(), history_.end(), 0.0f);
+        std::fill(acf_.begin(), acf_.end(), 0.0);
+        std::fill(prevLog_.begin(), prevLog_.end(), 0.0f);
+        writePos_ = 0;
+        frames_ = 0;
+        mean_ = 0.0f;
+        novelty_ = 0.0f;
+        period_ = 0.0f;
+        oscPhase_ = 0.0f;
+        phaseRe_ = 0.0f;
+        phaseIm_ = 0.0f;
+        estimate_ = TempoEstimate{};
+    }
+
+    /// Process one envelope frame
+    const TempoEstimate& process(const float* envelope) {
+        // Band-summed, half-wave rectified log spectral flux
+        float flux = 0.0f;
+        for (int b = 0; b < config_.numBands; b++) {
+            const float l = fastLog(1.0f + config_.compression * envelope[b]);
+            flux += std::max(l - prevLog_[b], 0.0f);
+            prevLog_[b] = l;
+        }
+        flux /= static_cast<float>(std::max(config_.numBands, 1));
+        if (frames_ == 0) flux = 0.0f;  // No previous frame to diff against
+
+        // Remove the slowly varying level, keep onsets
+        mean_ = meanCoeff_ * mean_ + (1.0f - meanCoeff_) * flux;
+        novelty_ = std::max(flux - mean_, 0.0f);
+
+        pushNovelty(novelty_);
+        updateTempo();
+        updatePhase();
+
+        frames_++;
+        return estimate_;
+    }
+
+    const TempoEstimate& estimate() const { return estimate_; }
+
+    /// Novelty value of the last frame
+    float novelty() const { return novelty_; }
+
+private:
+    float past(int age) const {
+        int idx = writePos_ - 1 - age;
+        if (idx < 0) idx += historyLength_;
+        return history_[idx];
+    }
+
+    void pushNovelty(float x) {
+        history_[writePos_] = x;
+        writePos_ = (writePos_ + 1) % historyLength_;
+
+        // Sliding-window update: add the new product, drop the oldest
+        const float leaving = past(window_);
+        for (int k = 0; k <= maxLag_; k++) {
+            acf_[k] += static_cast<double>(x) * past(k)
+                     - static_cast<double>(leaving) * past(window_ + k);
+        }
+    }
+
+    void updateTempo() {
+        const double energy = acf_[0];
+        if (energy <= 1e-12) {
+            estimate_.confidence = 0.0f;
+            return;
+        }
+
+        int best = -1;
+        float bestScore = 0.0f;
+        for (int k = minLag_; k < maxLag_; k++) {
+            const float score = static_cast<float>(acf_[k]) * prior_[k];
+            if (score > bestScore && acf_[k] >= acf_[k - 1] && acf_[k] >= acf_[k + 1]) {
+                bestScore = score;
+                best = k;
+            }
+        }
+        if (best < 0) {
+            estimate_.confidence = 0.0f;
+            return;
+        }
+
+        // Parabolic interpolation of the period
+        const float a = static_cast<float>(acf_[best - 1]);
+        const float b = static_cast<float>(acf_[best]);
+        const float c = static_cast<float>(acf_[best + 1]);
+        const float denom = a - 2.0f * b + c;
+        const float delta = denom < 0.0f ? 0.5f * (a - c) / denom : 0.0f;
+
+        period_ = best + delta;
+        estimate_.bpm = 60.0f * config_.hopRateHz / period_;
+        estimate_.confidence = std::clamp(b / static_cast<float>(energy), 0.0f, 1.0f);
+    }
+
+    void updatePhase() {
+        if (period_ <= 0.0f) return;
+
+        oscPhase_ += 1.0f / period_;
+        oscPhase_ -= std::floor(oscPhase_);
+
+        // Leaky circular mean of novelty over the oscillator phase
+        const float angle = 2.0f * static_cast<float>(M_PI) * oscPhase_;
+        phaseRe_ = phaseLeak_ * phaseRe_ + novelty_ * std::cos(angle);
+        phaseIm_ = phaseLeak_ * phaseIm_ + novelty_ * std::sin(angle);
+
+        const float beatAt = std::atan2(phaseIm_, phaseRe_) / (2.0f * static_cast<float>(M_PI));
+        const float phase = oscPhase_ - beatAt;
+        estimate_.beatPhase = phase - std::floor(phase);
+    }
+
+    Config config_;
+    int minLag_ = 2;
+    int maxLag_ = 4;
+    int window_ = 5;
+    int historyLength_ = 10;
+
+    std::vector<float> history_;    // Ring of novelty values
+    std::vector<double> acf_;       // Sliding-window autocorrelation
+    std::vector<float> prior_;
+    std::vector<float> prevLog_;
+    int writePos_ = 0;
+    int64_t frames_ = 0;
+
+    float meanCoeff_ = 0.0f;
+    float mean_ = 0.0f;
+    float novelty_ = 0.0f;
+
+    float period_ = 0.0f;
+    float oscPhase_ = 0.0f;
+    float phaseLeak_ = 0.0f;
+    float phaseRe_ = 0.0f;
+    float phaseIm_ = 0.0f;
+
+    TempoEstimate estimate_;
+};
+
+} // namespace cortix
@@ -0,0 +1,201 @@
+/*
+ * Cortix - CPU Topology and Thread Placement
+ *
+ * Minimal NUMA/cache topology for placing pool workers and stream state:
+ * NUMA nodes and their CPUs from /sys/devices/system/node, the L2 size
+ * from /sys/devices/system/cpu/cpu0/cache, and thread pinning through
+ * sched_setaffinity. No libnuma: per-stream memory is placed by first
+ * touch, i.e. by allocating it from a thread running on the target node,
+ * and nodeOfAddress() asks the kernel (get_mempolicy) where it landed.
+ *
+ * On other systems, or when /sys is unavailable, detect() reports a
+ * single node with hardware_concurrency() CPUs and pinning is a no-op.
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <cstdint>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+namespace cortix {
+
+struct CpuTopology {
+    struct Node {
+        int id = 0;
+        std::vector<int> cpus;
+    };
+
+    std::vector<Node> nodes;
+    int64_t l2Bytes = 1 << 20;      // Per-core L2 (or a 1 MiB guess)
+
+    /// Total CPUs across nodes
+    int numCpus() const {
+        int n = 0;
+        for (const Node& node : nodes) n += static_cast<int>(node.cpus.size());
+        return n;
+    }
+
+    /// Node index (into nodes) of a CPU, or 0 if unknown
+    int nodeOfCpu(int cpu) const {
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (std::find(nodes[i].cpus.begin(), nodes[i].cpus.end(), cpu) != nodes[i].cpus.end()) {
+                return static_cast<int>(i);
+            }
+        }
+        return 0;
+    }
+
+    /// Node index of the page holding an address, or -1 if the kernel
+    /// cannot tell or the node is not in this topology
+    int nodeOfAddress(const void* address) const {
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+        int id = -1;
+        if (syscall(SYS_get_mempolicy, &id, nullptr, 0UL, address, MPOL_F_NODE | MPOL_F_ADDR) != 0) return -1;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (nodes[i].id == id) return static_cast<int>(i);
+        }
+#else
+        (void)address;
+#endif
+        return -1;
+    }
+
+    /// CPUs ordered so that consecutive entries alternate between nodes,
+    /// which spreads the first N workers evenly over the sockets
+    std::vector<int> interleavedCpus() const {
+        std::vector<int> order;
+        size_t longest = 0;
+        for (const Node& node : nodes) longest = std::max(longest, node.cpus.size());
+        for (size_t i = 0; i < longest; i++) {
+            for (const Node& node : nodes) {
+                if (i < node.cpus.size()) order.push_back(node.cpus[i]);
+            }
+        }
+        return order;
+    }
+
+    /// Read the topology of this machine
+    static CpuTopology detect() {
+        CpuTopology topo;
+#ifdef __linux__
+        std::string online;
+        if (readLine("/sys/devices/system/node/online", online)) {
+            for (int id : parseCpuList(online)) {
+                std::string cpus;
+                if (!readLine("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist", cpus)) continue;
+                Node node;
+                node.id = id;
+                node.cpus = parseCpuList(cpus);
+                if (!node.cpus.empty()) topo.nodes.push_back(node);
+            }
+        }
+        for (int index = 0; index < 8; index++) {
+            const std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+            std::string level, size;
+            if (!readLine(dir + "level", level)) break;
+            if (level == "2" && readLine(dir + "size", size)) {
+                topo.l2Bytes = parseSize(size);
+            }
+        }
+#endif
+        if (topo.nodes.empty()) {
+            Node node;
+            const int n = std::max(1u, std::thread::hardware_concurrency());
+            for (int i = 0; i < n; i++) node.cpus.push_back(i);
+            topo.nodes.push_back(node);
+        }
+        return topo;
+    }
+
+    /// Parse a Linux CPU list such as "0-3,8-11"
+    static std::vector<int> parseCpuList(const std::string& text) {
+        std::vector<int> cpus;
+        std::stringstream ss(text);
+        std::string range;
+        while (std::getline(ss, range, ',')) {
+            if (range.empty()) continue;
+            const size_t dash = range.find('-');
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int c = first; c <= last; c++) cpus.push_back(c);
+        }
+        return cpus;
+    }
+
+    /// Parse a cache size such as "2048K" or "2M"
+    static int64_t parseSize(const std::string& text) {
+        int64_t value = 0;
+        size_t i = 0;
+        while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+            value = value * 10 + (text[i++] - '0');
+        }
+        if (i < text.size() && (text[i] == 'K' || text[i] == 'k')) value <<= 10;
+        if (i < text.size() && (text[i] == 'M' || text[i] == 'm')) value <<= 20;
+        return value;
+    }
+
+private:
+    static bool readLine(const std::string& path, std::string& line) {
+        std::ifstream in(path);
+        return static_cast<bool>(std::getline(in, line));
+    }
+};
+
+/// Pin the calling thread to a set of CPUs. Returns false if unsupported.
+inline bool pinCurrentThread(const std::vector<int>& cpus) {
+#ifdef __linux__
+    if (cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) {
+        if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+/// Restricts the calling thread to some CPUs for its lifetime, then
+/// restores the previous mask. Used to first-touch memory on a node.
+class ScopedAffinity {
+public:
+    explicit ScopedAffinity(const std::vector<int>& cpus) {
+#ifdef __linux__
+        CPU_ZERO(&previous_);
+        saved_ = sched_getaffinity(0, sizeof(previous_), &previous_) == 0 && pinCurrentThread(cpus);
+#else
+        (void)cpus;
+#endif
+    }
+
+    ~ScopedAffinity() {
+#ifdef __linux__
+        if (saved_) sched_setaffinity(0, sizeof(previous_), &previous_);
+#endif
+    }
+
+    ScopedAffinity(const ScopedAffinity&) = delete;
+    ScopedAffinity& operator=(const ScopedAffinity&) = delete;
+
+private:
+    bool saved_ = false;
+#ifdef __linux__
+    cpu_set_t previous_;
+#endif
+};
+
+} // namespace cortix
@@ -0,0 +1,489 @@
+/*
+ * Cortix - C API
+ *
+ * Implementation of cortix_c.h over Analyser, BatchProcessor and
+ * AnalyserPool. Hop frames are copied into a per-handle queue by the frame
+ * callback and moved out in bulk by the read calls. No exception crosses
+ * the C boundary.
+ */
+
+#include <cortix/cortix_c.h>
+#include <cortix/cortix.h>
+#include <cortix/pool.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+/// Bounded queue of hop frames (envelopes and sample positions). The
+/// oldest frame is dropped when full.
+class FrameQueue {
+public:
+    FrameQueue(int numBands, int capacity)
+        : numBands_(numBands), capacity_(std::max(1, capacity)),
+          envelopes_(static_cast<size_t>(numBands) * capacity_), positions_(capacity_) {}
+
+    void push(const cortix::Analyser::Frame& frame) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (count_ == capacity_) {
+            head_ = (head_ + 1) % capacity_;
+            count_--;
+            dropped_++;
+        }
+        const int slot = (head_ + count_) % capacity_;
+        std::memcpy(&envelopes_[static_cast<size_t>(slot) * numBands_], frame.envelope,
+                    sizeof(float) * numBands_);
+        positions_[slot] = frame.samplePosition;
+        count_++;
+    }
+
+    int64_t read(float* envelopes, int64_t* positions, int64_t maxFrames) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const int n = static_cast<int>(std::min<int64_t>(maxFrames, count_));
+        // At most two contiguous runs of the ring
+        int done = 0;
+        while (done < n) {
+            const int run = std::min(n - done, capacity_ - head_);
+            std::memcpy(envelopes + static_cast<size_t>(done) * numBands_,
+                        &envelopes_[static_cast<size_t>(head_) * numBands_],
+                        sizeof(float) * numBands_ * run);
+            if (positions) std::memcpy(positions + done, &positions_[head_], sizeof(int64_t) * run);
+            head_ = (head_ + run) % capacity_;
+            count_ -= run;
+            done += run;
+        }
+        return n;
+    }
+
+    int64_t available() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+    int64_t dropped() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return dropped_;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        head_ = 0;
+        count_ = 0;
+    }
+
+private:
+    const int numBands_;
+    const int capacity_;
+    mutable std::mutex mutex_;
+    std::vector<float> envelopes_;
+    std::vector<int64_t> positions_;
+    int head_ = 0;
+    int count_ = 0;
+    int64_t dropped_ = 0;
+};
+
+/// Copy a caller's versioned struct over the defaults: older callers pass
+/// a smaller struct_size and keep the defaults of fields they lack
+template <typename T>
+bool readVersioned(const T* in, T& out) {
+    if (!in || in->struct_size < sizeof(uint32_t)) return false;
+    std::memcpy(&out, in, std::min<size_t>(in->struct_size, sizeof(T)));
+    out.struct_size = sizeof(T);
+    return true;
+}
+
+bool toAnalyserConfig(const cortix_config& in, cortix::Analyser::Config& out) {
+    if (in.sample_rate <= 0.0f || in.num_bands <= 0 || in.hop_size <= 0 || in.min_hz <= 0.0f ||
+        in.max_queued_frames <= 0 || in.scale < CORTIX_SCALE_LINEAR || in.scale > CORTIX_SCALE_MEL) {
+        return false;
+    }
+    out.sampleRate = in.sample_rate;
+    out.numBands = in.num_bands;
+    out.hopSize = in.hop_size;
+    out.minHz = in.min_hz;
+    out.maxHz = std::min(in.max_hz, 0.5f * in.sample_rate);
+    out.smoothingMs = in.smoothing_ms;
+    switch (in.scale) {
+        case CORTIX_SCALE_LINEAR: out.scale = cortix::Scale::Linear; break;
+        case CORTIX_SCALE_LOG: out.scale = cortix::Scale::Log; break;
+        case CORTIX_SCALE_BARK: out.scale = cortix::Scale::Bark; break;
+        case CORTIX_SCALE_ERB: out.scale = cortix::Scale::ERB; break;
+        default: out.scale = cortix::Scale::Mel; break;
+    }
+    return out.maxHz > out.minHz;
+}
+
+/// Same analysis design (the queue size is per stream, not per design)
+bool sameDesign(const cortix_config& a, const cortix_config& b) {
+    return a.sample_rate == b.sample_rate && a.num_bands == b.num_bands && a.hop_size == b.hop_size &&
+           a.min_hz == b.min_hz && a.max_hz == b.max_hz && a.smoothing_ms == b.smoothing_ms &&
+           a.scale == b.scale;
+}
+
+/// Average interleaved channels into mono, whole block at once
+void downmix(const float* in, int64_t numFrames, int channels, float* out) {
+    if (channels == 1) {
+        std::memcpy(out, in, sizeof(float) * numFrames);
+        return;
+    }
+    const float scale = 1.0f / static_cast<float>(channels);
+    for (int64_t i = 0; i < numFrames; i++) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels; c++) sum += in[i * channels + c];
+        out[i] = sum * scale;
+    }
+}
+
+void downmix(const int16_t* in, int64_t numFrames, int channels, float* out) {
+    const float scale = 1.0f / (32768.0f * static_cast<float>(channels));
+    if (channels == 1) {
+        for (int64_t i = 0; i < numFrames; i++) out[i] = static_cast<float>(in[i]) * scale;
+        return;
+    }
+    for (int64_t i = 0; i < numFrames; i++) {
+        int32_t sum = 0;
+        for (int c = 0; c < channels; c++) sum += in[i * channels + c];
+        out[i] = static_cast<float>(sum) * scale;
+    }
+}
+
+bool validBlock(const void* samples, int64_t numFrames, int32_t channels) {
+    return (samples || numFrames == 0) && numFrames >= 0 && numFrames <= INT32_MAX && channels > 0;
+}
+
+/// Run f, turning exceptions into status codes at the C boundary
+template <typename F>
+auto guarded(F&& f) -> decltype(f()) {
+    using Result = decltype(f());
+    try {
+        return f();
+    } catch (const std::bad_alloc&) {
+        return static_cast<Result>(CORTIX_ERROR_OUT_OF_MEMORY);
+    } catch (...) {
+        return static_cast<Result>(CORTIX_ERROR_INTERNAL);
+    }
+}
+
+} // namespace
+
+struct cortix_analyser {
+    cortix_analyser(const cortix::Analyser::Config& config, int maxQueuedFrames)
+        : analyser(config), frames(config.numBands, maxQueuedFrames) {
+        analyser.setFrameCallback([this](const cortix::Analyser::Frame& frame) { frames.push(frame); });
+    }
+
+    /// Downmix or convert into scratch, then one process() call
+    template <typename Sample>
+    cortix_status process(const Sample* samples, int64_t numFrames, int32_t channels) {
+        if (!validBlock(samples, numFrames, channels)) return CORTIX_ERROR_INVALID_ARGUMENT;
+        if (numFrames == 0) return CORTIX_OK;
+        const float* mono = reinterpret_cast<const float*>(samples);
+        if (!std::is_same<Sample, float>::value || channels != 1) {
+            scratch.resize(static_cast<size_t>(numFrames));
+            downmix(samples, numFrames, channels, scratch.data());
+            mono = scratch.data();
+        }
+        analyser.process(mono, static_cast<int>(numFrames));
+        return CORTIX_OK;
+    }
+
+    cortix::Analyser analyser;
+    FrameQueue frames;
+    std::vector<float> scratch;
+};
+
+struct cortix_pool {
+    explicit cortix_pool(const cortix::AnalyserPool::Config& config)
+        : pool(config), queues(static_cast<size_t>(config.maxStreams)) {}
+
+    struct Design {
+        cortix_config config;
+        cortix::AnalyserPool::DesignId id;
+    };
+
+    /// Shared, so a reader keeps its queue alive across a concurrent remove
+    std::shared_ptr<FrameQueue> queue(int32_t stream) {
+        if (stream < 0 || stream >= static_cast<int32_t>(queues.size())) return nullptr;
+        std::lock_guard<std::mutex> lock(mutex);
+        return queues[stream];
+    }
+
+    template <typename Sample>
+    cortix_status submit(int32_t stream, const Sample* samples, int64_t numFrames, int32_t channels) {
+        if (!validBlock(samples, numFrames, channels)) return CORTIX_ERROR_INVALID_ARGUMENT;
+        if (!queue(stream)) return CORTIX_ERROR_UNKNOWN_STREAM;
+        const float* mono = reinterpret_cast<const float*>(samples);
+        thread_local std::vector<float> scratch;
+        if (!std::is_same<Sample, float>::value || channels != 1) {
+            scratch.resize(static_cast<size_t>(numFrames));
+            downmix(samples, numFrames, channels, scratch.data());
+            mono = scratch.data();
+        }
+        return pool.submit(stream, mono, static_cast<int>(numFrames)) ? CORTIX_OK : CORTIX_ERROR_FULL;
+    }
+
+    cortix::AnalyserPool pool;
+    std::mutex mutex;                       // designs and queues
+    std::vector<Design> designs;
+    std::vector<std::shared_ptr<FrameQueue>> queues;
+};
+
+extern "C" {
+
+int cortix_abi_version(void) {
+    return CORTIX_C_ABI_VERSION;
+}
+
+const char* cortix_version_string(void) {
+    static const std::string version = std::to_string(cortix::VERSION_MAJOR) + "." +
+                                       std::to_string(cortix::VERSION_MINOR) + "." +
+                                       std::to_string(cortix::VERSION_PATCH);
+    return version.c_str();
+}
+
+const char* cortix_status_string(int status) {
+    switch (status) {
+        case CORTIX_OK: return "ok";
+        case CORTIX_ERROR_INVALID_ARGUMENT: return "invalid argument";
+        case CORTIX_ERROR_OUT_OF_MEMORY: return "out of memory";
+        case CORTIX_ERROR_FULL: return "queue or stream limit reached";
+        case CORTIX_ERROR_UNKNOWN_STREAM: return "unknown stream";
+        case CORTIX_ERROR_INTERNAL: return "internal error";
+        default: return "unknown status";
+    }
+}
+
+void cortix_config_init(cortix_config* config) {
+    if (!config) return;
+    const cortix::Analyser::Config defaults;
+    config->struct_size = sizeof(cortix_config);
+    config->sample_rate = defaults.sampleRate;
+    config->num_bands = defaults.numBands;
+    config->hop_size = defaults.hopSize;
+    config->min_hz = defaults.minHz;
+    config->max_hz = defaults.maxHz;
+    config->smoothing_ms = defaults.smoothingMs;
+    config->scale = CORTIX_SCALE_ERB;
+    config->max_queued_frames = 1024;
+}
+
+void cortix_pool_config_init(cortix_pool_config* config) {
+    if (!config) return;
+    const cortix::AnalyserPool::Config defaults;
+    config->struct_size = sizeof(cortix_pool_config);
+    config->num_threads = defaults.numThreads;
+    config->max_streams = defaults.maxStreams;
+    config->max_queued_samples = defaults.maxQueuedSamples;
+    config->realtime_budget_ms = defaults.realTimeBudgetMs;
+}
+
+//==============================================================================
+// Analyser
+
+cortix_analyser* cortix_analyser_create(const cortix_config* config) {
+    cortix_config c;
+    cortix_config_init(&c);
+    cortix::Analyser::Config analyserConfig;
+    if (!readVersioned(config, c) || !toAnalyserConfig(c, analyserConfig)) return nullptr;
+    try {
+        return new cortix_analyser(analyserConfig, c.max_queued_frames);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void cortix_analyser_destroy(cortix_analyser* analyser) {
+    delete analyser;
+}
+
+void cortix_analyser_reset(cortix_analyser* analyser) {
+    if (!analyser) return;
+    analyser->analyser.reset();
+    analyser->frames.clear();
+}
+
+int32_t cortix_analyser_num_bands(const cortix_analyser* analyser) {
+    return analyser ? analyser->analyser.numBands() : int32_t{CORTIX_ERROR_INVALID_ARGUMENT};
+}
+
+int32_t cortix_analyser_hop_size(const cortix_analyser* analyser) {
+    return analyser ? analyser->analyser.hopSize() : int32_t{CORTIX_ERROR_INVALID_ARGUMENT};
+}
+
+cortix_status cortix_analyser_center_hz(const cortix_analyser* analyser, float* out) {
+    if (!analyser || !out) return CORTIX_ERROR_INVALID_ARGUMENT;
+    for (int b = 0; b < analyser->analyser.numBands(); b++) out[b] = analyser->analyser.centerHz(b);
+    return CORTIX_OK;
+}
+
+cortix_status cortix_analyser_process_f32(cortix_analyser* analyser, const float* samples,
+                                          int64_t num_frames, int32_t channels) {
+    if (!analyser) return CORTIX_ERROR_INVALID_ARGUMENT;
+    return guarded([&] { return analyser->process(samples, num_frames, channels); });
+}
+
+cortix_status cortix_analyser_process_s16(cortix_analyser* analyser, const int16_t* samples,
+                                          int64_t num_frames, int32_t channels) {
+    if (!analyser) return CORTIX_ERROR_INVALID_ARGUMENT;
+    return guarded([&] { return analyser->process(samples, num_frames, channels); });
+}
+
+cortix_status cortix_process_batch(const cortix_packet* packets, int32_t num_packets) {
+    if (num_packets < 0 || (!packets && num_packets > 0)) return CORTIX_ERROR_INVALID_ARGUMENT;
+    return guarded([&]() -> cortix_status {
+        thread_local cortix::BatchProcessor batch;
+        thread_local std::vector<cortix::StreamPacket> streamPackets;
+        streamPackets.resize(static_cast<size_t>(num_packets));
+        for (int32_t i = 0; i < num_packets; i++) {
+            const cortix_packet& p = packets[i];
+            if (!p.analyser || p.num_samples < 0 || (!p.samples && p.num_samples > 0)) {
+                return CORTIX_ERROR_INVALID_ARGUMENT;
+            }
+            streamPackets[i] = cortix::StreamPacket{&p.analyser->analyser, p.samples, p.num_samples};
+        }
+        batch.process(streamPackets.data(), num_packets);
+        return CORTIX_OK;
+    });
+}
+
+int64_t cortix_analyser_frames_available(const cortix_analyser* analyser) {
+    return analyser ? analyser->frames.available() : int64_t{CORTIX_ERROR_INVALID_ARGUMENT};
+}
+
+int64_t cortix_analyser_read_frames(cortix_analyser* analyser, float* envelopes,
+                                    int64_t* sample_positions, int64_t max_frames) {
+    if (!analyser || !envelopes || max_frames < 0) return CORTIX_ERROR_INVALID_ARGUMENT;
+    return analyser->frames.read(envelopes, sample_positions, max_frames);
+}
+
+int64_t cortix_analyser_dropped_frames(const cortix_analyser* analyser) {
+    return analyser ? analyser->frames.dropped() : int64_t{CORTIX_ERROR_INVALID_ARGUMENT};
+}
+
+cortix_status cortix_analyser_envelope(const cortix_analyser* analyser, float* out) {
+    if (!analyser || !out) return CORTIX_ERROR_INVALID_ARGUMENT;
+    const std::vector<float>& envelope = analyser->analyser.envelope();
+    std::copy(envelope.begin(), envelope.end(), out);
+    return CORTIX_OK;
+}
+
+//==============================================================================
+// Pool
+
+cortix_pool* cortix_pool_create(const cortix_pool_config* config) {
+    cortix_pool_config c;
+    cortix_pool_config_init(&c);
+    if (!readVersioned(config, c)) return nullptr;
+    if (c.num_threads < 0 || c.max_streams <= 0 || c.max_queued_samples <= 0 || c.realtime_budget_ms < 0.0) {
+        return nullptr;
+    }
+    cortix::AnalyserPool::Config poolConfig;
+    poolConfig.numThreads = c.num_threads;
+    poolConfig.maxStreams = c.max_streams;
+    poolConfig.maxQueuedSamples = c.max_queued_samples;
+    poolConfig.realTimeBudgetMs = c.realtime_budget_ms;
+    try {
+        return new cortix_pool(poolConfig);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void cortix_pool_destroy(cortix_pool* pool) {
+    delete pool;
+}
+
+int32_t cortix_pool_add_stream(cortix_pool* pool, const cortix_config* config, int32_t priority) {
+    cortix_config c;
+    cortix_config_init(&c);
+    cortix::Analyser::Config analyserConfig;
+    if (!pool || !readVersioned(config, c) || !toAnalyserConfig(c, analyserConfig) ||
+        (priority != CORTIX_PRIORITY_REALTIME && priority != CORTIX_PRIORITY_OFFLINE)) {
+        return CORTIX_ERROR_INVALID_ARGUMENT;
+    }
+    return guarded([&]() -> int32_t {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        // Streams with the same design share one design id, so the pool batches them
+        auto design = std::find_if(pool->designs.begin(), pool->designs.end(),
+                                   [&](const cortix_pool::Design& d) { return sameDesign(d.config, c); });
+        if (design == pool->designs.end()) {
+            pool->designs.push_back(cortix_pool::Design{c, pool->pool.addDesign(analyserConfig)});
+            design = pool->designs.end() - 1;
+        }
+        const int32_t stream = pool->pool.addStream(design->id, static_cast<cortix::AnalyserPool::Priority>(priority));
+        if (stream < 0) return CORTIX_ERROR_FULL;
+
+        auto frames = std::make_shared<FrameQueue>(c.num_bands, c.max_queued_frames);
+        pool->queues[stream] = frames;
+        pool->pool.setFrameCallback(stream, [frames](const cortix::Analyser::Frame& frame) { frames->push(frame); });
+        return stream;
+    });
+}
+
+cortix_status cortix_pool_remove_stream(cortix_pool* pool, int32_t stream) {
+    if (!pool) return CORTIX_ERROR_INVALID_ARGUMENT;
+    if (stream < 0 || stream >= static_cast<int32_t>(pool->queues.size())) return CORTIX_ERROR_UNKNOWN_STREAM;
+    {
+        // Unpublish the queue before the pool frees the id: once it does, a
+        // concurrent add_stream may reuse the id and install its own queue
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (!pool->queues[stream]) return CORTIX_ERROR_UNKNOWN_STREAM;
+        pool->queues[stream].reset();
+    }
+    pool->pool.removeStream(stream);
+    return CORTIX_OK;
+}
+
+cortix_status cortix_pool_submit_f32(cortix_pool* pool, int32_t stream, const float* samples,
+                                     int64_t num_frames, int32_t channels) {
+    if (!pool) return CORTIX_ERROR_INVALID_ARGUMENT;
+    return guarded([&] { return pool->submit(stream, samples, num_frames, channels); });
+}
+
+cortix_status cortix_pool_submit_s16(cortix_pool* pool, int32_t stream, const int16_t* samples,
+                                     int64_t num_frames, int32_t channels) {
+    if (!pool) return CORTIX_ERROR_INVALID_ARGUMENT;
+    return guarded([&] { return pool->submit(stream, samples, num_frames, channels); });
+}
+
+void cortix_pool_drain(cortix_pool* pool) {
+    if (pool) pool->pool.drain();
+}
+
+int64_t cortix_pool_frames_available(cortix_pool* pool, int32_t stream) {
+    if (!pool) return CORTIX_ERROR_INVALID_ARGUMENT;
+    const std::shared_ptr<FrameQueue> frames = pool->queue(stream);
+    return frames ? frames->available() : int64_t{CORTIX_ERROR_UNKNOWN_STREAM};
+}
+
+int64_t cortix_pool_read_frames(cortix_pool* pool, int32_t stream, float* envelopes,
+                                int64_t* sample_positions, int64_t max_frames) {
+    if (!pool || !envelopes || max_frames < 0) return CORTIX_ERROR_INVALID_ARGUMENT;
+    const std::shared_ptr<FrameQueue> frames = pool->queue(stream);
+    return frames ? frames->read(envelopes, sample_positions, max_frames) : int64_t{CORTIX_ERROR_UNKNOWN_STREAM};
+}
+
+int64_t cortix_pool_dropped_frames(cortix_pool* pool, int32_t stream) {
+    if (!pool) return CORTIX_ERROR_INVALID_ARGUMENT;
+    const std::shared_ptr<FrameQueue> frames = pool->queue(stream);
+    return frames ? frames->dropped() : int64_t{CORTIX_ERROR_UNKNOWN_STREAM};
+}
+
+cortix_status cortix_pool_get_stats(const cortix_pool* pool, cortix_pool_stats* stats) {
+    if (!pool || !stats) return CORTIX_ERROR_INVALID_ARGUMENT;
+    const cortix::AnalyserPool::PoolStats s = pool->pool.stats();
+    stats->processed_blocks = s.processedBlocks;
+    stats->rejected_blocks = s.rejectedBlocks;
+    stats->realtime_deadline_misses = pool->pool.classStats(cortix::AnalyserPool::Priority::RealTime).deadlineMisses;
+    stats->offline_deadline_misses = pool->pool.classStats(cortix::AnalyserPool::Priority::Offline).deadlineMisses;
+    stats->steals = s.steals;
+    return CORTIX_OK;
+}
+
+} // extern "C"
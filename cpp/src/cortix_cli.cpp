@@ -0,0 +1,175 @@
+/*
+ * Cortix - Command-Line Streaming Analyser
+ *
+ * Reads raw interleaved PCM from stdin and writes binary hop frames to
+ * stdout, for pipelines such as
+ *
+ *   ffmpeg -i in.wav -f s16le -ac 2 -ar 48000 - | cortix --channels 2 | tool
+ *
+ * Output is protocol.h messages (a StreamInfo, then one Frame per hop) or,
+ * with --output raw, bare float32 envelopes. Messages can carry quantised
+ * dB frames instead of float32 (--encoding u8|u16, plus --delta and
+ * --pack), which shrinks the output several times. Reads are large; output is
+ * buffered and written by a separate thread so a slow consumer only
+ * blocks the analysis once --pending-buffers buffers are waiting.
+ */
+
+#include <cortix/cortix.h>
+#include <cortix/pcm.h>
+#include <cortix/framewriter.h>
+#include <unistd.h>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void usage() {
+    std::cerr <<
+        "usage: cortix [options] < pcm > frames\n"
+        "  --rate HZ             input sample rate (48000)\n"
+        "  --channels N          interleaved channels, averaged to mono, 1-64 (1)\n"
+        "  --format s16|f32      little-endian sample format (s16)\n"
+        "  --bands N             analysis bands (40)\n"
+        "  --hop N               samples per output frame (128)\n"
+        "  --min-hz HZ           lowest band centre (20)\n"
+        "  --max-hz HZ           highest band centre (min(20000, rate/2))\n"
+        "  --scale erb|bark|mel|log|linear   band spacing (erb)\n"
+        "  --output messages|raw frame format (messages)\n"
+        "  --encoding f32|u8|u16 frame values in messages (f32)\n"
+        "  --min-db DB           bottom of the u8/u16 range (-100)\n"
+        "  --max-db DB           top of the u8/u16 range (0)\n"
+        "  --delta               code changes since the previous frame\n"
+        "  --keyframe N          frames per keyframe with --delta (64)\n"
+        "  --pack                bit-pack values (best with --delta)\n"
+        "  --read-bytes N        bytes per read from stdin (1048576)\n"
+        "  --buffer-bytes N      bytes per write to stdout (1048576)\n"
+        "  --pending-buffers N   output buffers queued for a slow consumer (16)\n"
+        "  --stats               print throughput counters to stderr\n";
+}
+
+bool parseScale(const std::string& name, cortix::Scale& scale) {
+    if (name == "erb") scale = cortix::Scale::ERB;
+    else if (name == "bark") scale = cortix::Scale::Bark;
+    else if (name == "mel") scale = cortix::Scale::Mel;
+    else if (name == "log") scale = cortix::Scale::Log;
+    else if (name == "linear") scale = cortix::Scale::Linear;
+    else return false;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    cortix::Analyser::Config config;
+    cortix::PcmFormat format = cortix::PcmFormat::S16;
+    cortix::FrameWriter::Config output;
+    int channels = 1;
+    size_t readBytes = 1 << 20;
+    bool maxHzSet = false;
+    bool printStats = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        const std::string value = hasValue ? argv[i + 1] : "";
+        bool ok = true;
+        if (arg == "--rate" && hasValue) config.sampleRate = std::strtof(argv[++i], nullptr);
+        else if (arg == "--channels" && hasValue) channels = std::atoi(argv[++i]);
+        else if (arg == "--format" && hasValue) ok = cortix::parsePcmFormat(argv[++i], format);
+        else if (arg == "--bands" && hasValue) config.numBands = std::atoi(argv[++i]);
+        else if (arg == "--hop" && hasValue) config.hopSize = std::atoi(argv[++i]);
+        else if (arg == "--min-hz" && hasValue) config.minHz = std::strtof(argv[++i], nullptr);
+        else if (arg == "--max-hz" && hasValue) {
+            config.maxHz = std::strtof(argv[++i], nullptr);
+            maxHzSet = true;
+        }
+        else if (arg == "--scale" && hasValue) ok = parseScale(argv[++i], config.scale);
+        else if (arg == "--output" && hasValue) {
+            ++i;
+            if (value == "messages") output.format = cortix::FrameWriter::Format::Messages;
+            else if (value == "raw") output.format = cortix::FrameWriter::Format::Raw;
+            else ok = false;
+        }
+        else if (arg == "--encoding" && hasValue) {
+            ++i;
+            output.quantize = value != "f32";
+            if (value == "u8") output.encoding.precision = cortix::FrameEncoding::Uint8;
+            else if (value == "u16") output.encoding.precision = cortix::FrameEncoding::Uint16;
+            else if (value != "f32") ok = false;
+        }
+        else if (arg == "--min-db" && hasValue) output.encoding.minDb = std::strtof(argv[++i], nullptr);
+        else if (arg == "--max-db" && hasValue) output.encoding.maxDb = std::strtof(argv[++i], nullptr);
+        else if (arg == "--delta") output.encoding.delta = true;
+        else if (arg == "--keyframe" && hasValue) output.encoding.keyframeInterval = std::atoi(argv[++i]);
+        else if (arg == "--pack") output.encoding.packed = true;
+        else if (arg == "--read-bytes" && hasValue) readBytes = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--buffer-bytes" && hasValue) output.bufferBytes = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--pending-buffers" && hasValue) output.maxPendingBuffers = std::atoi(argv[++i]);
+        else if (arg == "--stats") printStats = true;
+        else if (arg == "--help" || arg == "-h") {
+            usage();
+            return 0;
+        }
+        else ok = false;
+
+        if (!ok) {
+            std::cerr << "cortix: bad argument " << arg << (hasValue ? " " + value : "") << "\n";
+            usage();
+            return 2;
+        }
+    }
+    if (!maxHzSet) config.maxHz = std::min(config.maxHz, 0.5f * config.sampleRate);
+    if (config.sampleRate <= 0.0f || config.numBands <= 0 || config.hopSize <= 0 || channels <= 0 ||
+        channels > cortix::PcmDecoder::kMaxChannels || readBytes == 0 || config.maxHz <= config.minHz ||
+        (output.quantize && (output.format != cortix::FrameWriter::Format::Messages ||
+                             output.encoding.maxDb <= output.encoding.minDb))) {
+        std::cerr << "cortix: invalid configuration\n";
+        return 2;
+    }
+
+    // A closed pipe shows up as a failed write, not a signal
+    std::signal(SIGPIPE, SIG_IGN);
+
+    cortix::Analyser analyser(config);
+    cortix::FrameWriter writer(STDOUT_FILENO, output);
+    writer.begin(analyser);
+    analyser.setFrameCallback([&](const cortix::Analyser::Frame& frame) { writer.write(frame); });
+
+    cortix::PcmDecoder decoder(format, channels);
+    std::vector<uint8_t> bytes(readBytes);
+    std::vector<float> samples(decoder.maxSamples(readBytes) + 1);
+    int64_t totalSamples = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (;;) {
+        const ssize_t n = ::read(STDIN_FILENO, bytes.data(), bytes.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "cortix: read failed: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        if (n == 0) break;
+        const size_t count = decoder.decode(bytes.data(), static_cast<size_t>(n), samples.data());
+        analyser.process(samples.data(), static_cast<int>(count));
+        totalSamples += static_cast<int64_t>(count);
+        if (writer.failed()) break;     // Downstream went away
+    }
+
+    const bool ok = writer.finish();
+    if (printStats) {
+        const cortix::FrameWriter::Stats s = writer.stats();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << "cortix: " << totalSamples << " samples, " << s.frames << " frames, "
+                  << s.bytesWritten << " bytes in " << s.writeCalls << " writes, "
+                  << totalSamples / std::max(seconds, 1e-9) / config.sampleRate << "x real time, "
+                  << "stalled " << s.stallSeconds << " s (peak " << s.peakPendingBuffers << " buffers queued)\n";
+    }
+    if (decoder.pendingBytes() > 0) {
+        std::cerr << "cortix: ignored " << decoder.pendingBytes() << " trailing bytes (incomplete sample frame)\n";
+    }
+    return ok ? 0 : 1;
+}
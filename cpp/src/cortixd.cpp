@@ -0,0 +1,84 @@
+/*
+ * Cortix - Analysis Daemon
+ *
+ * Serves the protocol in cortix/protocol.h on a UNIX domain socket:
+ *
+ *   cortixd [--socket PATH] [--threads N] [--max-queued SAMPLES]
+ *           [--max-streams N] [--stats-seconds S]
+ *
+ * Stops cleanly on SIGINT or SIGTERM.
+ */
+
+#include <cortix/daemon.h>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+
+cortix::AnalysisServer* gServer = nullptr;
+
+void onSignal(int) {
+    if (gServer) gServer->stop();
+}
+
+void usage() {
+    std::cerr << "usage: cortixd [--socket PATH] [--threads N] [--max-queued SAMPLES]\n"
+                 "               [--max-streams N] [--stats-seconds S]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    cortix::AnalysisServer::Config config;
+    double statsSeconds = 0.0;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--socket" && hasValue) {
+            config.socketPath = argv[++i];
+        } else if (arg == "--threads" && hasValue) {
+            config.pool.numThreads = std::atoi(argv[++i]);
+        } else if (arg == "--max-queued" && hasValue) {
+            config.pool.maxQueuedSamples = std::atoll(argv[++i]);
+        } else if (arg == "--max-streams" && hasValue) {
+            config.pool.maxStreams = std::atoi(argv[++i]);
+        } else if (arg == "--stats-seconds" && hasValue) {
+            statsSeconds = std::atof(argv[++i]);
+        } else {
+            usage();
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+
+    cortix::AnalysisServer server(config);
+    if (!server.start()) {
+        std::cerr << "cortixd: cannot listen on " << config.socketPath << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    gServer = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::cerr << "cortixd: listening on " << config.socketPath << " with "
+              << server.pool().numThreads() << " worker(s)\n";
+
+    auto lastReport = std::chrono::steady_clock::now();
+    while (server.poll(statsSeconds > 0.0 ? 1000 : -1)) {
+        if (statsSeconds <= 0.0) continue;
+        const auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<double>(now - lastReport).count() < statsSeconds) continue;
+        lastReport = now;
+        const cortix::AnalysisServer::Stats s = server.stats();
+        std::cerr << "cortixd: " << s.connections << " connections, " << s.streams << " streams, "
+                  << s.audioBlocks << " blocks (" << s.rejectedBlocks << " rejected), "
+                  << s.framesQueued << " frames (" << s.framesDropped << " dropped), "
+                  << s.writeCalls << " writes\n";
+    }
+
+    gServer = nullptr;
+    std::cerr << "cortixd: stopped\n";
+    return 0;
+}
@@ -27,6 +27,7 @@ public:
         config.scale = static_cast<Scale>(scaleType);
         config.mode = AnalysisMode::Gammatone;
         config.smoothingMs = 5.0f;
+        config.enableDescriptors = true;
         analyser_.configure(config);
 
         // Allocate output buffers
@@ -47,6 +48,7 @@ public:
         config.scale = static_cast<Scale>(scaleType);
         config.mode = AnalysisMode::Gammatone;
         config.smoothingMs = smoothingMs;
+        config.enableDescriptors = true;
         analyser_.configure(config);
 
         envelope_.resize(numBands);
@@ -132,6 +134,13 @@ public:
         return reinterpret_cast<std::uintptr_t>(centerFreqs_.data());
     }
 
+    /// Spectral descriptors of the latest hop
+    float spectralCentroid() const { return analyser_.descriptors().current().centroidHz; }
+    float spectralSpread() const { return analyser_.descriptors().current().spreadHz; }
+    float spectralFlatness() const { return analyser_.descriptors().current().flatness; }
+    float spectralRolloff() const { return analyser_.descriptors().current().rolloffHz; }
+    float spectralSlope() const { return analyser_.descriptors().current().slopeDbPerOctave; }
+
 private:
     Analyser analyser_;
     std::vector<float> envelope_;
@@ -183,7 +192,12 @@ EMSCRIPTEN_BINDINGS(cortix) {
         .function("getCenterHz", &AnalyserWasm::getCenterHz)
         .function("getEnvelopePtr", &AnalyserWasm::getEnvelopePtr)
         .function("getEnvelopeDbPtr", &AnalyserWasm::getEnvelopeDbPtr)
-        .function("getCenterFreqsPtr", &AnalyserWasm::getCenterFreqsPtr);
+        .function("getCenterFreqsPtr", &AnalyserWasm::getCenterFreqsPtr)
+        .function("spectralCentroid", &AnalyserWasm::spectralCentroid)
+        .function("spectralSpread", &AnalyserWasm::spectralSpread)
+        .function("spectralFlatness", &AnalyserWasm::spectralFlatness)
+        .function("spectralRolloff", &AnalyserWasm::spectralRolloff)
+        .function("spectralSlope", &AnalyserWasm::spectralSlope);
 
     // Scale conversion functions
     function("hzToBark", &wasm_hzToBark);
@@ -0,0 +1,321 @@
+/*
+ * Cortix - C API Tests
+ */
+
+#include <cortix/cortix_c.h>
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_BANDS 24
+#define HOP 128
+
+static const double kPi = 3.14159265358979323846;
+
+static void smallConfig(cortix_config* config) {
+    cortix_config_init(config);
+    config->num_bands = NUM_BANDS;
+    config->hop_size = HOP;
+    config->min_hz = 50.0f;
+    config->max_hz = 8000.0f;
+}
+
+static void sine(float* out, int n, float hz, float sampleRate) {
+    for (int i = 0; i < n; i++) out[i] = 0.5f * (float)sin(2.0 * kPi * hz * i / sampleRate);
+}
+
+static int loudestBand(const float* envelope) {
+    int best = 0;
+    for (int b = 1; b < NUM_BANDS; b++) {
+        if (envelope[b] > envelope[best]) best = b;
+    }
+    return best;
+}
+
+static void testAnalyser(void) {
+    printf("Testing analyser handle...\n");
+
+    cortix_config config;
+    smallConfig(&config);
+    cortix_analyser* mono = cortix_analyser_create(&config);
+    cortix_analyser* stereo = cortix_analyser_create(&config);
+    assert(mono && stereo);
+    assert(cortix_analyser_num_bands(mono) == NUM_BANDS);
+    assert(cortix_analyser_hop_size(mono) == HOP);
+
+    float centers[NUM_BANDS];
+    cortix_status status = cortix_analyser_center_hz(mono, centers);
+    assert(status == CORTIX_OK);
+    for (int b = 1; b < NUM_BANDS; b++) assert(centers[b] > centers[b - 1]);
+
+    // The same 1 kHz tone as mono float32 and as stereo int16, in uneven blocks
+    const int n = 48 * HOP;
+    float* signal = malloc(sizeof(float) * n);
+    int16_t* pcm = malloc(sizeof(int16_t) * 2 * n);
+    sine(signal, n, 1000.0f, config.sample_rate);
+    for (int i = 0; i < n; i++) {
+        pcm[2 * i] = pcm[2 * i + 1] = (int16_t)lrintf(signal[i] * 32767.0f);
+    }
+    const int blocks[] = {1000, 37, 2000, n - 3037};
+    int offset = 0;
+    for (int k = 0; k < 4; k++) {
+        status = cortix_analyser_process_f32(mono, signal + offset, blocks[k], 1);
+        assert(status == CORTIX_OK);
+        status = cortix_analyser_process_s16(stereo, pcm + 2 * offset, blocks[k], 2);
+        assert(status == CORTIX_OK);
+        offset += blocks[k];
+    }
+
+    // Bulk retrieval, in two reads
+    assert(cortix_analyser_frames_available(mono) == n / HOP);
+    float* envelopes = malloc(sizeof(float) * NUM_BANDS * (n / HOP));
+    float* other = malloc(sizeof(float) * NUM_BANDS * (n / HOP));
+    int64_t positions[48];
+    int64_t count = cortix_analyser_read_frames(mono, envelopes, positions, 10);
+    assert(count == 10);
+    count = cortix_analyser_read_frames(mono, envelopes + 10 * NUM_BANDS, positions + 10, 1000);
+    assert(count == n / HOP - 10);
+    assert(cortix_analyser_frames_available(mono) == 0);
+    count = cortix_analyser_read_frames(stereo, other, NULL, 1000);
+    assert(count == n / HOP);
+    for (int f = 0; f < n / HOP; f++) assert(positions[f] == (int64_t)(f + 1) * HOP);
+
+    // int16 stereo matches float mono up to quantisation; the tone lands near 1 kHz
+    const float* last = envelopes + (n / HOP - 1) * NUM_BANDS;
+    const float* lastOther = other + (n / HOP - 1) * NUM_BANDS;
+    for (int b = 0; b < NUM_BANDS; b++) assert(fabsf(last[b] - lastOther[b]) <= 1e-3f * (1.0f + last[b]));
+    const int peak = loudestBand(last);
+    assert(centers[peak] > 700.0f && centers[peak] < 1400.0f);
+
+    float envelope[NUM_BANDS];
+    status = cortix_analyser_envelope(mono, envelope);
+    assert(status == CORTIX_OK && loudestBand(envelope) == peak);
+    (void)lastOther;
+    (void)peak;
+
+    // A full queue keeps the newest frames
+    cortix_config small = config;
+    small.max_queued_frames = 8;
+    cortix_analyser* bounded = cortix_analyser_create(&small);
+    status = cortix_analyser_process_f32(bounded, signal, 20 * HOP, 1);
+    assert(status == CORTIX_OK);
+    assert(cortix_analyser_frames_available(bounded) == 8);
+    assert(cortix_analyser_dropped_frames(bounded) == 12);
+    count = cortix_analyser_read_frames(bounded, envelopes, positions, 48);
+    assert(count == 8);
+    assert(positions[0] == 13 * HOP && positions[7] == 20 * HOP);
+
+    // Older callers with a shorter struct keep the defaults of newer fields
+    cortix_config old = config;
+    old.struct_size = (uint32_t)offsetof(cortix_config, max_queued_frames);
+    old.max_queued_frames = -1;
+    cortix_analyser* legacy = cortix_analyser_create(&old);
+    assert(legacy);
+
+    // Invalid arguments
+    cortix_config bad = config;
+    bad.num_bands = 0;
+    cortix_analyser* invalid = cortix_analyser_create(&bad);
+    assert(invalid == NULL);
+    invalid = cortix_analyser_create(NULL);
+    assert(invalid == NULL);
+    status = cortix_analyser_process_f32(mono, NULL, 10, 1);
+    assert(status == CORTIX_ERROR_INVALID_ARGUMENT);
+    status = cortix_analyser_process_f32(mono, signal, 10, 0);
+    assert(status == CORTIX_ERROR_INVALID_ARGUMENT);
+    count = cortix_analyser_read_frames(NULL, envelopes, NULL, 1);
+    assert(count == CORTIX_ERROR_INVALID_ARGUMENT);
+
+    cortix_analyser_reset(mono);
+    status = cortix_analyser_process_f32(mono, signal, 2 * HOP, 1);
+    assert(status == CORTIX_OK);
+    count = cortix_analyser_read_frames(mono, envelopes, positions, 48);
+    assert(count == 2 && positions[0] == HOP);
+    (void)status;
+    (void)count;
+    (void)invalid;
+
+    cortix_analyser_destroy(legacy);
+    cortix_analyser_destroy(bounded);
+    cortix_analyser_destroy(stereo);
+    cortix_analyser_destroy(mono);
+    free(other);
+    free(envelopes);
+    free(pcm);
+    free(signal);
+    printf("  Analyser: PASSED\n");
+}
+
+static void testBatch(void) {
+    printf("Testing batch processing...\n");
+
+    cortix_config config;
+    smallConfig(&config);
+    enum { kStreams = 3, kSamples = 40 * HOP };
+    cortix_analyser* batched[kStreams];
+    cortix_analyser* direct[kStreams];
+    float* signals[kStreams];
+    cortix_status status;
+    for (int s = 0; s < kStreams; s++) {
+        batched[s] = cortix_analyser_create(&config);
+        direct[s] = cortix_analyser_create(&config);
+        signals[s] = malloc(sizeof(float) * kSamples);
+        sine(signals[s], kSamples, 300.0f + 500.0f * s, config.sample_rate);
+        status = cortix_analyser_process_f32(direct[s], signals[s], kSamples, 1);
+        assert(status == CORTIX_OK);
+    }
+
+    // Ragged packets for every stream, a few calls each
+    int offsets[kStreams] = {0};
+    const int sizes[] = {64, 300, 17, 1000, 555};
+    cortix_packet packets[2 * kStreams];
+    for (int round = 0; offsets[0] < kSamples; round++) {
+        int count = 0;
+        for (int k = 0; k < 2; k++) {
+            for (int s = 0; s < kStreams; s++) {
+                int size = sizes[(round + k + s) % 5];
+                if (size > kSamples - offsets[s]) size = kSamples - offsets[s];
+                packets[count].analyser = batched[s];
+                packets[count].samples = signals[s] + offsets[s];
+                packets[count].num_samples = size;
+                offsets[s] += size;
+                count++;
+            }
+        }
+        status = cortix_process_batch(packets, count);
+        assert(status == CORTIX_OK);
+    }
+
+    float a[40 * NUM_BANDS];
+    float b[40 * NUM_BANDS];
+    for (int s = 0; s < kStreams; s++) {
+        assert(offsets[s] == kSamples);
+        const int64_t batchedFrames = cortix_analyser_read_frames(batched[s], a, NULL, 40);
+        const int64_t directFrames = cortix_analyser_read_frames(direct[s], b, NULL, 40);
+        assert(batchedFrames == 40 && directFrames == 40);
+        assert(memcmp(a, b, sizeof(a)) == 0);
+        (void)batchedFrames;
+        (void)directFrames;
+        cortix_analyser_destroy(batched[s]);
+        cortix_analyser_destroy(direct[s]);
+        free(signals[s]);
+    }
+
+    packets[0].analyser = NULL;
+    status = cortix_process_batch(packets, 1);
+    assert(status == CORTIX_ERROR_INVALID_ARGUMENT);
+    (void)status;
+    printf("  Batch: PASSED\n");
+}
+
+static void testPool(void) {
+    printf("Testing pool handle...\n");
+
+    cortix_pool_config poolConfig;
+    cortix_pool_config_init(&poolConfig);
+    poolConfig.num_threads = 3;
+    poolConfig.max_streams = 8;
+    poolConfig.max_queued_samples = 1 << 20;
+    cortix_pool* pool = cortix_pool_create(&poolConfig);
+    assert(pool);
+
+    cortix_config config;
+    smallConfig(&config);
+    enum { kStreams = 6, kBlock = 480, kBlocks = 32 };
+    const int numFrames = kBlock * kBlocks / HOP;
+    int32_t ids[kStreams];
+    float* signals[kStreams];
+    for (int s = 0; s < kStreams; s++) {
+        ids[s] = cortix_pool_add_stream(pool, &config, s % 2 ? CORTIX_PRIORITY_REALTIME : CORTIX_PRIORITY_OFFLINE);
+        assert(ids[s] >= 0);
+        signals[s] = malloc(sizeof(float) * kBlock * kBlocks);
+        sine(signals[s], kBlock * kBlocks, 200.0f + 150.0f * s, config.sample_rate);
+    }
+
+    cortix_status status;
+    for (int k = 0; k < kBlocks; k++) {
+        for (int s = 0; s < kStreams; s++) {
+            status = cortix_pool_submit_f32(pool, ids[s], signals[s] + k * kBlock, kBlock, 1);
+            assert(status == CORTIX_OK);
+        }
+    }
+    cortix_pool_drain(pool);
+
+    // Identical to a standalone analyser fed the whole signal
+    float* pooled = malloc(sizeof(float) * NUM_BANDS * numFrames);
+    float* reference = malloc(sizeof(float) * NUM_BANDS * numFrames);
+    int64_t* positions = malloc(sizeof(int64_t) * numFrames);
+    for (int s = 0; s < kStreams; s++) {
+        assert(cortix_pool_frames_available(pool, ids[s]) == numFrames);
+        int64_t count = cortix_pool_read_frames(pool, ids[s], pooled, positions, numFrames);
+        assert(count == numFrames && positions[numFrames - 1] == (int64_t)kBlock * kBlocks);
+        cortix_analyser* direct = cortix_analyser_create(&config);
+        status = cortix_analyser_process_f32(direct, signals[s], kBlock * kBlocks, 1);
+        assert(status == CORTIX_OK);
+        count = cortix_analyser_read_frames(direct, reference, NULL, numFrames);
+        assert(count == numFrames);
+        (void)count;
+        assert(memcmp(pooled, reference, sizeof(float) * NUM_BANDS * numFrames) == 0);
+        cortix_analyser_destroy(direct);
+    }
+
+    // int16 submits, then stream removal and the stream limit
+    int16_t pcm[2 * kBlock];
+    memset(pcm, 0, sizeof(pcm));
+    status = cortix_pool_submit_s16(pool, ids[0], pcm, kBlock, 2);
+    assert(status == CORTIX_OK);
+    cortix_pool_drain(pool);
+    int64_t count = cortix_pool_read_frames(pool, ids[0], pooled, NULL, numFrames);
+    assert(count == kBlock / HOP);
+
+    int32_t added = cortix_pool_add_stream(pool, &config, CORTIX_PRIORITY_OFFLINE);
+    assert(added >= 0);
+    added = cortix_pool_add_stream(pool, &config, CORTIX_PRIORITY_OFFLINE);
+    assert(added >= 0);
+    added = cortix_pool_add_stream(pool, &config, CORTIX_PRIORITY_OFFLINE);
+    assert(added == CORTIX_ERROR_FULL);
+    status = cortix_pool_remove_stream(pool, ids[1]);
+    assert(status == CORTIX_OK);
+    status = cortix_pool_submit_f32(pool, ids[1], signals[1], kBlock, 1);
+    assert(status == CORTIX_ERROR_UNKNOWN_STREAM);
+    count = cortix_pool_read_frames(pool, ids[1], pooled, NULL, 1);
+    assert(count == CORTIX_ERROR_UNKNOWN_STREAM);
+    status = cortix_pool_remove_stream(pool, ids[1]);
+    assert(status == CORTIX_ERROR_UNKNOWN_STREAM);
+    added = cortix_pool_add_stream(pool, &config, 7);
+    assert(added == CORTIX_ERROR_INVALID_ARGUMENT);
+    (void)count;
+    (void)added;
+
+    cortix_pool_stats stats;
+    status = cortix_pool_get_stats(pool, &stats);
+    assert(status == CORTIX_OK);
+    (void)status;
+    assert(stats.processed_blocks == kStreams * kBlocks + 1);
+    assert(stats.rejected_blocks == 0);
+
+    cortix_pool_destroy(pool);
+    for (int s = 0; s < kStreams; s++) free(signals[s]);
+    free(positions);
+    free(reference);
+    free(pooled);
+    printf("  Pool: PASSED (%lld steals)\n", (long long)stats.steals);
+}
+
+int main(void) {
+    printf("Cortix C API Test Suite\n");
+    printf("=======================\n\n");
+
+    assert(cortix_abi_version() == CORTIX_C_ABI_VERSION);
+    printf("Library version %s\n", cortix_version_string());
+    assert(strcmp(cortix_status_string(CORTIX_ERROR_FULL), "queue or stream limit reached") == 0);
+
+    testAnalyser();
+    testBatch();
+    testPool();
+
+    printf("\nAll tests PASSED!\n");
+    return 0;
+}
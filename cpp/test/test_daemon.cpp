@@ -0,0 +1,194 @@
+/*
+ * Cortix - Protocol and Daemon Tests
+ */
+
+#include <cortix/daemon.h>
+#include <iostream>
+#include <cmath>
+#include <cassert>
+#include <vector>
+#include <thread>
+#include <string>
+
+using namespace cortix;
+
+void testProtocol() {
+    std::cout << "Testing framed protocol...\n";
+
+    protocol::StreamSetup setup;
+    setup.sampleRate = 16000.0f;
+    setup.numBands = 24;
+    setup.hopSize = 64;
+    setup.minHz = 50.0f;
+    setup.maxHz = 7000.0f;
+    setup.scale = Scale::Mel;
+    setup.realTime = true;
+
+    std::vector<uint8_t> bytes;
+    protocol::MessageWriter writer(bytes);
+    writer.openStream(7, setup);
+    const float samples[3] = {0.5f, -1.0f, 1e-20f};
+    writer.audio(3, samples, 3);
+    writer.error(protocol::ErrorCode::UnknownStream, 9, "unknown stream");
+    assert(bytes.size() == (8 + 24) + (8 + 4 + 12) + (8 + 8 + 14));
+
+    // Fed one byte at a time, the same messages come out
+    protocol::MessageParser parser;
+    std::vector<protocol::MessageType> types;
+    for (uint8_t b : bytes) {
+        parser.append(&b, 1);
+        protocol::Message m;
+        while (parser.next(m)) {
+            types.push_back(m.type);
+            protocol::PayloadReader in(m);
+            if (m.type == protocol::MessageType::OpenStream) {
+                protocol::StreamSetup decoded;
+                [[maybe_unused]] const uint32_t requestId = in.u32();
+                [[maybe_unused]] const bool haveSetup = in.readSetup(decoded);
+                assert(requestId == 7 && haveSetup);
+                assert(decoded.numBands == 24 && decoded.hopSize == 64 && decoded.scale == Scale::Mel);
+                assert(decoded.realTime && decoded.sampleRate == 16000.0f);
+            } else if (m.type == protocol::MessageType::Audio) {
+                float decoded[3];
+                [[maybe_unused]] const uint32_t audioStream = in.u32();
+                [[maybe_unused]] bool haveSamples = in.floats(decoded, 3);
+                assert(audioStream == 3 && haveSamples);
+                assert(decoded[0] == 0.5f && decoded[1] == -1.0f && decoded[2] == 1e-20f);
+                haveSamples = in.floats(decoded, 1);
+                assert(!haveSamples);               // Past the end
+            } else {
+                [[maybe_unused]] const uint32_t code = in.u32();
+                [[maybe_unused]] const uint32_t errorStream = in.u32();
+                [[maybe_unused]] const std::string text = in.text();
+                assert(code == static_cast<uint32_t>(protocol::ErrorCode::UnknownStream));
+                assert(errorStream == 9 && text == "unknown stream");
+            }
+        }
+    }
+    assert(types.size() == 3 && parser.pending() == 0);
+
+    // Oversized or unknown messages poison the stream
+    const uint8_t bad[8] = {0xff, 0xff, 0xff, 0x7f, 1, 0, 0, 0};
+    protocol::MessageParser corrupt;
+    corrupt.append(bad, 8);
+    protocol::Message m;
+    [[maybe_unused]] const bool parsed = corrupt.next(m);
+    assert(!parsed && corrupt.failed());
+
+    std::cout << "  Protocol: PASSED\n";
+}
+
+void testDaemon() {
+    std::cout << "Testing daemon over a UNIX socket...\n";
+
+    AnalysisServer::Config config;
+    config.socketPath = "/tmp/cortix_test_" + std::to_string(::getpid()) + ".sock";
+    config.pool.numThreads = 2;
+    AnalysisServer server(config);
+    [[maybe_unused]] const bool started = server.start();
+    assert(started);
+    std::thread io([&] { server.run(); });
+
+    protocol::StreamSetup setup;
+    setup.sampleRate = 16000.0f;
+    setup.numBands = 24;
+    setup.hopSize = 64;
+    setup.minHz = 50.0f;
+    setup.maxHz = 7000.0f;
+
+    // The producer opens a stream; two other processes subscribe to it
+    AnalysisClient producer, listenerA, listenerB;
+    [[maybe_unused]] bool ok = producer.connect(config.socketPath);
+    ok = listenerA.connect(config.socketPath) && ok;
+    ok = listenerB.connect(config.socketPath) && ok;
+    assert(ok);
+    const int64_t stream = producer.openStream(setup);
+    assert(stream >= 0);
+    ok = listenerA.subscribe(static_cast<uint32_t>(stream));
+    ok = listenerB.subscribe(static_cast<uint32_t>(stream)) && ok;
+    assert(ok);
+
+    const int numSamples = 16000;
+    std::vector<float> signal(numSamples);
+    for (int i = 0; i < numSamples; i++) {
+        signal[i] = 0.5f * std::sin(2.0f * static_cast<float>(M_PI) * 440.0f * i / 16000.0f);
+    }
+    for (int pos = 0; pos < numSamples; pos += 160) {
+        ok = producer.sendAudio(static_cast<uint32_t>(stream), signal.data() + pos, 160);
+        assert(ok);
+    }
+
+    Analyser::Config reference;
+    reference.sampleRate = setup.sampleRate;
+    reference.numBands = setup.numBands;
+    reference.hopSize = setup.hopSize;
+    reference.minHz = setup.minHz;
+    reference.maxHz = setup.maxHz;
+    reference.scale = setup.scale;
+    Analyser local(reference);
+    std::vector<std::vector<float>> expected;
+    local.setFrameCallback([&](const Analyser::Frame& frame) {
+        expected.emplace_back(frame.envelope, frame.envelope + frame.numBands);
+    });
+    local.process(signal.data(), numSamples);
+    const int numFrames = numSamples / setup.hopSize;
+    assert(static_cast<int>(expected.size()) == numFrames);
+
+    // Both subscribers get every frame, in order, identical to a local analyser
+    for (AnalysisClient* listener : {&listenerA, &listenerB}) {
+        AnalysisClient::ReceivedFrame frame;
+        for (int i = 0; i < numFrames; i++) {
+            ok = listener->readFrame(frame);
+            assert(ok);
+            assert(frame.stream == stream && frame.index == i);
+            assert(frame.samplePosition == static_cast<int64_t>(i + 1) * setup.hopSize);
+            assert(frame.envelope == expected[i]);
+        }
+    }
+
+    // Setups whose range is empty after clamping to Nyquist, or too large, are refused
+    protocol::StreamSetup bad = setup;
+    bad.minHz = 9000.0f;
+    bad.maxHz = 12000.0f;
+    [[maybe_unused]] int64_t refused = listenerA.openStream(bad);
+    assert(refused < 0);
+    assert(listenerA.errors().back().code == protocol::ErrorCode::BadMessage);
+    bad = setup;
+    bad.numBands = config.maxBands + 1;
+    refused = listenerA.openStream(bad);
+    assert(refused < 0);
+
+    // Only the owner may feed the stream
+    listenerA.sendAudio(static_cast<uint32_t>(stream), signal.data(), 16);
+    listenerA.pump(100);
+    assert(!listenerA.errors().empty());
+    assert(listenerA.errors().back().code == protocol::ErrorCode::NotOwner);
+
+    // Every frame reached both subscribers; writes are batched per connection
+    AnalysisServer::Stats stats = server.stats();
+    assert(stats.framesQueued == 2 * numFrames && stats.framesDropped == 0);
+    assert(stats.connections == 3 && stats.streams == 1);
+    std::cout << "  " << stats.framesQueued << " frames in " << stats.writeCalls << " writes\n";
+
+    // Closing the producer closes its stream for the subscribers
+    producer.close();
+    listenerB.pump(200);
+    assert(listenerB.closedStreams().size() == 1 && listenerB.closedStreams()[0] == stream);
+
+    server.stop();
+    io.join();
+    assert(server.stats().streams == 0);
+
+    std::cout << "  Daemon: PASSED\n";
+}
+
+int main() {
+    std::cout << "Cortix Daemon Test Suite\n";
+    std::cout << "========================\n\n";
+
+    testProtocol();
+    testDaemon();
+
+    std::cout << "\nAll tests PASSED!\n";
+    return 0;
+}
@@ -0,0 +1,976 @@
+/*
+ * Cortix - Feature Stage Tests
+ */
+
+#include <cortix/cortix.h>
+#include <iostream>
+#include <cmath>
+#include <cassert>
+#include <vector>
+#include <sstream>
+#include <numeric>
+#include <thread>
+
+using namespace cortix;
+
+bool approxEqual(float a, float b, float tolerance = 0.01f) {
+    return std::abs(a - b) < tolerance;
+}
+
+/// Harmonic complex with the given partials (1 = fundamental)
+std::vector<float> harmonicTone(float f0, int firstHarmonic, int lastHarmonic,
+                                int numSamples, float sampleRate = 48000.0f) {
+    std::vector<float> signal(numSamples, 0.0f);
+    for (int h = firstHarmonic; h <= lastHarmonic; h++) {
+        for (int i = 0; i < numSamples; i++) {
+            signal[i] += 0.2f * std::sin(2.0f * M_PI * f0 * h * i / sampleRate);
+        }
+    }
+    return signal;
+}
+
+void testCorrelogramPitch() {
+    std::cout << "Testing correlogram pitch...\n";
+
+    Analyser::Config config;
+    config.numBands = 64;
+    config.minHz = 50.0f;
+    config.maxHz = 8000.0f;
+    config.enablePitch = true;
+
+    // Missing fundamental: only harmonics 3..8 of 200 Hz
+    const float f0 = 200.0f;
+    Analyser analyser(config);
+    auto signal = harmonicTone(f0, 3, 8, 24000);
+
+    int frames = 0;
+    analyser.setFrameCallback([&]([[maybe_unused]] const Analyser::Frame& frame) {
+        assert(frame.pitch != nullptr);
+        assert(frame.index == frames);
+        assert(frame.samplePosition == (frames + 1) * config.hopSize);
+        frames++;
+    });
+    analyser.process(signal.data(), static_cast<int>(signal.size()));
+    assert(frames == 24000 / config.hopSize);
+
+    const PitchEstimate& est = analyser.pitch();
+    assert(est.numCandidates > 0);
+    const float best = est.candidates[0].f0Hz;
+    assert(approxEqual(best, f0, f0 * 0.03f));
+    assert(est.candidates[0].salience > 0.2f);
+
+    // Full harmonic series: three times the period must not tie with it
+    for (float full : {200.0f, 330.0f}) {
+        Analyser tracker(config);
+        auto tone = harmonicTone(full, 1, 8, 24000);
+        int settled = 0, onPeriod = 0;
+        tracker.setFrameCallback([&](const Analyser::Frame& frame) {
+            if (frame.index < 20 || frame.pitch->numCandidates == 0) return;
+            settled++;
+            onPeriod += approxEqual(frame.pitch->candidates[0].f0Hz, full, full * 0.03f);
+        });
+        tracker.process(tone.data(), static_cast<int>(tone.size()));
+        assert(settled > 0 && onPeriod == settled);
+    }
+
+    std::cout << "  Correlogram pitch: PASSED (F0 " << best << " Hz, salience "
+              << est.candidates[0].salience << ")\n";
+}
+
+void testChroma() {
+    std::cout << "Testing chroma...\n";
+
+    Analyser::Config config;
+    config.scale = Scale::Log;
+    config.numBands = 144;          // 2 bands per semitone over 6 octaves
+    config.minHz = 55.0f;
+    config.maxHz = 3520.0f;
+    config.enableChroma = true;
+
+    // A major triad: A4, C#5, E5
+    Analyser analyser(config);
+    std::vector<float> signal(24000, 0.0f);
+    const float notes[] = {440.0f, 554.37f, 659.26f};
+    for (float hz : notes) {
+        for (size_t i = 0; i < signal.size(); i++) {
+            signal[i] += 0.2f * std::sin(2.0f * M_PI * hz * i / config.sampleRate);
+        }
+    }
+    analyser.process(signal.data(), static_cast<int>(signal.size()));
+
+    [[maybe_unused]] const auto& chroma = analyser.chroma().chroma();
+    assert(chroma.size() == 12);
+    // Gammatone bands are ERB-wide, so neighbouring semitones leak; the
+    // triad must still hold the three strongest bins.
+    const int triad[] = {9, 1, 4};   // A, C#, E
+    for ([[maybe_unused]] int c : triad) {
+        for (int other = 0; other < 12; other++) {
+            if (other == 9 || other == 1 || other == 4) continue;
+            assert(chroma[c] > chroma[other]);
+        }
+    }
+    assert(chroma[6] < 0.5f);        // F# is two semitones from any chord tone
+
+    // A 440 Hz tone tuned 30 cents sharp
+    Analyser::Config sharpConfig = config;
+    sharpConfig.chroma.tuningSmoothing = 0.9f;
+    Analyser sharp(sharpConfig);
+    const float hz = 440.0f * std::pow(2.0f, 30.0f / 1200.0f);
+    for (size_t i = 0; i < signal.size(); i++) {
+        signal[i] = 0.5f * std::sin(2.0f * M_PI * hz * i / config.sampleRate);
+    }
+    sharp.process(signal.data(), static_cast<int>(signal.size()));
+    const float cents = sharp.chroma().tuningCents();
+    assert(cents > 15.0f && cents < 45.0f);
+
+    std::cout << "  Chroma: PASSED (tuning estimate " << cents << " cents)\n";
+}
+
+void testCepstrum() {
+    std::cout << "Testing cepstrum...\n";
+
+    const int numBands = 32;
+    const int numFrames = 40;
+    CepstrumExtractor::Config config;
+    CepstrumExtractor gfcc(config, numBands);
+    assert(gfcc.featureDim() == 39);
+    assert(gfcc.latency() == 4);
+
+    // Flat spectrum: all energy in c0
+    CepstrumExtractor::Config plainConfig;
+    plainConfig.lifter = 0.0f;
+    plainConfig.deltas = false;
+    plainConfig.deltaDeltas = false;
+    CepstrumExtractor plain(plainConfig, numBands);
+    assert(plain.latency() == 0);
+
+    std::vector<float> flat(numBands, 0.1f);
+    [[maybe_unused]] const auto& c = plain.process(flat.data());
+    assert(approxEqual(c[0], 2.0f * std::log(0.1f) * std::sqrt(float(numBands)), 0.01f));
+    for (int j = 1; j < 13; j++) {
+        assert(approxEqual(c[j], 0.0f, 1e-3f));
+    }
+
+    // Streaming output matches the batch variant away from the edges
+    std::vector<float> envelopes(numFrames * numBands);
+    for (int t = 0; t < numFrames; t++) {
+        for (int b = 0; b < numBands; b++) {
+            envelopes[t * numBands + b] = 0.05f + 0.04f * std::sin(0.3f * t + 0.7f * b);
+        }
+    }
+    std::vector<float> batch(numFrames * gfcc.featureDim());
+    gfcc.processBatch(envelopes.data(), numFrames, batch.data());
+
+    gfcc.reset();
+    const int lat = gfcc.latency();
+    for (int t = 0; t < numFrames; t++) {
+        [[maybe_unused]] const auto& feat = gfcc.process(&envelopes[t * numBands]);
+        const int aligned = t - lat;
+        if (aligned < lat) continue;
+        for (int j = 0; j < gfcc.featureDim(); j++) {
+            assert(approxEqual(feat[j], batch[aligned * gfcc.featureDim() + j], 1e-3f));
+        }
+    }
+
+    std::cout << "  Cepstrum: PASSED\n";
+}
+
+void testSpectralDescriptors() {
+    std::cout << "Testing spectral descriptors...\n";
+
+    // Flat spectrum on a linear scale
+    auto linear = generateBands(Scale::Linear, 40, 0.0f, 8000.0f);
+    SpectralDescriptors flat(SpectralDescriptors::Config{}, linear);
+    std::vector<float> env(40, 0.5f);
+    [[maybe_unused]] const auto& f = flat.process(env.data());
+    assert(approxEqual(f.centroidHz, 4000.0f, 10.0f));
+    assert(approxEqual(f.flatness, 1.0f, 0.01f));
+    assert(approxEqual(f.slopeDbPerOctave, 0.0f, 0.1f));
+    assert(f.rolloffHz >= linear[33].centerHz && f.rolloffHz <= linear[34].centerHz);
+
+    // Single tonal band: centroid on it, no spread, not flat
+    std::fill(env.begin(), env.end(), 0.0f);
+    env[10] = 1.0f;
+    [[maybe_unused]] const auto& t = flat.process(env.data());
+    assert(approxEqual(t.centroidHz, linear[10].centerHz, 1.0f));
+    assert(t.spreadHz < 1.0f);
+    assert(t.flatness < 0.01f);
+
+    // Pink spectrum (power ~ 1/f) falls 3 dB per octave
+    auto log = generateBands(Scale::Log, 60, 50.0f, 12800.0f);
+    SpectralDescriptors pink(SpectralDescriptors::Config{}, log);
+    std::vector<float> pinkEnv(60);
+    for (int b = 0; b < 60; b++) {
+        pinkEnv[b] = 1.0f / std::sqrt(log[b].centerHz);
+    }
+    [[maybe_unused]] const auto& p = pink.process(pinkEnv.data());
+    assert(approxEqual(p.slopeDbPerOctave, -3.01f, 0.05f));
+
+    // Batch series is chronological and matches streaming
+    std::vector<float> frames;
+    frames.insert(frames.end(), pinkEnv.begin(), pinkEnv.end());
+    frames.insert(frames.end(), 60, 0.25f);
+    DescriptorSeries series;
+    pink.processBatch(frames.data(), 2, series);
+    assert(series.count == 2);
+    assert(approxEqual(series.slopeDbPerOctave[series.slot(1)], p.slopeDbPerOctave, 1e-4f));
+    assert(approxEqual(series.slopeDbPerOctave[series.slot(0)], 0.0f, 0.1f));
+    assert(pink.series().count == 1);
+
+    std::cout << "  Spectral descriptors: PASSED\n";
+}
+
+void testTempo() {
+    std::cout << "Testing tempo tracking...\n";
+
+    Analyser::Config config;
+    config.numBands = 32;
+    config.enableTempo = true;
+
+    // Short noise bursts at 128 BPM, first beat at 100 ms
+    const float bpm = 128.0f;
+    const int period = static_cast<int>(config.sampleRate * 60.0f / bpm);
+    const int offset = 4800;
+    std::vector<float> signal(static_cast<int>(config.sampleRate * 12.0f), 0.0f);
+    unsigned seed = 1;
+    for (int start = offset; start + 480 < (int)signal.size(); start += period) {
+        for (int i = 0; i < 480; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            float noise = ((seed >> 9) / 8388608.0f) - 1.0f;
+            signal[start + i] = noise * std::exp(-i / 96.0f);
+        }
+    }
+
+    // Record where the tracker predicts beats (beat phase wraps) late in the signal
+    float lastPhase = 0.0f;
+    int beats = 0;
+    int onBeat = 0;
+    Analyser analyser(config);
+    analyser.setFrameCallback([&](const Analyser::Frame& frame) {
+        const float phase = frame.tempo->beatPhase;
+        if (frame.samplePosition > 8 * 48000 && phase < lastPhase) {
+            const int rel = static_cast<int>((frame.samplePosition - offset) % period);
+            const int dist = std::min(rel, period - rel);
+            beats++;
+            if (dist < 0.05f * config.sampleRate) onBeat++;
+        }
+        lastPhase = phase;
+    });
+    analyser.process(signal.data(), static_cast<int>(signal.size()));
+
+    const TempoEstimate& est = analyser.tempo();
+    assert(approxEqual(est.bpm, bpm, 2.0f));
+    assert(est.confidence > 0.3f);
+    assert(beats >= 7 && onBeat >= beats - 1);
+
+    std::cout << "  Tempo tracking: PASSED (" << est.bpm << " BPM, confidence "
+              << est.confidence << ")\n";
+}
+
+void testPartialTracking() {
+    std::cout << "Testing partial tracking...\n";
+
+    Analyser::Config config;
+    config.numBands = 64;
+    config.enablePartials = true;
+
+    // Steady 50 Hz hum harmonic at 150 Hz plus a whistle gliding 2.0 -> 2.2 kHz
+    Analyser analyser(config);
+    const int numSamples = 24000;
+    std::vector<float> signal(numSamples);
+    double glidePhase = 0.0;
+    for (int i = 0; i < numSamples; i++) {
+        const float glideHz = 2000.0f + 200.0f * i / numSamples;
+        glidePhase += 2.0 * M_PI * glideHz / config.sampleRate;
+        signal[i] = 0.3f * std::sin(2.0f * M_PI * 150.0f * i / config.sampleRate)
+                  + 0.3f * static_cast<float>(std::sin(glidePhase));
+    }
+
+    std::vector<int> humIds;
+    analyser.setFrameCallback([&](const Analyser::Frame& frame) {
+        if (frame.index < 40) return;   // Let the filters settle
+        for (int p = 0; p < frame.numPeaks; p++) {
+            if (std::abs(frame.peaks[p].freqHz - 150.0f) < 3.0f) {
+                const int slot = analyser.partials().trackForPeak(p);
+                humIds.push_back(analyser.partials().tracks()[slot].id);
+            }
+        }
+    });
+    analyser.process(signal.data(), numSamples);
+
+    // The hum is found every hop and stays on one track
+    assert(humIds.size() == static_cast<size_t>(numSamples / config.hopSize - 40));
+    for ([[maybe_unused]] int id : humIds) assert(id == humIds.front());
+
+    // The whistle is tracked near its final frequency via instantaneous frequency
+    [[maybe_unused]] bool foundWhistle = false;
+    for (const auto& track : analyser.partials().tracks()) {
+        if (track.active && std::abs(track.freqHz - 2200.0f) < 20.0f) {
+            foundWhistle = track.length > 100;
+        }
+    }
+    assert(foundWhistle);
+
+    std::cout << "  Partial tracking: PASSED\n";
+}
+
+void testNoiseFloor() {
+    std::cout << "Testing noise floor...\n";
+
+    Analyser::Config config;
+    config.numBands = 32;
+    config.enableNoiseFloor = true;
+    config.noiseFloor.windowSeconds = 1.0f;
+
+    // White noise throughout, a 1 kHz tone from 1.5 s on
+    const int numSamples = 96000;
+    const int toneStart = 72000;
+    std::vector<float> signal(numSamples);
+    unsigned seed = 7;
+    for (int i = 0; i < numSamples; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        signal[i] = 0.01f * (((seed >> 9) / 8388608.0f) - 1.0f);
+        if (i >= toneStart) signal[i] += 0.3f * std::sin(2.0f * M_PI * 1000.0f * i / config.sampleRate);
+    }
+
+    Analyser analyser(config);
+    analyser.process(signal.data(), toneStart);
+    std::vector<float> floorBefore = analyser.noiseFloor().floorDb();
+    analyser.process(signal.data() + toneStart, numSamples - toneStart);
+
+    int toneBand = 0;
+    for (int b = 0; b < config.numBands; b++) {
+        if (std::abs(analyser.centerHz(b) - 1000.0f) < std::abs(analyser.centerHz(toneBand) - 1000.0f)) {
+            toneBand = b;
+        }
+    }
+
+    // 0.5 s into the tone the floor has not followed it up
+    [[maybe_unused]] const auto& floorDb = analyser.noiseFloor().floorDb();
+    const auto& snrDb = analyser.noiseFloor().snrDb();
+    assert(approxEqual(floorDb[toneBand], floorBefore[toneBand], 3.0f));
+    assert(snrDb[toneBand] > 20.0f);
+
+    // Noise-only bands sit near 0 dB SNR
+    assert(std::abs(snrDb[config.numBands - 2]) < 6.0f);
+
+    std::cout << "  Noise floor: PASSED (tone SNR " << snrDb[toneBand] << " dB)\n";
+}
+
+void testLateralInhibition() {
+    std::cout << "Testing lateral inhibition...\n";
+
+    Analyser::Config config;
+    config.numBands = 64;
+    config.minHz = 50.0f;
+    config.maxHz = 8000.0f;
+    config.enableInhibition = true;
+
+    Analyser analyser(config);
+    const LateralInhibition& inhibition = analyser.inhibition();
+    assert(inhibition.radius() > 0);
+
+    // Centre tap excites, far taps inhibit
+    [[maybe_unused]] const int mid = config.numBands / 2;
+    assert(inhibition.weight(mid, 0) > 0.0f);
+    assert(inhibition.weight(mid, inhibition.radius()) < 0.0f);
+
+    const int numSamples = 24000;
+    std::vector<float> signal = harmonicTone(1000.0f, 1, 1, numSamples);
+    analyser.process(signal.data(), numSamples);
+
+    const auto& raw = analyser.envelope();
+    const auto& sharp = inhibition.output();
+    int peak = 0;
+    for (int b = 0; b < config.numBands; b++) {
+        if (raw[b] > raw[peak]) peak = b;
+    }
+
+    // The peak survives and fewer bands sit within 20 dB of it
+    assert(sharp[peak] > 0.0f);
+    int rawWidth = 0, sharpWidth = 0;
+    for (int b = 0; b < config.numBands; b++) {
+        if (raw[b] > 0.1f * raw[peak]) rawWidth++;
+        if (sharp[b] > 0.1f * sharp[peak]) sharpWidth++;
+    }
+    assert(sharpWidth < rawWidth);
+    assert(sharp[peak + 4] == 0.0f && sharp[peak - 4] == 0.0f);
+
+    // A flat spectrum is scaled by (1 - strength)
+    std::vector<float> flat(config.numBands, 1.0f);
+    LateralInhibition standalone(config.inhibition, analyser.bands());
+    [[maybe_unused]] const auto& out = standalone.process(flat.data());
+    assert(approxEqual(out[mid], 1.0f - config.inhibition.strength, 1e-3f));
+
+    std::cout << "  Lateral inhibition: PASSED (" << rawWidth << " -> " << sharpWidth << " bands)\n";
+}
+
+void testBandStatistics() {
+    std::cout << "Testing band statistics...\n";
+
+    BandStatistics::Config config;
+    config.numBands = 2;
+    config.binDb = 0.25f;
+
+    // Band 0 alternates between -40 and -20 dB, band 1 sweeps -60..-30 dB
+    const int numFrames = 4000;
+    std::vector<float> frames(numFrames * 2);
+    for (int t = 0; t < numFrames; t++) {
+        frames[t * 2] = std::pow(10.0f, (t % 2 ? -20.0f : -40.0f) / 20.0f);
+        frames[t * 2 + 1] = std::pow(10.0f, (-60.0f + 30.0f * t / numFrames) / 20.0f);
+    }
+
+    BandStatistics whole(config);
+    for (int t = 0; t < numFrames; t++) {
+        whole.process(&frames[t * 2]);
+    }
+    assert(whole.count() == numFrames);
+    assert(approxEqual(whole.meanDb(0), -30.0f, 0.01f));
+    assert(approxEqual(whole.stdDevDb(0), 10.0f, 0.01f));
+    // LTAS averages power: mean of 1e-2 and 1e-4 is about -23 dB
+    assert(approxEqual(whole.ltasDb(0), 10.0f * std::log10(0.00505f), 0.01f));
+
+    // Uniform sweep: median in the middle, quartiles a quarter in
+    assert(approxEqual(whole.quantileDb(1, 0.5f), -45.0f, 0.3f));
+    assert(approxEqual(whole.quantileDb(1, 0.25f), -52.5f, 0.3f));
+    assert(approxEqual(whole.quantileDb(1, 0.9f), -33.0f, 0.3f));
+
+    // Two chunks merged give the single-pass result
+    BandStatistics first(config), second(config);
+    for (int t = 0; t < numFrames; t++) {
+        (t < 1234 ? first : second).process(&frames[t * 2]);
+    }
+    [[maybe_unused]] const bool merged = first.merge(second);
+    assert(merged);
+    assert(first.count() == whole.count());
+    for (int b = 0; b < 2; b++) {
+        assert(approxEqual(first.meanDb(b), whole.meanDb(b), 1e-3f));
+        assert(approxEqual(first.varianceDb(b), whole.varianceDb(b), 1e-2f));
+        assert(approxEqual(first.ltasDb(b), whole.ltasDb(b), 1e-3f));
+        assert(first.quantileDb(b, 0.5f) == whole.quantileDb(b, 0.5f));
+    }
+
+    // Accumulators with other bands or bins are refused, not misread
+    BandStatistics::Config wider = config;
+    wider.numBands = 3;
+    BandStatistics::Config coarser = config;
+    coarser.binDb = 1.0f;
+    BandStatistics::Config shifted = config;
+    shifted.minDb += 10.0f;
+    shifted.maxDb += 10.0f;
+    for (const BandStatistics::Config& other : {wider, coarser, shifted}) {
+        BandStatistics mismatched(other);
+        const std::vector<float> loud(other.numBands, 0.1f);
+        mismatched.process(loud.data());
+        [[maybe_unused]] const bool refused = !first.merge(mismatched);
+        assert(refused && first.count() == whole.count());
+    }
+
+    // A NaN envelope is still counted in some bin of the histogram
+    BandStatistics nanFrames(config);
+    const float nanFrame[2] = {std::nanf(""), 0.1f};
+    nanFrames.process(nanFrame);
+    [[maybe_unused]] const uint64_t* nanHistogram = nanFrames.histogram(0);
+    assert(std::accumulate(nanHistogram, nanHistogram + nanFrames.numBins(), uint64_t{0}) == 1);
+
+    std::cout << "  Band statistics: PASSED (median " << whole.quantileDb(1, 0.5f) << " dB)\n";
+}
+
+/// Random sequence of two-note chords, 100 ms per step
+std::vector<float> randomMelody(uint32_t seed, int numSamples, float sampleRate) {
+    std::vector<float> signal(numSamples, 0.0f);
+    const int step = static_cast<int>(0.1f * sampleRate);
+    float f1 = 0.0f, f2 = 0.0f;
+    double p1 = 0.0, p2 = 0.0;
+    for (int i = 0; i < numSamples; i++) {
+        if (i % step == 0) {
+            seed = seed * 1664525u + 1013904223u;
+            f1 = 200.0f * std::pow(2.0f, static_cast<float>(seed >> 8) / 16777216.0f * 4.0f);
+            seed = seed * 1664525u + 1013904223u;
+            f2 = 200.0f * std::pow(2.0f, static_cast<float>(seed >> 8) / 16777216.0f * 4.0f);
+        }
+        p1 += 2.0 * M_PI * f1 / sampleRate;
+        p2 += 2.0 * M_PI * f2 / sampleRate;
+        signal[i] = 0.3f * static_cast<float>(std::sin(p1) + std::sin(p2));
+    }
+    return signal;
+}
+
+std::vector<Landmark> extractLandmarks(const Analyser::Config& config, const float* signal, int numSamples) {
+    std::vector<Landmark> landmarks;
+    Analyser analyser(config);
+    analyser.setFrameCallback([&](const Analyser::Frame& frame) {
+        landmarks.insert(landmarks.end(), frame.landmarks, frame.landmarks + frame.numLandmarks);
+    });
+    analyser.process(signal, numSamples);
+    return landmarks;
+}
+
+void testFingerprint() {
+    std::cout << "Testing fingerprinting...\n";
+
+    Analyser::Config config;
+    config.sampleRate = 16000.0f;
+    config.numBands = 48;
+    config.minHz = 100.0f;
+    config.maxHz = 7000.0f;
+    config.enableFingerprint = true;
+
+    const int numSamples = 16000 * 8;
+    std::vector<float> trackA = randomMelody(1, numSamples, config.sampleRate);
+    std::vector<float> trackB = randomMelody(2, numSamples, config.sampleRate);
+
+    FingerprintIndex index;
+    std::vector<Landmark> landmarksA = extractLandmarks(config, trackA.data(), numSamples);
+    std::vector<Landmark> landmarksB = extractLandmarks(config, trackB.data(), numSamples);
+    assert(landmarksA.size() > 500);
+    index.add(7, landmarksA.data(), static_cast<int>(landmarksA.size()));
+    index.add(3, landmarksB.data(), static_cast<int>(landmarksB.size()));
+    assert(index.size() == landmarksA.size() + landmarksB.size());
+    assert(index.size() * 2 <= index.capacity());
+
+    // A 3 s clip from 4 s into track A, with noise
+    const int clipStart = 4 * 16000, clipLength = 3 * 16000;
+    std::vector<float> clip(trackA.begin() + clipStart, trackA.begin() + clipStart + clipLength);
+    uint32_t seed = 99;
+    for (float& x : clip) {
+        seed = seed * 1664525u + 1013904223u;
+        x += 0.02f * (static_cast<float>(seed >> 8) / 8388608.0f - 1.0f);
+    }
+    std::vector<Landmark> query = extractLandmarks(config, clip.data(), clipLength);
+
+    FingerprintMatch matches[4];
+    const int found = index.query(query.data(), static_cast<int>(query.size()), matches, 4);
+    [[maybe_unused]] const int expectedOffset = clipStart / (config.hopSize * config.fingerprint.frameHops);
+    assert(found > 0);
+    assert(matches[0].trackId == 7);
+    assert(std::abs(matches[0].offset - expectedOffset) <= 1);
+    for (int i = 1; i < found; i++) {
+        assert(matches[i].trackId == 7 || 4 * matches[i].votes < matches[0].votes);
+    }
+
+    // Threads share one index, each with its own vote table
+    const FingerprintIndex& shared = index;
+    std::vector<FingerprintMatch> best(4);
+    std::vector<std::thread> queries;
+    for (int t = 0; t < 4; t++) {
+        queries.emplace_back([&, t] {
+            FingerprintIndex::QueryScratch scratch;
+            for (int k = 0; k < 8; k++) shared.query(query.data(), static_cast<int>(query.size()), &best[t], 1, scratch);
+        });
+    }
+    for (auto& t : queries) t.join();
+    for (int t = 0; t < 4; t++) {
+        assert(best[t].trackId == matches[0].trackId && best[t].offset == matches[0].offset &&
+               best[t].votes == matches[0].votes);
+    }
+
+    // The on-disk format round-trips
+    std::stringstream file;
+    [[maybe_unused]] const bool saved = index.save(file);
+    assert(saved);
+    FingerprintIndex loaded;
+    [[maybe_unused]] bool ok = loaded.load(file);
+    assert(ok && loaded.size() == index.size());
+    FingerprintMatch reloaded[1];
+    [[maybe_unused]] const int refound = loaded.query(query.data(), static_cast<int>(query.size()), reloaded, 1);
+    assert(refound == 1);
+    assert(reloaded[0].trackId == matches[0].trackId && reloaded[0].votes == matches[0].votes);
+
+    std::stringstream garbage("not an index");
+    ok = loaded.load(garbage);
+    assert(!ok);
+
+    // Truncated files and absurd entry counts fail instead of allocating
+    const std::string bytes = file.str();
+    std::stringstream truncated(bytes.substr(0, bytes.size() / 2));
+    ok = loaded.load(truncated);
+    assert(!ok);
+    std::string huge = bytes.substr(0, 16);
+    std::fill(huge.begin() + 8, huge.end(), '\xff');
+    std::stringstream hugeCount(huge + bytes.substr(16));
+    ok = loaded.load(hugeCount);
+    assert(!ok);
+    std::fill(huge.begin() + 8, huge.end(), '\0');
+    huge[8] = '\x01';                                      // 2^32 entries
+    std::stringstream largeCount(huge + bytes.substr(16));
+    ok = loaded.load(largeCount);
+    assert(!ok);
+
+    std::cout << "  Fingerprint: PASSED (" << matches[0].votes << " votes at offset "
+              << matches[0].offset << ")\n";
+}
+
+void testChangeDetection() {
+    std::cout << "Testing change detection...\n";
+
+    Analyser::Config config;
+    config.sampleRate = 16000.0f;
+    config.numBands = 32;
+    config.minHz = 100.0f;
+    config.maxHz = 7000.0f;
+    config.enableChangeDetection = true;
+
+    // Program (melody plus noise) for 5 s, then dead air with faint hiss
+    const int switchAt = 5 * 16000;
+    const int numSamples = 8 * 16000;
+    std::vector<float> signal = randomMelody(5, numSamples, config.sampleRate);
+    uint32_t seed = 7;
+    for (int i = 0; i < numSamples; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        const float noise = static_cast<float>(seed >> 8) / 8388608.0f - 1.0f;
+        signal[i] = i < switchAt ? signal[i] + 0.05f * noise : 1e-4f * noise;
+    }
+
+    std::vector<ChangeEvent> events;
+    Analyser analyser(config);
+    analyser.setFrameCallback([&](const Analyser::Frame& frame) {
+        if (frame.change) events.push_back(*frame.change);
+    });
+    analyser.process(signal.data(), numSamples);
+
+    // One event, shortly after the switch, reporting a drop
+    assert(events.size() == 1);
+    assert(events[0].samplePosition >= switchAt);
+    assert(events[0].samplePosition - switchAt < 4000);
+    assert(events[0].direction == -1);
+    assert(analyser.changeDetector().numEvents() == 1);
+
+    std::cout << "  Change detection: PASSED (latency "
+              << 1000.0f * (events[0].samplePosition - switchAt) / config.sampleRate << " ms)\n";
+}
+
+void testActivityGate() {
+    std::cout << "Testing activity gate...\n";
+
+    Analyser::Config config;
+    config.sampleRate = 16000.0f;
+    config.numBands = 32;
+    config.minHz = 60.0f;
+    config.maxHz = 7000.0f;
+    config.enablePitch = true;
+    config.enableCepstrum = true;
+    config.enableTempo = true;          // Not gated
+    config.enableActivityGate = true;
+
+    // 1 s of faint hiss, 1 s of a harmonic tone over it, 1 s of hiss
+    const int second = 16000;
+    std::vector<float> signal = harmonicTone(200.0f, 1, 6, 3 * second, config.sampleRate);
+    uint32_t seed = 3;
+    for (int i = 0; i < 3 * second; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        const float noise = 1e-3f * (static_cast<float>(seed >> 8) / 8388608.0f - 1.0f);
+        signal[i] = (i >= second && i < 2 * second) ? signal[i] + noise : noise;
+    }
+
+    int64_t hops = 0, activeHops = 0, pitchFrames = 0, tempoFrames = 0;
+    bool activeInTone = true, pitchOnTone = false;
+    Analyser analyser(config);
+    analyser.setFrameCallback([&](const Analyser::Frame& frame) {
+        hops++;
+        if (frame.active) activeHops++;
+        if (frame.pitch) pitchFrames++;
+        if (frame.tempo) tempoFrames++;
+        assert(frame.active == (frame.cepstrum != nullptr));
+
+        const float t = static_cast<float>(frame.samplePosition) / second;
+        if (t > 1.1f && t < 1.9f) {
+            activeInTone = activeInTone && frame.active;
+            if (frame.pitch && frame.pitch->numCandidates > 0 &&
+                approxEqual(frame.pitch->candidates[0].f0Hz, 200.0f, 5.0f)) {
+                pitchOnTone = true;
+            }
+        }
+    });
+    analyser.process(signal.data(), 3 * second);
+
+    // Active through the tone plus hangover, idle in the hiss
+    assert(activeInTone && pitchOnTone);
+    [[maybe_unused]] const float activeSeconds = static_cast<float>(activeHops) * config.hopSize / second;
+    assert(activeSeconds > 0.95f && activeSeconds < 1.5f);
+    assert(tempoFrames == hops);
+
+    // Skip counters account for every idle hop
+    assert(analyser.skippedHops(GateCepstrum) == hops - activeHops);
+    assert(analyser.skippedHops(GatePitch) == hops - pitchFrames);
+    assert(analyser.skippedHops(GateChroma) == 0);   // Not enabled
+    assert(analyser.activity().activeFrames() == activeHops);
+
+    std::cout << "  Activity gate: PASSED (skipped " << analyser.skippedHops(GateCepstrum)
+              << " of " << hops << " hops)\n";
+}
+
+void testGateReopening() {
+    std::cout << "Testing activity gate reopening...\n";
+
+    Analyser::Config config;
+    config.sampleRate = 16000.0f;
+    config.numBands = 32;
+    config.minHz = 60.0f;
+    config.maxHz = 7000.0f;
+    config.enablePitch = true;
+    config.enableCepstrum = true;
+    config.enableActivityGate = true;
+    config.activity.hangoverSeconds = 0.0f;     // Pause right after the first tone
+
+    // Hiss, a 200 Hz tone, hiss, then a 300 Hz tone (1 s each)
+    const int second = 16000;
+    std::vector<float> low = harmonicTone(200.0f, 1, 6, 4 * second, config.sampleRate);
+    std::vector<float> high = harmonicTone(300.0f, 1, 6, 4 * second, config.sampleRate);
+    std::vector<float> signal(4 * second);
+    uint32_t seed = 3;
+    for (int i = 0; i < 4 * second; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        const float noise = 1e-3f * (static_cast<float>(seed >> 8) / 8388608.0f - 1.0f);
+        const float tone = (i >= second && i < 2 * second) ? low[i] : (i >= 3 * second ? high[i] : 0.0f);
+        signal[i] = tone + noise;
+    }
+
+    Analyser::Config ungated = config;
+    ungated.enableActivityGate = false;
+    Analyser reference(ungated);
+    std::vector<std::vector<float>> expected;
+    reference.setFrameCallback([&](const Analyser::Frame& frame) {
+        expected.emplace_back(frame.cepstrum, frame.cepstrum + frame.numCepstrumFeatures);
+    });
+    reference.process(signal.data(), 4 * second);
+
+    Analyser analyser(config);
+    const int latency = analyser.cepstrum().latency();
+    const int settle = latency + 2 * config.cepstrum.deltaWindow;
+    int64_t reopened = -1;
+    int openings = 0, pitchFrames = 0, checkedFrames = 0;
+    bool wasActive = false;
+    analyser.setFrameCallback([&](const Analyser::Frame& frame) {
+        if (frame.active && !wasActive) {
+            openings++;
+            reopened = frame.index;
+        }
+        wasActive = frame.active;
+        if (openings < 2 || !frame.active) return;
+
+        // The first frames after the pause hold nothing from before it:
+        // the cepstrum of idle hops reads as zeros, pitch as the new tone
+        const int64_t since = frame.index - reopened;
+        const int nc = config.cepstrum.numCoeffs;
+        if (since < latency) {
+            for (int j = 0; j < nc; j++) assert(frame.cepstrum[j] == 0.0f);
+        } else if (since >= settle) {
+            assert(std::equal(frame.cepstrum, frame.cepstrum + frame.numCepstrumFeatures,
+                              expected[frame.index].begin()));
+            checkedFrames++;
+        }
+        if (frame.pitch && frame.pitch->numCandidates > 0) {
+            assert(approxEqual(frame.pitch->candidates[0].f0Hz, 300.0f, 5.0f));
+            pitchFrames++;
+        }
+    });
+    analyser.process(signal.data(), 4 * second);
+    assert(openings == 2 && pitchFrames > 0 && checkedFrames > 0);
+
+    std::cout << "  Gate reopening: PASSED\n";
+}
+
+void testBlockAccumulator() {
+    std::cout << "Testing block-size normalizer...\n";
+
+    Analyser::Config config;
+    config.sampleRate = 16000.0f;
+    config.numBands = 24;
+    config.hopSize = 64;
+    const int numSamples = 8000;
+    std::vector<float> signal = harmonicTone(300.0f, 1, 4, numSamples, config.sampleRate);
+
+    Analyser reference(config);
+    std::vector<int64_t> referencePositions;
+    reference.setFrameCallback([&](const Analyser::Frame& frame) {
+        referencePositions.push_back(frame.samplePosition);
+    });
+    reference.process(signal.data(), numSamples);
+
+    // Tiny, uneven callbacks (and one large one) through a 256-sample block
+    Analyser analyser(config);
+    BlockAccumulator::Config blockConfig;
+    blockConfig.blockSize = 256;
+    BlockAccumulator accumulator(analyser, blockConfig);
+    std::vector<int64_t> positions;
+    analyser.setFrameCallback([&](const Analyser::Frame& frame) {
+        positions.push_back(frame.samplePosition);
+    });
+
+    const int sizes[] = {16, 48, 128, 32, 64, 1000, 7};
+    int pos = 0, k = 0;
+    while (pos < numSamples) {
+        const int n = std::min(sizes[k++ % 7], numSamples - pos);
+        accumulator.process(signal.data() + pos, n);
+        // Everything but the held-back samples has been analysed
+        assert(accumulator.latencySamples() < blockConfig.blockSize);
+        [[maybe_unused]] const int64_t analysed = accumulator.inputPosition() - accumulator.latencySamples();
+        assert(static_cast<int64_t>(positions.size()) == analysed / config.hopSize);
+        pos += n;
+    }
+    accumulator.flush();
+    assert(accumulator.latencySamples() == 0);
+    assert(accumulator.peakLatencySamples() <= accumulator.maxLatencySamples());
+    assert(approxEqual(accumulator.maxLatencySeconds(), 255.0f / 16000.0f, 1e-6f));
+
+    // Identical frames, timestamps and envelope
+    assert(positions == referencePositions);
+    for (int b = 0; b < config.numBands; b++) {
+        assert(analyser.envelope()[b] == reference.envelope()[b]);
+    }
+    assert(accumulator.blocks() < accumulator.calls());
+
+    std::cout << "  Block normalizer: PASSED (" << accumulator.calls() << " callbacks -> "
+              << accumulator.blocks() << " analyser calls, peak latency "
+              << accumulator.peakLatencySamples() << " samples)\n";
+}
+
+void testFrameCodec() {
+    std::cout << "Testing quantised frame encoding...\n";
+
+    // fastExp2 against exp2 across the dB range the decoder uses
+    for (float x = -40.0f; x <= 20.0f; x += 0.137f) {
+        [[maybe_unused]] const float exact = std::exp2(x);
+        assert(std::abs(fastExp2(x) - exact) <= 3e-5f * exact);
+    }
+
+    // Real frames; 100 bands is not a whole number of packing groups
+    Analyser::Config config;
+    config.sampleRate = 16000.0f;
+    config.numBands = 100;
+    config.minHz = 50.0f;
+    config.maxHz = 7000.0f;
+    config.hopSize = 64;
+    Analyser analyser(config);
+    std::vector<std::vector<float>> frames;
+    analyser.setFrameCallback([&](const Analyser::Frame& frame) {
+        frames.emplace_back(frame.envelope, frame.envelope + frame.numBands);
+    });
+    std::vector<float> signal = harmonicTone(220.0f, 1, 6, 8000, config.sampleRate);
+    const std::vector<float> second = harmonicTone(330.0f, 1, 3, 8000, config.sampleRate);
+    signal.insert(signal.end(), second.begin(), second.end());
+    analyser.process(signal.data(), static_cast<int>(signal.size()));
+    const int numBands = config.numBands;
+    const int numFrames = static_cast<int>(frames.size());
+
+    for (FrameEncoding precision : {FrameEncoding::Uint8, FrameEncoding::Uint16}) {
+        FrameEncoder::Config plainConfig;
+        plainConfig.precision = precision;
+        plainConfig.minDb = -90.0f;
+        plainConfig.maxDb = 0.0f;
+        [[maybe_unused]] const float step = 90.0f / (precision == FrameEncoding::Uint8 ? 255.0f : 65535.0f);
+
+        std::vector<std::vector<float>> plainDb;
+        [[maybe_unused]] size_t plainBytes = 0;
+        for (int variant = 0; variant < 4; variant++) {
+            FrameEncoder::Config encoderConfig = plainConfig;
+            encoderConfig.delta = (variant & 1) != 0;
+            encoderConfig.packed = (variant & 2) != 0;
+            encoderConfig.keyframeInterval = 32;
+            FrameEncoder encoder(numBands, encoderConfig);
+            FrameDecoder decoder;
+            [[maybe_unused]] const bool configured = decoder.configure(numBands, encoder.encoding());
+            assert(configured);
+
+            size_t bytes = 0;
+            std::vector<uint8_t> encoded;
+            std::vector<float> db(numBands);
+            for (int f = 0; f < numFrames; f++) {
+                encoded.clear();
+                encoder.encode(frames[f].data(), encoded);
+                assert(encoded.size() <= encoder.maxEncodedBytes());
+                assert(((encoded[0] & 1) != 0) == (!encoderConfig.delta || f % 32 == 0));
+                bytes += encoded.size();
+                [[maybe_unused]] const bool decoded = decoder.decodeDb(encoded.data(), encoded.size(), db.data());
+                assert(decoded);
+
+                if (variant == 0) {
+                    // Within half a step of the clamped level
+                    for (int b = 0; b < numBands; b++) {
+                        [[maybe_unused]] const float level =
+                            std::min(std::max(20.0f * std::log10(std::max(frames[f][b], 1e-30f)), plainConfig.minDb),
+                                     plainConfig.maxDb);
+                        assert(std::abs(db[b] - level) <= 0.5f * step + 1e-3f);
+                    }
+                    plainDb.push_back(db);
+                } else {
+                    // Delta coding and packing are lossless on top of quantisation
+                    assert(db == plainDb[f]);
+                }
+            }
+            if (variant == 0) plainBytes = bytes;
+            // Low bits of 16-bit levels are noise, so u16 gains less
+            if (variant == 3) assert(bytes < (precision == FrameEncoding::Uint8 ? plainBytes / 2 : plainBytes * 3 / 4));
+            std::cout << "  " << (precision == FrameEncoding::Uint8 ? "u8" : "u16")
+                      << (encoderConfig.delta ? " delta" : "") << (encoderConfig.packed ? " packed" : "") << ": "
+                      << static_cast<float>(bytes) / numFrames << " bytes/frame (float32: " << 4 * numBands << ")\n";
+        }
+    }
+
+    // Magnitude output, late join and corrupt input
+    FrameEncoder::Config deltaConfig;
+    deltaConfig.delta = true;
+    deltaConfig.packed = true;
+    deltaConfig.keyframeInterval = 8;
+    FrameEncoder encoder(numBands, deltaConfig);
+    std::vector<std::vector<uint8_t>> encoded(20);
+    for (int f = 0; f < 20; f++) encoder.encode(frames[100 + f].data(), encoded[f]);
+
+    FrameDecoder late(numBands, encoder.encoding());
+    std::vector<float> envelope(numBands);
+    for (int f = 3; f < 8; f++) {
+        [[maybe_unused]] const bool decoded = late.decode(encoded[f].data(), encoded[f].size(), envelope.data());
+        assert(!decoded);
+    }
+    assert(late.skippedFrames() == 5 && !late.synced());
+    for (int f = 8; f < 20; f++) {
+        [[maybe_unused]] const bool decoded = late.decode(encoded[f].data(), encoded[f].size(), envelope.data());
+        assert(decoded);
+    }
+    for (int b = 0; b < numBands; b++) {
+        // 8-bit steps over 100 dB: within 0.2 dB, about 2.3 %
+        if (frames[119][b] > 1e-5f) assert(std::abs(envelope[b] / frames[119][b] - 1.0f) < 0.03f);
+    }
+
+    std::vector<uint8_t> bad = encoded[8];
+    [[maybe_unused]] bool decoded = late.decode(bad.data(), bad.size() - 1, envelope.data());
+    assert(!decoded);
+    bad[9] = 9;     // Packing width above 8 bits
+    decoded = late.decode(bad.data(), bad.size(), envelope.data());
+    assert(!decoded);
+    [[maybe_unused]] const bool configured = late.configure(numBands, 0x0403);
+    assert(!configured);
+
+    // Group widths come from the float exponent: check them at every bit count
+    assert(codec::bitWidth(0) == 0 && codec::bitWidth(1) == 1 && codec::bitWidth(65535) == 16);
+    for (int k = 1; k < 24; k++) {
+        assert(codec::bitWidth(1u << k) == k + 1 && codec::bitWidth((1u << k) - 1) == k);
+    }
+
+    std::cout << "  Frame codec: PASSED\n";
+}
+
+int main() {
+    std::cout << "Cortix Feature Test Suite\n";
+    std::cout << "=========================\n\n";
+
+    testCorrelogramPitch();
+    testChroma();
+    testCepstrum();
+    testSpectralDescriptors();
+    testTempo();
+    testPartialTracking();
+    testNoiseFloor();
+    testLateralInhibition();
+    testBandStatistics();
+    testFingerprint();
+    testChangeDetection();
+    testActivityGate();
+    testGateReopening();
+    testBlockAccumulator();
+    testFrameCodec();
+
+    std::cout << "\nAll tests PASSED!\n";
+    return 0;
+}
@@ -0,0 +1,331 @@
+/*
+ * Cortix - PCM Input and Frame Output Tests
+ */
+
+#include <cortix/pcm.h>
+#include <cortix/framewriter.h>
+#include <iostream>
+#include <cmath>
+#include <cassert>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <string>
+
+using namespace cortix;
+
+Analyser::Config pipeDesign() {
+    Analyser::Config config;
+    config.sampleRate = 16000.0f;
+    config.numBands = 16;
+    config.minHz = 50.0f;
+    config.maxHz = 7000.0f;
+    config.hopSize = 64;
+    return config;
+}
+
+std::vector<float> tone(int numSamples) {
+    std::vector<float> signal(numSamples);
+    for (int i = 0; i < numSamples; i++) {
+        signal[i] = 0.5f * std::sin(2.0f * static_cast<float>(M_PI) * 500.0f * i / 16000.0f);
+    }
+    return signal;
+}
+
+/// Read a pipe to EOF, optionally pausing between reads
+std::vector<uint8_t> drainPipe(int fd, int pauseMs) {
+    std::vector<uint8_t> all;
+    uint8_t buffer[4096];
+    for (;;) {
+        const ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        all.insert(all.end(), buffer, buffer + n);
+        if (pauseMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(pauseMs));
+    }
+    return all;
+}
+
+void testPcmDecoder() {
+    std::cout << "Testing PCM decoding...\n";
+
+    // Stereo s16: (16384, -16384) -> 0, (32767, 32767) -> ~1, fed in odd pieces
+    const uint8_t stereo[] = {0x00, 0x40, 0x00, 0xc0, 0xff, 0x7f, 0xff, 0x7f, 0x00, 0x20, 0x00, 0x20};
+    PcmDecoder decoder(PcmFormat::S16, 2);
+    assert(decoder.frameBytes() == 4);
+    float out[8];
+    [[maybe_unused]] size_t n = decoder.decode(stereo, 3, out);
+    assert(n == 0 && decoder.pendingBytes() == 3);
+    n = decoder.decode(stereo + 3, 6, out);
+    assert(n == 2 && decoder.pendingBytes() == 1);
+    assert(out[0] == 0.0f && std::fabs(out[1] - 32767.0f / 32768.0f) < 1e-6f);
+    n = decoder.decode(stereo + 9, 3, out);
+    assert(n == 1 && out[0] == 0.25f && decoder.pendingBytes() == 0);
+
+    // Mono f32 passes values through
+    const float values[3] = {0.5f, -0.25f, 1.0f};
+    PcmDecoder floats(PcmFormat::F32, 1);
+    n = floats.decode(reinterpret_cast<const uint8_t*>(values), sizeof(values), out);
+    assert(n == 3 && out[0] == 0.5f && out[1] == -0.25f && out[2] == 1.0f);
+
+    PcmFormat format;
+    [[maybe_unused]] const bool known = parsePcmFormat("f32le", format);
+    assert(known && format == PcmFormat::F32);
+    [[maybe_unused]] const bool unknown = !parsePcmFormat("u8", format);
+    assert(unknown);
+
+    std::cout << "  PCM: PASSED\n";
+}
+
+void testSlowConsumer() {
+    std::cout << "Testing frame output to a slow consumer...\n";
+
+    int fds[2];
+    [[maybe_unused]] const int piped = ::pipe(fds);
+    assert(piped == 0);
+    std::vector<uint8_t> received;
+    std::thread consumer([&] { received = drainPipe(fds[0], 10); });
+
+    Analyser analyser(pipeDesign());
+    FrameWriter::Config config;
+    config.bufferBytes = 4096;
+    config.maxPendingBuffers = 2;
+    std::vector<std::vector<float>> expected;
+    {
+        FrameWriter writer(fds[1], config);
+        writer.begin(analyser);
+        analyser.setFrameCallback([&](const Analyser::Frame& frame) {
+            [[maybe_unused]] const bool written = writer.write(frame);
+            assert(written);
+            expected.emplace_back(frame.envelope, frame.envelope + frame.numBands);
+        });
+        const std::vector<float> signal = tone(64 * 2000);
+        analyser.process(signal.data(), static_cast<int>(signal.size()));
+        [[maybe_unused]] const bool finished = writer.finish();
+        assert(finished);
+
+        const FrameWriter::Stats stats = writer.stats();
+        assert(stats.frames == 2000);
+        assert(stats.peakPendingBuffers == 2 && stats.stallSeconds > 0.0);
+        std::cout << "  " << stats.bytesWritten << " bytes in " << stats.writeCalls << " writes, producer stalled "
+                  << stats.stallSeconds << " s\n";
+    }
+    ::close(fds[1]);
+    consumer.join();
+    ::close(fds[0]);
+
+    // A StreamInfo, then every frame in order
+    protocol::MessageParser parser;
+    parser.append(received.data(), received.size());
+    protocol::Message m;
+    [[maybe_unused]] bool parsed = parser.next(m);
+    assert(parsed && m.type == protocol::MessageType::StreamInfo);
+    protocol::PayloadReader info(m);
+    [[maybe_unused]] const uint32_t stream = info.u32();
+    [[maybe_unused]] const float sampleRate = info.f32();
+    [[maybe_unused]] const int numBands = info.u16();
+    [[maybe_unused]] const int hopSize = info.u16();
+    assert(stream == 0 && sampleRate == 16000.0f && numBands == 16 && hopSize == 64);
+    float centers[16];
+    [[maybe_unused]] const bool haveCenters = info.floats(centers, 16);
+    assert(haveCenters && centers[0] == analyser.centerHz(0));
+    for (int i = 0; i < 2000; i++) {
+        parsed = parser.next(m);
+        assert(parsed && m.type == protocol::MessageType::Frame);
+        protocol::PayloadReader in(m);
+        in.u32();
+        [[maybe_unused]] const int64_t index = in.i64();
+        [[maybe_unused]] const int64_t position = in.i64();
+        assert(index == i && position == (i + 1) * 64);
+        [[maybe_unused]] const int frameBands = in.u16();
+        [[maybe_unused]] const uint16_t encoding = in.u16();
+        assert(frameBands == 16 && encoding == 0);
+        float envelope[16];
+        [[maybe_unused]] const bool haveEnvelope = in.floats(envelope, 16);
+        assert(haveEnvelope && std::equal(envelope, envelope + 16, expected[i].begin()));
+    }
+    parsed = parser.next(m);
+    assert(!parsed && parser.pending() == 0);
+
+    std::cout << "  Slow consumer: PASSED\n";
+}
+
+void testClosedPipe() {
+    std::cout << "Testing a closed downstream pipe...\n";
+
+    std::signal(SIGPIPE, SIG_IGN);
+    int fds[2];
+    [[maybe_unused]] const int piped = ::pipe(fds);
+    assert(piped == 0);
+    ::close(fds[0]);
+
+    Analyser analyser(pipeDesign());
+    FrameWriter::Config config;
+    config.format = FrameWriter::Format::Raw;
+    config.bufferBytes = 1024;
+    FrameWriter writer(fds[1], config);
+    analyser.setFrameCallback([&](const Analyser::Frame& frame) { writer.write(frame); });
+    const std::vector<float> signal = tone(64 * 100);
+    analyser.process(signal.data(), static_cast<int>(signal.size()));
+    [[maybe_unused]] const bool finished = writer.finish();
+    assert(!finished && writer.failed());
+    ::close(fds[1]);
+
+    std::cout << "  Closed pipe: PASSED\n";
+}
+
+void testQuantisedOutput() {
+    std::cout << "Testing quantised frame output...\n";
+
+    int fds[2];
+    [[maybe_unused]] const int piped = ::pipe(fds);
+    assert(piped == 0);
+    std::vector<uint8_t> received;
+    std::thread consumer([&] { received = drainPipe(fds[0], 0); });
+
+    Analyser analyser(pipeDesign());
+    FrameWriter::Config config;
+    config.quantize = true;
+    config.encoding.minDb = -80.0f;
+    config.encoding.maxDb = 0.0f;
+    config.encoding.delta = true;
+    config.encoding.keyframeInterval = 16;
+    config.encoding.packed = true;
+    std::vector<std::vector<float>> expected;
+    {
+        FrameWriter writer(fds[1], config);
+        writer.begin(analyser);
+        analyser.setFrameCallback([&](const Analyser::Frame& frame) {
+            [[maybe_unused]] const bool written = writer.write(frame);
+            assert(written);
+            expected.emplace_back(frame.envelope, frame.envelope + frame.numBands);
+        });
+        const std::vector<float> signal = tone(64 * 500);
+        analyser.process(signal.data(), static_cast<int>(signal.size()));
+        [[maybe_unused]] const bool finished = writer.finish();
+        assert(finished);
+    }
+    ::close(fds[1]);
+    consumer.join();
+    ::close(fds[0]);
+
+    protocol::MessageParser parser;
+    parser.append(received.data(), received.size());
+    protocol::Message m;
+    [[maybe_unused]] bool parsed = parser.next(m);
+    assert(parsed && m.type == protocol::MessageType::StreamInfo);
+    FrameDecoder decoder;
+    std::vector<float> db(16);
+    size_t frameBytes = 0;
+    for (int i = 0; i < 500; i++) {
+        parsed = parser.next(m);
+        assert(parsed && m.type == protocol::MessageType::Frame);
+        frameBytes += protocol::kHeaderBytes + m.length;
+        protocol::PayloadReader in(m);
+        in.u32();
+        [[maybe_unused]] const int64_t index = in.i64();
+        [[maybe_unused]] const int64_t position = in.i64();
+        assert(index == i && position == (i + 1) * 64);
+        const int numBands = in.u16();
+        const uint16_t encoding = in.u16();
+        assert(numBands == 16 && encoding == (1 | kEncodingDelta | kEncodingPacked));
+        if (i == 0) {
+            [[maybe_unused]] const bool configured = decoder.configure(numBands, encoding);
+            assert(configured);
+        }
+        [[maybe_unused]] const bool decoded = decoder.decodeDb(in.position(), in.remaining(), db.data());
+        assert(decoded);
+        for (int b = 0; b < 16; b++) {
+            [[maybe_unused]] const float level = std::max(20.0f * std::log10(expected[i][b]), -80.0f);
+            assert(std::fabs(db[b] - level) < 0.5f * 80.0f / 255.0f + 1e-3f);
+        }
+    }
+    parsed = parser.next(m);
+    assert(!parsed && parser.pending() == 0);
+
+    // Float32 frames of 16 bands are 8 + 28 + 64 bytes
+    assert(frameBytes < 500 * 100 / 2);
+    std::cout << "  Quantised output: PASSED (" << static_cast<float>(frameBytes) / 500
+              << " bytes/frame, float32: 100)\n";
+}
+
+void testCommandLine() {
+    std::cout << "Testing the cortix command in a pipeline...\n";
+
+    // 1 s of a stereo s16 tone through the CLI, raw output
+    const std::string input = "/tmp/cortix_cli_in_" + std::to_string(::getpid());
+    const std::string output = "/tmp/cortix_cli_out_" + std::to_string(::getpid());
+    {
+        FILE* f = std::fopen(input.c_str(), "wb");
+        assert(f);
+        const std::vector<float> signal = tone(16000);
+        for (float x : signal) {
+            const int16_t v = static_cast<int16_t>(x * 32767.0f);
+            const uint8_t frame[4] = {static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8),
+                                      static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8)};
+            std::fwrite(frame, 1, 4, f);
+        }
+        std::fclose(f);
+    }
+    const std::string command = std::string("cat ") + input + " | " + CORTIX_CLI_PATH +
+        " --rate 16000 --channels 2 --bands 16 --hop 64 --min-hz 50 --max-hz 7000 --output raw > " + output;
+    [[maybe_unused]] int status = std::system(command.c_str());
+    assert(status == 0);
+
+    FILE* f = std::fopen(output.c_str(), "rb");
+    assert(f);
+    std::vector<float> frames(16000 / 64 * 16 + 1);
+    const size_t count = std::fread(frames.data(), sizeof(float), frames.size(), f);
+    std::fclose(f);
+    assert(count == static_cast<size_t>(16000 / 64 * 16));
+
+    // Band energy peaks near 500 Hz in the last frame
+    Analyser reference(pipeDesign());
+    int peak = 0;
+    for (int b = 1; b < 16; b++) {
+        if (frames[count - 16 + b] > frames[count - 16 + peak]) peak = b;
+    }
+    assert(std::fabs(reference.centerHz(peak) - 500.0f) < 200.0f);
+
+    // Quantised messages: same frame count, far fewer bytes than float32 messages
+    const std::string encoded = std::string("cat ") + input + " | " + CORTIX_CLI_PATH +
+        " --rate 16000 --channels 2 --bands 16 --hop 64 --min-hz 50 --max-hz 7000"
+        " --encoding u8 --delta --pack > " + output;
+    status = std::system(encoded.c_str());
+    assert(status == 0);
+    f = std::fopen(output.c_str(), "rb");
+    assert(f);
+    std::vector<uint8_t> bytes(1 << 20);
+    bytes.resize(std::fread(bytes.data(), 1, bytes.size(), f));
+    std::fclose(f);
+    protocol::MessageParser parser;
+    parser.append(bytes.data(), bytes.size());
+    protocol::Message m;
+    int numFrames = 0;
+    while (parser.next(m)) numFrames += m.type == protocol::MessageType::Frame;
+    assert(numFrames == 16000 / 64 && parser.pending() == 0);
+    assert(bytes.size() < static_cast<size_t>(numFrames) * (protocol::kHeaderBytes + 28 + 16 * 4) / 2);
+    status = std::system((std::string(CORTIX_CLI_PATH) + " --encoding u8 --output raw < /dev/null 2> /dev/null").c_str());
+    assert(status != 0);
+    status = std::system((std::string(CORTIX_CLI_PATH) + " --channels 128 < /dev/null 2> /dev/null").c_str());
+    assert(status != 0);
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+
+    std::cout << "  Command line: PASSED\n";
+}
+
+int main() {
+    std::cout << "Cortix I/O Test Suite\n";
+    std::cout << "=====================\n\n";
+
+    testPcmDecoder();
+    testSlowConsumer();
+    testClosedPipe();
+    testQuantisedOutput();
+    testCommandLine();
+
+    std::cout << "\nAll tests PASSED!\n";
+    return 0;
+}
@@ -0,0 +1,404 @@
+/*
+ * Cortix - Multi-Stream Pool Tests
+ */
+
+#include <cortix/pool.h>
+#include <cortix/batch.h>
+#include <iostream>
+#include <cmath>
+#include <cassert>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+using namespace cortix;
+
+/// Deterministic test signal, different for every stream
+std::vector<float> streamSignal(int stream, int numSamples) {
+    std::vector<float> signal(numSamples);
+    const float hz = 100.0f + 37.0f * stream;
+    for (int i = 0; i < numSamples; i++) {
+        signal[i] = 0.5f * std::sin(2.0f * M_PI * hz * i / 16000.0f);
+    }
+    return signal;
+}
+
+Analyser::Config smallDesign() {
+    Analyser::Config config;
+    config.sampleRate = 16000.0f;
+    config.numBands = 24;
+    config.minHz = 50.0f;
+    config.maxHz = 7000.0f;
+    config.hopSize = 64;
+    return config;
+}
+
+void testOrderingAndResults() {
+    std::cout << "Testing per-stream ordering...\n";
+
+    AnalyserPool::Config poolConfig;
+    poolConfig.numThreads = 4;
+    poolConfig.maxQueuedSamples = 1 << 20;
+    AnalyserPool pool(poolConfig);
+
+    const Analyser::Config design = smallDesign();
+    const AnalyserPool::DesignId designA = pool.addDesign(design);
+    Analyser::Config other = design;
+    other.numBands = 32;
+    const AnalyserPool::DesignId designB = pool.addDesign(other);
+
+    const int numStreams = 48;
+    const int block = 160;
+    const int numBlocks = 40;
+    std::vector<AnalyserPool::StreamId> ids(numStreams);
+    std::vector<std::vector<int64_t>> frameIndices(numStreams);
+    std::vector<std::atomic<int>> inCallback(numStreams);
+
+    for (int s = 0; s < numStreams; s++) {
+        ids[s] = pool.addStream(s % 3 == 0 ? designB : designA);
+        assert(ids[s] >= 0);
+        inCallback[s] = 0;
+        pool.setFrameCallback(ids[s], [&, s](const Analyser::Frame& frame) {
+            // Never two callbacks of one stream at once
+            [[maybe_unused]] const int concurrent = inCallback[s].fetch_add(1);
+            assert(concurrent == 0);
+            frameIndices[s].push_back(frame.index);
+            inCallback[s].fetch_sub(1);
+        });
+    }
+
+    std::vector<std::vector<float>> signals(numStreams);
+    for (int s = 0; s < numStreams; s++) {
+        signals[s] = streamSignal(s, numBlocks * block);
+    }
+
+    // Four producers, each feeding a quarter of the streams
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; p++) {
+        producers.emplace_back([&, p] {
+            for (int b = 0; b < numBlocks; b++) {
+                for (int s = p; s < numStreams; s += 4) {
+                    [[maybe_unused]] const bool accepted = pool.submit(ids[s], signals[s].data() + b * block, block);
+                    assert(accepted);
+                }
+            }
+        });
+    }
+    for (auto& t : producers) t.join();
+    pool.drain();
+
+    // Frames arrive in order, and the envelope matches a standalone analyser
+    const int64_t expectedFrames = numBlocks * block / design.hopSize;
+    for (int s = 0; s < numStreams; s++) {
+        assert(static_cast<int64_t>(frameIndices[s].size()) == expectedFrames);
+        for (int64_t i = 0; i < expectedFrames; i++) {
+            assert(frameIndices[s][i] == i);
+        }
+
+        Analyser reference(s % 3 == 0 ? other : design);
+        reference.process(signals[s].data(), numBlocks * block);
+        [[maybe_unused]] const auto& pooled = pool.analyser(ids[s]).envelope();
+        for (int b = 0; b < reference.numBands(); b++) {
+            assert(pooled[b] == reference.envelope()[b]);
+        }
+
+        [[maybe_unused]] const AnalyserPool::StreamStats stats = pool.streamStats(ids[s]);
+        assert(stats.processedBlocks == numBlocks);
+        assert(stats.queuedSamples == 0);
+    }
+
+    AnalyserPool::PoolStats stats = pool.stats();
+    assert(stats.processedBlocks == numStreams * numBlocks);
+    assert(stats.batchedStreams >= stats.batches);
+
+    std::cout << "  Ordering: PASSED (" << stats.batches << " batches, "
+              << static_cast<float>(stats.batchedStreams) / stats.batches << " streams/batch, "
+              << stats.steals << " steals)\n";
+}
+
+void testBackpressure() {
+    std::cout << "Testing backpressure...\n";
+
+    AnalyserPool::Config poolConfig;
+    poolConfig.numThreads = 1;
+    poolConfig.maxQueuedSamples = 1000;
+    AnalyserPool pool(poolConfig);
+    const AnalyserPool::StreamId id = pool.addStream(pool.addDesign(smallDesign()));
+
+    // Hold the only worker inside the first frame callback
+    std::atomic<bool> release{false};
+    std::atomic<bool> entered{false};
+    pool.setFrameCallback(id, [&](const Analyser::Frame&) {
+        entered = true;
+        while (!release) std::this_thread::yield();
+    });
+
+    std::vector<float> block(200, 0.1f);
+    [[maybe_unused]] const bool queued = pool.submit(id, block.data(), 200);
+    assert(queued);
+    while (!entered) std::this_thread::yield();
+
+    int accepted = 0, rejected = 0;
+    for (int i = 0; i < 10; i++) {
+        if (pool.submit(id, block.data(), 200)) accepted++;
+        else rejected++;
+    }
+    // The block in flight still counts as queued: 200 + 4 * 200 = 1000
+    assert(accepted == 4 && rejected == 6);
+
+    AnalyserPool::StreamStats stats = pool.streamStats(id);
+    assert(stats.rejectedBlocks == 6);
+    assert(stats.queuedSamples == 1000);
+    assert(stats.peakQueuedSamples == 1000);
+
+    release = true;
+    pool.drain();
+    stats = pool.streamStats(id);
+    assert(stats.queuedSamples == 0);
+    assert(stats.processedBlocks == 5);
+    assert(pool.stats().rejectedBlocks == 6);
+
+    // A removed stream no longer accepts blocks
+    pool.removeStream(id);
+    [[maybe_unused]] const bool queuedRemoved = pool.submit(id, block.data(), 200);
+    assert(!queuedRemoved);
+
+    // tryRemoveStream() does not wait for a running block: the stream is
+    // closed at once but only freed once the callback returns
+    const AnalyserPool::StreamId busy = pool.addStream(pool.addDesign(smallDesign()));
+    release = false;
+    entered = false;
+    pool.setFrameCallback(busy, [&](const Analyser::Frame&) {
+        entered = true;
+        while (!release) std::this_thread::yield();
+    });
+    [[maybe_unused]] const bool queuedBusy = pool.submit(busy, block.data(), 200);
+    [[maybe_unused]] const bool queuedBehind = pool.submit(busy, block.data(), 200);
+    assert(queuedBusy && queuedBehind);
+    while (!entered) std::this_thread::yield();
+    [[maybe_unused]] const bool removedEarly = pool.tryRemoveStream(busy);
+    assert(!removedEarly);
+    [[maybe_unused]] const bool queuedClosed = pool.submit(busy, block.data(), 200);
+    assert(!queuedClosed);
+    assert(pool.streamStats(busy).queuedSamples == 200);   // The queued block was dropped
+    release = true;
+    while (!pool.tryRemoveStream(busy)) std::this_thread::yield();
+    pool.drain();
+
+    std::cout << "  Backpressure: PASSED\n";
+}
+
+void testPlacement() {
+    std::cout << "Testing topology-aware placement...\n";
+
+    assert((CpuTopology::parseCpuList("0-3,8-9") == std::vector<int>{0, 1, 2, 3, 8, 9}));
+    assert(CpuTopology::parseCpuList("5") == std::vector<int>{5});
+    assert(CpuTopology::parseSize("2048K") == 2048 * 1024);
+    assert(CpuTopology::parseSize("1M") == 1 << 20);
+
+    const CpuTopology local = CpuTopology::detect();
+    assert(!local.nodes.empty() && local.numCpus() >= 1 && local.l2Bytes > 0);
+
+    // Two fake nodes: workers alternate between them
+    CpuTopology topology;
+    topology.nodes.resize(2);
+    topology.nodes[0].cpus = {0, 1};
+    topology.nodes[1].id = 1;
+    topology.nodes[1].cpus = {2, 3};
+    assert((topology.interleavedCpus() == std::vector<int>{0, 2, 1, 3}));
+    assert(topology.nodeOfCpu(3) == 1);
+
+    const Analyser::Config design = smallDesign();
+    const int64_t stateBytes = static_cast<int64_t>(Analyser(design).stateBytes());
+
+    AnalyserPool::Config poolConfig;
+    poolConfig.numThreads = 4;
+    poolConfig.tileBytes = 3 * stateBytes;
+    AnalyserPool pool(poolConfig, topology);
+    const AnalyserPool::DesignId id = pool.addDesign(design);
+    assert(pool.streamsPerTile(id) == 3);
+
+    const int numStreams = 12;
+    std::vector<AnalyserPool::StreamId> ids(numStreams);
+    for (int s = 0; s < numStreams; s++) ids[s] = pool.addStream(id);
+
+    // Three streams per tile, tiles dealt to workers in turn. The node is
+    // where the kernel put the state: on this machine a fake node may
+    // have no memory, so only count the streams that missed their home.
+    int64_t misplaced = 0;
+    for (int s = 0; s < numStreams; s++) {
+        const AnalyserPool::StreamStats stats = pool.streamStats(ids[s]);
+        assert(stats.tile == s / 3);
+        assert(stats.homeWorker == (s / 3) % 4);
+        assert(stats.node == 0 || stats.node == 1);
+        if (stats.node != stats.homeWorker % 2) misplaced++;
+    }
+    assert(pool.placement().misplacedStreams == misplaced);
+
+    std::vector<float> signal = streamSignal(0, 1600);
+    for (int b = 0; b < 10; b++) {
+        for (int s = 0; s < numStreams; s++) {
+            [[maybe_unused]] const bool queued = pool.submit(ids[s], signal.data() + b * 160, 160);
+            assert(queued);
+        }
+    }
+    pool.drain();
+
+    AnalyserPool::PlacementStats placement = pool.placement();
+    assert(placement.numNodes == 2 && placement.numTiles == 4);
+    assert(placement.workers.size() == 4);
+    for (int w = 0; w < 4; w++) {
+        assert(placement.workers[w].node == w % 2);
+        assert(!placement.workers[w].pinned);
+    }
+    assert(placement.localRuns + placement.remoteRuns == pool.stats().batchedStreams);
+
+    // Removing a stream drops it from the count
+    [[maybe_unused]] const bool wasMisplaced = pool.streamStats(ids[3]).node != 1;
+    pool.removeStream(ids[3]);
+    assert(pool.placement().misplacedStreams == misplaced - (wasMisplaced ? 1 : 0));
+
+    std::cout << "  Placement: PASSED (" << placement.localRuns << " local, "
+              << placement.remoteRuns << " remote runs, " << misplaced << " misplaced streams; this machine has "
+              << local.nodes.size() << " node(s), " << local.l2Bytes / 1024 << " KiB L2)\n";
+}
+
+void testPriorities() {
+    std::cout << "Testing real-time priority and deadlines...\n";
+
+    AnalyserPool::Config poolConfig;
+    poolConfig.numThreads = 1;
+    poolConfig.maxQueuedSamples = 1 << 20;
+    AnalyserPool pool(poolConfig);
+    const AnalyserPool::DesignId design = pool.addDesign(smallDesign());
+    const AnalyserPool::StreamId offline = pool.addStream(design);
+    const AnalyserPool::StreamId live = pool.addStream(design, AnalyserPool::Priority::RealTime);
+    assert(pool.streamStats(live).priority == AnalyserPool::Priority::RealTime);
+
+    // While the first offline block runs, a real-time block arrives; it must
+    // run at the next block boundary, before the rest of the offline backlog
+    const int block = 640;
+    [[maybe_unused]] const int framesPerBlock = block / smallDesign().hopSize;
+    std::vector<float> signal = streamSignal(1, block);
+    std::atomic<int> offlineFrames{0};
+    std::atomic<int> offlineFramesAtLive{-1};
+    pool.setFrameCallback(offline, [&](const Analyser::Frame&) {
+        if (offlineFrames.fetch_add(1) == 0) {
+            // Already late: counts as a miss
+            [[maybe_unused]] const bool queued = pool.submit(live, signal.data(), block,
+                                                             AnalyserPool::Clock::now() - std::chrono::milliseconds(1));
+            assert(queued);
+        }
+    });
+    pool.setFrameCallback(live, [&](const Analyser::Frame& frame) {
+        if (frame.index == 0) offlineFramesAtLive = offlineFrames.load();
+    });
+
+    const int numBlocks = 50;
+    for (int b = 0; b < numBlocks; b++) {
+        [[maybe_unused]] const bool queued = pool.submit(offline, signal.data(), block);
+        assert(queued);
+    }
+    pool.drain();
+    assert(offlineFramesAtLive == framesPerBlock);
+    assert(offlineFrames == numBlocks * framesPerBlock);
+
+    // A real-time block with the default 10 ms budget on an idle pool is on time
+    [[maybe_unused]] const bool queued = pool.submit(live, signal.data(), block);
+    assert(queued);
+    pool.drain();
+
+    AnalyserPool::ClassStats realTime = pool.classStats(AnalyserPool::Priority::RealTime);
+    AnalyserPool::ClassStats background = pool.classStats(AnalyserPool::Priority::Offline);
+    assert(realTime.processedBlocks == 2);
+    assert(realTime.deadlineMisses >= 1);
+    assert(pool.streamStats(live).deadlineMisses == realTime.deadlineMisses);
+    assert(background.processedBlocks == numBlocks);
+    assert(background.deadlineMisses == 0);     // No offline budget
+    assert(background.preemptions >= 1);
+
+    int64_t histogramTotal = 0;
+    for (int64_t c : background.latencyHistogram) histogramTotal += c;
+    assert(histogramTotal == numBlocks);
+    assert(background.latencyQuantileUs(0.5f) <= background.latencyQuantileUs(1.0f));
+    assert(background.latencyQuantileUs(1.0f) >= background.maxLatencyUs);
+
+    std::cout << "  Priorities: PASSED (real-time p100 < " << realTime.latencyQuantileUs(1.0f)
+              << " us, offline p50 < " << background.latencyQuantileUs(0.5f) << " us, "
+              << background.preemptions << " preemptions)\n";
+}
+
+void testRaggedBatch() {
+    std::cout << "Testing ragged batch processing...\n";
+
+    const Analyser::Config design = smallDesign();
+    Analyser::Config other = design;
+    other.numBands = 32;
+
+    const int numStreams = 6;
+    const int numSamples = 3000;
+    std::vector<std::unique_ptr<Analyser>> streams;
+    std::vector<std::vector<float>> signals;
+    std::vector<int64_t> frames(numStreams, 0);
+    for (int s = 0; s < numStreams; s++) {
+        streams.push_back(std::make_unique<Analyser>(s % 2 ? other : design));
+        signals.push_back(streamSignal(s, numSamples));
+        streams[s]->setFrameCallback([&frames, s]([[maybe_unused]] const Analyser::Frame& frame) {
+            assert(frame.index == frames[s]);
+            frames[s]++;
+        });
+    }
+
+    // Uneven packets, several per stream per batch, streams interleaved
+    BatchProcessor batch;
+    std::vector<int> position(numStreams, 0);
+    uint32_t seed = 12345;
+    int batches = 0;
+    bool done = false;
+    while (!done) {
+        std::vector<StreamPacket> packets;
+        for (int k = 0; k < 20; k++) {
+            seed = seed * 1664525u + 1013904223u;
+            const int s = static_cast<int>((seed >> 8) % numStreams);
+            const int len = std::min(1 + static_cast<int>((seed >> 16) % 97), numSamples - position[s]);
+            if (len <= 0) continue;
+            packets.push_back(StreamPacket{streams[s].get(), signals[s].data() + position[s], len});
+            position[s] += len;
+        }
+        batch.process(packets);
+        assert(batch.stats().packets == static_cast<int>(packets.size()));
+        assert(batch.stats().streams <= numStreams && batch.stats().designs <= 2);
+        batches++;
+
+        done = true;
+        for (int s = 0; s < numStreams; s++) done = done && position[s] == numSamples;
+    }
+
+    // Same results as one call per stream
+    for (int s = 0; s < numStreams; s++) {
+        Analyser reference(s % 2 ? other : design);
+        reference.process(signals[s].data(), numSamples);
+        assert(frames[s] == numSamples / design.hopSize);
+        for (int b = 0; b < reference.numBands(); b++) {
+            assert(std::fabs(streams[s]->envelope()[b] - reference.envelope()[b])
+                   <= 1e-6f * (1.0f + reference.envelope()[b]));
+        }
+    }
+
+    std::cout << "  Ragged batch: PASSED (" << batches << " batches)\n";
+}
+
+int main() {
+    std::cout << "Cortix Pool Test Suite\n";
+    std::cout << "======================\n\n";
+
+    testOrderingAndResults();
+    testBackpressure();
+    testPlacement();
+    testPriorities();
+    testRaggedBatch();
+
+    std::cout << "\nAll tests PASSED!\n";
+    return 0;
+}
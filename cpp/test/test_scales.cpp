@@ -6,6 +6,7 @@
 #include <iostream>
 #include <cmath>
 #include <cassert>
+#include <algorithm>
 
 using namespace cortix;
 
@@ -20,7 +21,7 @@ void testBarkScale() {
     float testFreqs[] = {100, 500, 1000, 4000, 10000};
     for (float hz : testFreqs) {
         float bark = hzToBark(hz);
-        float backHz = barkToHz(bark);
+        [[maybe_unused]] float backHz = barkToHz(bark);
         assert(approxEqual(hz, backHz, hz * 0.01f));
     }
 
@@ -38,7 +39,7 @@ void testErbScale() {
     float testFreqs[] = {100, 500, 1000, 4000, 10000};
     for (float hz : testFreqs) {
         float erb = hzToErb(hz);
-        float backHz = erbToHz(erb);
+        [[maybe_unused]] float backHz = erbToHz(erb);
         assert(approxEqual(hz, backHz, hz * 0.01f));
     }
 
@@ -56,7 +57,7 @@ void testMelScale() {
     float testFreqs[] = {100, 500, 1000, 4000, 10000};
     for (float hz : testFreqs) {
         float mel = hzToMel(hz);
-        float backHz = melToHz(mel);
+        [[maybe_unused]] float backHz = melToHz(mel);
         assert(approxEqual(hz, backHz, hz * 0.01f));
     }
 
@@ -127,6 +128,195 @@ void testGammatoneFilterbank() {
     std::cout << "  Gammatone filterbank: PASSED (peak at " << peakFreq << " Hz)\n";
 }
 
+void testHairCellAdaptation() {
+    std::cout << "Testing hair cell and adaptation stages...\n";
+
+    GammatoneFilterbank::Config config;
+    config.numBands = 24;
+    config.sampleRate = 48000.0f;
+    config.smoothingMs = 2.0f;
+    config.innerHairCell = true;
+    config.adaptationLoops = 5;
+
+    GammatoneFilterbank fb(config);
+    assert(fb.neural().size() == 24);
+
+    // 100 ms silence, then a 1 kHz tone burst
+    const int numSamples = 48000;
+    const int onset = 4800;
+    std::vector<float> signal(numSamples, 0.0f);
+    for (int i = onset; i < numSamples; i++) {
+        signal[i] = 0.3f * std::sin(2.0f * M_PI * 1000.0f * i / 48000.0f);
+    }
+
+    int band = 0;
+    for (int b = 0; b < fb.numBands(); b++) {
+        if (std::abs(fb.centerHz(b) - 1000.0f) < std::abs(fb.centerHz(band) - 1000.0f)) band = b;
+    }
+
+    // Adaptation: strong onset response that decays towards a lower steady state
+    float onsetPeak = 0.0f;
+    for (int i = 0; i < numSamples; i += 64) {
+        fb.process(signal.data() + i, 64);
+        if (i >= onset && i < onset + 2400) onsetPeak = std::max(onsetPeak, fb.envelope()[band]);
+    }
+    const float steady = fb.envelope()[band];
+    assert(steady > 0.0f);
+    assert(onsetPeak > 2.0f * steady);
+
+    std::cout << "  Hair cell / adaptation: PASSED (onset/steady " << onsetPeak / steady << ")\n";
+}
+
+void testBandMask() {
+    std::cout << "Testing band mask...\n";
+
+    GammatoneFilterbank::Config config;
+    config.numBands = 40;
+    config.minHz = 50.0f;
+    config.maxHz = 8000.0f;
+
+    GammatoneFilterbank full(config);
+    GammatoneFilterbank masked(config);
+    masked.setActiveRange(50.0f, 300.0f);
+    assert(masked.numActiveBands() > 0 && masked.numActiveBands() < config.numBands);
+
+    // 100 Hz hum plus a 2 kHz tone
+    const int block = 4800;
+    std::vector<float> signal(block);
+    for (int i = 0; i < block; i++) {
+        signal[i] = 0.5f * std::sin(2.0f * M_PI * 100.0f * i / 48000.0f)
+                  + 0.5f * std::sin(2.0f * M_PI * 2000.0f * i / 48000.0f);
+    }
+
+    int humBand = 0, toneBand = 0;
+    for (int b = 0; b < config.numBands; b++) {
+        if (std::abs(full.centerHz(b) - 100.0f) < std::abs(full.centerHz(humBand) - 100.0f)) humBand = b;
+        if (std::abs(full.centerHz(b) - 2000.0f) < std::abs(full.centerHz(toneBand) - 2000.0f)) toneBand = b;
+    }
+    assert(masked.isBandRunning(humBand));
+    assert(!masked.isBandRunning(toneBand));
+
+    for (int k = 0; k < 5; k++) {
+        full.process(signal.data(), block);
+        masked.process(signal.data(), block);
+    }
+
+    // Active bands match the full bank exactly, inactive bands stay silent
+    assert(masked.envelope()[humBand] == full.envelope()[humBand]);
+    assert(masked.envelope()[toneBand] == 0.0f);
+
+    // Re-enabled bands resume and settle onto the full bank's output
+    masked.setAllBandsActive();
+    assert(masked.isBandRunning(toneBand));
+    for (int k = 0; k < 2; k++) {
+        full.process(signal.data(), block);
+        masked.process(signal.data(), block);
+    }
+    assert(approxEqual(masked.envelope()[toneBand], full.envelope()[toneBand], 0.01f));
+    assert(approxEqual(masked.envelope()[humBand], full.envelope()[humBand], 1e-4f));
+
+    std::cout << "  Band mask: PASSED (" << GammatoneFilterbank::kLanes << "-band groups)\n";
+}
+
+void testBandResume() {
+    std::cout << "Testing band resume after a freeze...\n";
+
+    const int second = 48000;
+    std::vector<float> tone(second), silence(second, 0.0f);
+    for (int i = 0; i < second; i++) {
+        tone[i] = 0.3f * std::sin(2.0f * M_PI * 1000.0f * i / 48000.0f);
+    }
+
+    for (bool hairCell : {false, true}) {
+        GammatoneFilterbank::Config config;
+        config.numBands = 40;
+        config.minHz = 50.0f;
+        config.maxHz = 8000.0f;
+        config.innerHairCell = hairCell;
+        config.adaptationLoops = hairCell ? 5 : 0;
+
+        for (int freeze : {64, 2400, 12000, second}) {
+            GammatoneFilterbank full(config);
+            GammatoneFilterbank masked(config);
+            int band = 0;
+            for (int b = 0; b < config.numBands; b++) {
+                if (std::abs(full.centerHz(b) - 1000.0f) < std::abs(full.centerHz(band) - 1000.0f)) band = b;
+            }
+
+            // Frozen through silence, a band resumes where an always-on one is
+            full.process(tone.data(), second);
+            masked.process(tone.data(), second);
+            masked.setActiveRange(50.0f, 300.0f);
+            assert(!masked.isBandRunning(band));
+            [[maybe_unused]] const float held = masked.envelope()[band];
+            full.process(silence.data(), freeze);
+            masked.process(silence.data(), freeze);
+            assert(masked.envelope()[band] == held);    // Rings out unseen
+            masked.setAllBandsActive();
+            full.process(silence.data(), 64);
+            masked.process(silence.data(), 64);
+            assert(approxEqual(masked.envelope()[band], full.envelope()[band], 0.02f * full.envelope()[band] + 1e-6f));
+
+            // Frozen while the tone goes on, it settles onto it within 0.5 s
+            masked.setActiveRange(50.0f, 300.0f);
+            full.process(tone.data(), freeze / 4);
+            masked.process(tone.data(), freeze / 4);
+            masked.setAllBandsActive();
+            full.process(tone.data(), second / 2);
+            masked.process(tone.data(), second / 2);
+            assert(approxEqual(masked.envelope()[band], full.envelope()[band], 0.01f * full.envelope()[band] + 1e-6f));
+        }
+    }
+
+    std::cout << "  Band resume: PASSED\n";
+}
+
+void testZoom() {
+    std::cout << "Testing frequency zoom...\n";
+
+    GammatoneFilterbank::Config config;
+    config.numBands = 32;
+    config.minHz = 20.0f;
+    config.maxHz = 20000.0f;
+
+    const int block = 4800;
+    std::vector<float> signal(block);
+    for (int i = 0; i < block; i++) {
+        signal[i] = 0.5f * std::sin(2.0f * M_PI * 1000.0f * i / 48000.0f);
+    }
+
+    GammatoneFilterbank fb(config);
+    fb.process(signal.data(), block);
+    const float before = *std::max_element(fb.envelope().begin(), fb.envelope().end());
+
+    // Zoom into 500..2000 Hz: bands follow generateBands for the new range
+    fb.zoom(500.0f, 2000.0f);
+    auto expected = generateBands(config.scale, config.numBands, 500.0f, 2000.0f);
+    assert(fb.numBands() == config.numBands);
+    for (int b = 0; b < config.numBands; b++) {
+        assert(approxEqual(fb.centerHz(b), expected[b].centerHz, 0.01f));
+    }
+
+    // States are carried over, so the tone does not restart from silence
+    const float after = *std::max_element(fb.envelope().begin(), fb.envelope().end());
+    assert(after > 0.5f * before);
+
+    // Once settled, the zoomed bank matches a freshly configured one
+    GammatoneFilterbank::Config zoomed = config;
+    zoomed.minHz = 500.0f;
+    zoomed.maxHz = 2000.0f;
+    GammatoneFilterbank fresh(zoomed);
+    for (int k = 0; k < 2; k++) {
+        fb.process(signal.data(), block);
+        fresh.process(signal.data(), block);
+    }
+    for (int b = 0; b < config.numBands; b++) {
+        assert(approxEqual(fb.envelope()[b], fresh.envelope()[b], 1e-3f));
+    }
+
+    std::cout << "  Zoom: PASSED (peak " << before << " -> " << after << ")\n";
+}
+
 int main() {
     std::cout << "Cortix Test Suite\n";
     std::cout << "=================\n\n";
@@ -136,6 +326,10 @@ int main() {
     testMelScale();
     testBandGeneration();
     testGammatoneFilterbank();
+    testHairCellAdaptation();
+    testBandMask();
+    testBandResume();
+    testZoom();
 
     std::cout << "\nAll tests PASSED!\n";
     return 0;
@@ -0,0 +1,230 @@
+/*
+ * Cortix - Shared-Memory Frame Ring Tests
+ */
+
+#include <cortix/shm.h>
+#include <iostream>
+#include <cmath>
+#include <cassert>
+#include <vector>
+#include <string>
+#include <sys/wait.h>
+
+using namespace cortix;
+
+Analyser::Config ringDesign() {
+    Analyser::Config config;
+    config.sampleRate = 16000.0f;
+    config.numBands = 20;
+    config.minHz = 50.0f;
+    config.maxHz = 7000.0f;
+    config.hopSize = 64;
+    return config;
+}
+
+std::vector<float> tone(int numSamples) {
+    std::vector<float> signal(numSamples);
+    for (int i = 0; i < numSamples; i++) {
+        signal[i] = 0.5f * std::sin(2.0f * static_cast<float>(M_PI) * 700.0f * i / 16000.0f);
+    }
+    return signal;
+}
+
+void testRing() {
+    std::cout << "Testing shared-memory frame ring...\n";
+
+    const std::string name = "/cortix_test_" + std::to_string(::getpid());
+    Analyser analyser(ringDesign());
+    ShmFramePublisher publisher;
+    [[maybe_unused]] const bool published = publisher.open(name, analyser, 64);
+    assert(published);
+
+    std::vector<std::vector<float>> sent;
+    analyser.setFrameCallback([&](const Analyser::Frame& frame) {
+        publisher.publish(frame);
+        sent.emplace_back(frame.envelope, frame.envelope + frame.numBands);
+    });
+
+    // Two independent readers with their own mappings
+    ShmFrameReader live, slow;
+    [[maybe_unused]] const bool liveOpened = live.open(name);
+    [[maybe_unused]] const bool slowOpened = slow.open(name);
+    assert(liveOpened && slowOpened);
+    assert(live.numBands() == 20 && live.hopSize() == 64 && live.capacity() == 64);
+    std::vector<BandInfo> bands;
+    live.bands(bands);
+    for (int b = 0; b < 20; b++) {
+        assert(bands[b].centerHz == analyser.bands()[b].centerHz);
+    }
+
+    // The live reader keeps up and sees every frame in place
+    const std::vector<float> signal = tone(64 * 200);
+    ShmFrameView view;
+    int64_t received = 0;
+    for (int block = 0; block < 200; block += 10) {
+        analyser.process(signal.data() + block * 64, 640);
+        while (live.next(view)) {
+            assert(view.sequence == static_cast<uint64_t>(received) && view.index == received);
+            assert(view.samplePosition == (received + 1) * 64);
+            assert(std::equal(view.envelope, view.envelope + 20, sent[received].begin()));
+            assert(live.valid(view));
+            received++;
+        }
+    }
+    assert(received == 200 && live.overruns() == 0);
+
+    // The slow reader was lapped: it resumes at the oldest frame left
+    std::vector<float> copy(20);
+    [[maybe_unused]] const bool lapped = slow.read(view, copy.data());
+    assert(lapped);
+    assert(slow.overruns() == 1 && slow.lostFrames() == 200 - 64);
+    assert(view.index == 200 - 64 && copy == sent[200 - 64]);
+    int64_t rest = 1;
+    while (slow.read(view, copy.data())) rest++;
+    assert(rest == 64);
+
+    // A view goes stale once its slot is reused, a capacity later
+    ShmFrameReader late;
+    [[maybe_unused]] const bool lateOpened = late.open(name);
+    assert(lateOpened);
+    late.seekToLatest();
+    [[maybe_unused]] const bool caughtUp = !late.next(view);
+    assert(caughtUp);
+    analyser.process(signal.data(), 64);
+    [[maybe_unused]] const bool newest = late.next(view);
+    assert(newest);
+    analyser.process(signal.data(), 63 * 64);
+    assert(late.valid(view));
+    analyser.process(signal.data(), 64);
+    assert(!late.valid(view));
+
+    // Band table updates are visible
+    [[maybe_unused]] const uint32_t generation = live.bandGeneration();
+    std::vector<BandInfo> zoomed = analyser.bands();
+    zoomed[0].centerHz = 123.0f;
+    publisher.setBands(zoomed.data());
+    assert(live.bandGeneration() == generation + 2);
+    live.bands(bands);
+    assert(bands[0].centerHz == 123.0f);
+
+    assert(!live.publisherClosed());
+    publisher.close();
+    assert(live.publisherClosed());
+    [[maybe_unused]] const bool reopened = ShmFrameReader().open(name);
+    assert(!reopened);
+
+    std::cout << "  Ring: PASSED (" << publisher.regionBytes() << " bytes for 64 frames)\n";
+}
+
+void testTwoProcesses() {
+    std::cout << "Testing a reader in another process...\n";
+
+    const std::string name = "/cortix_test_fork_" + std::to_string(::getpid());
+    Analyser analyser(ringDesign());
+    ShmFramePublisher publisher;
+    [[maybe_unused]] const bool published = publisher.open(name, analyser, 4096);
+    assert(published);
+    analyser.setFrameCallback([&](const Analyser::Frame& frame) { publisher.publish(frame); });
+
+    const pid_t child = ::fork();
+    if (child == 0) {
+        // Read 500 consecutive frames, then report through the exit code
+        ShmFrameReader reader;
+        if (!reader.open(name)) ::_exit(2);
+        ShmFrameView view;
+        int64_t expected = 0;
+        while (expected < 500) {
+            if (!reader.next(view)) continue;
+            if (view.index != expected || view.samplePosition != (expected + 1) * 64) ::_exit(3);
+            expected++;
+        }
+        ::_exit(reader.overruns() == 0 ? 0 : 4);
+    }
+
+    const std::vector<float> signal = tone(64 * 500);
+    for (int block = 0; block < 500; block += 5) {
+        analyser.process(signal.data() + block * 64, 5 * 64);
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    std::cout << "  Two processes: PASSED\n";
+}
+
+void testEncodedRing() {
+    std::cout << "Testing quantised frame ring...\n";
+
+    const std::string name = "/cortix_test_enc_" + std::to_string(::getpid());
+    Analyser analyser(ringDesign());
+    FrameEncoder::Config encoding;
+    encoding.precision = FrameEncoding::Uint16;
+    encoding.delta = true;
+    encoding.keyframeInterval = 8;
+    encoding.packed = true;
+    ShmFramePublisher publisher;
+    [[maybe_unused]] const bool published = publisher.open(name, analyser, 32, encoding);
+    assert(published);
+
+    std::vector<std::vector<float>> sent;
+    analyser.setFrameCallback([&](const Analyser::Frame& frame) {
+        publisher.publish(frame);
+        sent.emplace_back(frame.envelope, frame.envelope + frame.numBands);
+    });
+
+    ShmFrameReader reader;
+    [[maybe_unused]] const bool opened = reader.open(name);
+    assert(opened);
+    assert(reader.encoding() == publisher.encoding() && reader.encoding() != 0);
+
+    // In step with the publisher: every frame decodes to within 16-bit steps
+    const std::vector<float> signal = tone(64 * 300);
+    ShmFrameView view;
+    std::vector<float> envelope(20);
+    int received = 0;
+    for (int block = 0; block < 20; block++) {
+        analyser.process(signal.data() + block * 64, 64);
+        while (reader.read(view, envelope.data())) {
+            assert(view.sequence == static_cast<uint64_t>(received) && view.envelope == envelope.data());
+            assert(view.bytes < 20 * sizeof(float));
+            for (int b = 0; b < 20; b++) {
+                if (sent[received][b] > 1e-4f) assert(std::fabs(envelope[b] / sent[received][b] - 1.0f) < 1e-3f);
+            }
+            received++;
+        }
+    }
+    assert(received == 20 && reader.skippedFrames() == 0);
+
+    // Lapped: the reader resumes at the oldest frame, a delta frame, and
+    // skips to the next keyframe
+    analyser.process(signal.data() + 20 * 64, 45 * 64);
+    [[maybe_unused]] const bool lapped = reader.read(view, envelope.data());
+    assert(lapped);
+    assert(reader.overruns() > 0 && reader.skippedFrames() > 0);
+    assert(view.sequence % 8 == 0 && view.sequence > 20);
+    for (int b = 0; b < 20; b++) {
+        if (sent[view.sequence][b] > 1e-4f) assert(std::fabs(envelope[b] / sent[view.sequence][b] - 1.0f) < 1e-3f);
+    }
+
+    // 128 bands at 8 bits: slots about a third the size of float32 ones
+    ShmFramePublisher wide, plain;
+    FrameEncoder::Config compact;
+    [[maybe_unused]] const bool wideOpened = wide.open(name + "_u8", 128, 64, 16000.0f, nullptr, 1024, compact);
+    [[maybe_unused]] const bool plainOpened = plain.open(name + "_f32", 128, 64, 16000.0f, nullptr, 1024);
+    assert(wideOpened && plainOpened);
+    assert(wide.regionBytes() * 5 < plain.regionBytes() * 2);
+    std::cout << "  Quantised ring: PASSED (128 bands x 1024 frames: " << wide.regionBytes() << " bytes, float32 "
+              << plain.regionBytes() << ")\n";
+}
+
+int main() {
+    std::cout << "Cortix Shared-Memory Test Suite\n";
+    std::cout << "===============================\n\n";
+
+    testRing();
+    testEncodedRing();
+    testTwoProcesses();
+
+    std::cout << "\nAll tests PASSED!\n";
+    return 0;
+}